@@ -0,0 +1 @@
+../default_config.mk
\ No newline at end of file
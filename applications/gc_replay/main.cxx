@@ -0,0 +1,718 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Replays a timestamped GridConnect capture into a CAN hub with an OpenLCB
+ * stack attached, and reports the latency of the hub, the IfCan frame
+ * dispatcher, the event service and the datagram service.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "executor/Executor.hxx"
+#include "executor/ExecutorProfiler.hxx"
+#include "executor/Service.hxx"
+#include "openlcb/CanDefs.hxx"
+#include "openlcb/DatagramCan.hxx"
+#include "openlcb/DefaultNode.hxx"
+#include "openlcb/EventHandler.hxx"
+#include "openlcb/EventService.hxx"
+#include "openlcb/IfCan.hxx"
+#include "openlcb/NodeInitializeFlow.hxx"
+#include "openlcb/SimpleNodeInfo.hxx"
+#include "os/os.h"
+#include "utils/GcCapture.hxx"
+#include "utils/Hub.hxx"
+#include "utils/Metrics.hxx"
+#include "utils/StringPrintf.hxx"
+
+Executor<1> g_executor("g_executor", 0, 1024);
+Service g_service(&g_executor);
+CanHubFlow can_hub0(&g_service);
+
+/// The replay stack has no SNIP handler; this only satisfies the linker.
+const char *const openlcb::SNIP_DYNAMIC_FILENAME = nullptr;
+
+/// Node IDs given to the destination aliases adopted with -a.
+static const openlcb::NodeID ADOPTED_NODE_ID_BASE = 0x090099FF0000ULL;
+
+const char *input_path = nullptr;
+/// Replay speed relative to the capture; 0 means as fast as possible.
+double speed = 1;
+unsigned batch = 8;
+unsigned repeat = 1;
+bool adopt = false;
+bool print_metrics = false;
+bool profile = false;
+
+void usage(const char *e)
+{
+    fprintf(stderr, "Usage: %s [-s speed | -f] [-b batch] [-n repeat] [-a] "
+                    "[-m] [-p] [capture_file]\n\n",
+            e);
+    fprintf(stderr, "Replays a GridConnect capture (as written by the hub "
+                    "with -t) into a CAN hub with an OpenLCB stack attached, "
+                    "and reports per-stage latency histograms and the "
+                    "achieved frame rate.\nReads from standard input if no "
+                    "capture_file is given.\n\nArguments:\n");
+    fprintf(stderr, "\t-s speed   replays at speed times the original rate, "
+                    "following the capture's timestamps. Default 1.\n");
+    fprintf(stderr, "\t-f         replays as fast as possible: injects batch "
+                    "frames, then waits for the stack to become idle.\n");
+    fprintf(stderr, "\t-b batch   maximum number of frames injected before "
+                    "yielding to the stack. Default 8.\n");
+    fprintf(stderr, "\t-n repeat  replays the capture this many times.\n");
+    fprintf(stderr, "\t-a         adopts the destination aliases of addressed "
+                    "messages and datagrams as local nodes, so that these "
+                    "reach the datagram service. Frames sent by an adopted "
+                    "alias are skipped.\n");
+    fprintf(stderr, "\t-m         prints all registered metrics at the end.\n");
+    fprintf(stderr, "\t-p         profiles the executor and prints the "
+                    "busiest executables at the end.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hs:fb:n:amp")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 's':
+                speed = atof(optarg);
+                break;
+            case 'f':
+                speed = 0;
+                break;
+            case 'b':
+                batch = atoi(optarg);
+                break;
+            case 'n':
+                repeat = atoi(optarg);
+                break;
+            case 'a':
+                adopt = true;
+                break;
+            case 'm':
+                print_metrics = true;
+                break;
+            case 'p':
+                profile = true;
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (optind < argc)
+    {
+        input_path = argv[optind];
+    }
+    if (speed < 0 || batch == 0 || repeat == 0)
+    {
+        usage(argv[0]);
+    }
+}
+
+/// Upper bounds of the latency histogram buckets in microseconds.
+static const uint32_t LATENCY_BOUNDS_USEC[] = {1, 2, 5, 10, 20, 50, 100, 200,
+    500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000,
+    1000000};
+
+/// Latency statistics of one stage of the stack.
+class StageStats
+{
+public:
+    /// Constructor. @param name is printed in the report and used for the
+    /// metric name.
+    StageStats(const char *name)
+        : name_(name)
+        , hist_(LATENCY_BOUNDS_USEC, ARRAYSIZE(LATENCY_BOUNDS_USEC))
+    {
+        MetricsRegistry::instance()->add(
+            this, std::string("replay.") + name, &hist_);
+    }
+
+    ~StageStats()
+    {
+        MetricsRegistry::instance()->remove(this);
+    }
+
+    /// Adds a sample. @param nsec is the latency in nanoseconds.
+    void add(long long nsec)
+    {
+        uint32_t usec = nsec < 0 ? 0 : std::min(nsec / 1000, 0xFFFFFFFFLL);
+        hist_.add(usec);
+        maxUsec_ = std::max(maxUsec_, usec);
+    }
+
+    /// @return a percentile (0..100) of the latency in usec, rounded up to
+    /// the bucket bound but never above the largest sample.
+    uint32_t percentile(unsigned pct)
+    {
+        return std::min(hist_.percentile(pct), maxUsec_);
+    }
+
+    /// Prints one line of the report.
+    void print()
+    {
+        unsigned count = hist_.value();
+        if (!count)
+        {
+            printf("%-10s %10u\n", name_, 0u);
+            return;
+        }
+        printf("%-10s %10u %10.1f %10u %10u %10u %10u\n", name_, count,
+            (double)hist_.sum() / count, (unsigned)percentile(50),
+            (unsigned)percentile(90), (unsigned)percentile(99),
+            (unsigned)maxUsec_);
+    }
+
+private:
+    /// Name of the stage.
+    const char *name_;
+    /// Latency distribution in usec.
+    HistogramMetricT<true> hist_;
+    /// Largest sample seen.
+    uint32_t maxUsec_ {0};
+};
+
+/// Injection time of a frame that has not yet reached a tap.
+struct PendingFrame
+{
+    /// CAN identifier of the injected frame.
+    uint32_t id;
+    /// os_get_time_monotonic() at injection.
+    long long time;
+};
+
+/// State shared between the injector and the taps. Only accessed from
+/// g_executor.
+struct ReplayState
+{
+    /// Frames that have not yet passed the hub tap, in injection order.
+    std::deque<PendingFrame> hubPending;
+    /// Frames that have not yet passed the frame dispatcher tap.
+    std::deque<PendingFrame> dispatchPending;
+    /// Last injection time of a frame by each source alias.
+    long long lastBySrc[4096] = {0};
+
+    StageStats hub {"hub"};
+    StageStats dispatch {"ifcan"};
+    StageStats event {"event"};
+    StageStats datagram {"datagram"};
+
+    /// Number of frames that the stack sent to the bus.
+    unsigned generated = 0;
+};
+
+ReplayState g_state;
+
+/// Port that stands for the replayed bus. Frames sent by the stack arrive
+/// here and are dropped.
+class InjectorPort : public CanHubPortInterface
+{
+public:
+    void send(Buffer<CanHubData> *message, unsigned priority) override
+    {
+        message->unref();
+    }
+};
+
+/// Source of all injected frames.
+InjectorPort g_injector;
+
+/// Hub port that measures how long injected frames take to get through the
+/// hub.
+class HubTap : public CanHubPortInterface
+{
+public:
+    HubTap()
+    {
+        can_hub0.register_port(this);
+    }
+
+    ~HubTap()
+    {
+        can_hub0.unregister_port(this);
+    }
+
+    void send(Buffer<CanHubData> *message, unsigned priority) override
+    {
+        if (message->data()->skipMember_ == &g_injector &&
+            !g_state.hubPending.empty())
+        {
+            g_state.hub.add(
+                os_get_time_monotonic() - g_state.hubPending.front().time);
+            g_state.hubPending.pop_front();
+        }
+        else
+        {
+            ++g_state.generated;
+        }
+        message->unref();
+    }
+};
+
+/// Frame handler that measures how long injected frames take to reach the
+/// IfCan frame dispatcher.
+class FrameTap : public IncomingFrameHandler
+{
+public:
+    void send(Buffer<CanMessageData> *message, unsigned priority) override
+    {
+        uint32_t id = GET_CAN_FRAME_ID_EFF(*message->data());
+        // Frames of the stack itself do not loop back, but be defensive.
+        if (!g_state.dispatchPending.empty() &&
+            g_state.dispatchPending.front().id == id)
+        {
+            g_state.dispatch.add(os_get_time_monotonic() -
+                g_state.dispatchPending.front().time);
+            g_state.dispatchPending.pop_front();
+        }
+        message->unref();
+    }
+};
+
+/// Event handler registered for all events that measures how long it takes
+/// for event messages to reach the handlers. Latency is measured from the
+/// last frame injected by the sending alias.
+class EventTap : public openlcb::EventHandler
+{
+public:
+    EventTap()
+    {
+        openlcb::EventRegistry::instance()->register_handler(
+            openlcb::EventRegistryEntry(this, 0), 64);
+    }
+
+    ~EventTap()
+    {
+        openlcb::EventRegistry::instance()->unregister_handler(this);
+    }
+
+    void handle_event_report(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        record(event, done);
+    }
+
+    void handle_consumer_identified(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        record(event, done);
+    }
+
+    void handle_producer_identified(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        record(event, done);
+    }
+
+    void handle_identify_global(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        done->notify();
+    }
+
+    void handle_identify_consumer(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        record(event, done);
+    }
+
+    void handle_identify_producer(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        record(event, done);
+    }
+
+private:
+    /// Records the latency of an incoming event message.
+    void record(EventReport *event, BarrierNotifiable *done)
+    {
+        g_state.event.add(os_get_time_monotonic() -
+            g_state.lastBySrc[event->src_node.alias & 0xFFF]);
+        done->notify();
+    }
+};
+
+/// Datagram handler registered for all datagram IDs that measures how long it
+/// takes for datagrams to be reassembled and dispatched. Latency is measured
+/// from the last frame injected by the sending alias.
+class DatagramTap : public openlcb::DatagramHandler
+{
+public:
+    /// @param service is the datagram service to register with.
+    DatagramTap(openlcb::DatagramService *service)
+        : service_(service)
+    {
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            service_->registry()->insert(nullptr, i, this);
+        }
+    }
+
+    ~DatagramTap()
+    {
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            service_->registry()->erase(nullptr, i, this);
+        }
+    }
+
+    void send(Buffer<openlcb::IncomingDatagram> *message,
+        unsigned priority) override
+    {
+        g_state.datagram.add(os_get_time_monotonic() -
+            g_state.lastBySrc[message->data()->src.alias & 0xFFF]);
+        message->unref();
+    }
+
+private:
+    openlcb::DatagramService *service_;
+};
+
+/// Feeds the capture into the hub, either following the capture's timing or
+/// as fast as the stack can process it.
+class ReplayFlow : public StateFlowBase
+{
+public:
+    /// @param frames is the capture to replay.
+    /// @param skip_src marks the source aliases whose frames are not
+    /// replayed; 4096 entries.
+    /// @param done will be notified when the replay is complete.
+    ReplayFlow(const std::vector<GcCaptureFrame> *frames,
+        const std::vector<bool> *skip_src, Notifiable *done)
+        : StateFlowBase(&g_service)
+        , frames_(frames)
+        , skipSrc_(skip_src)
+        , done_(done)
+    {
+        can_hub0.register_port(&g_injector);
+        start_flow(STATE(start_round));
+    }
+
+    ~ReplayFlow()
+    {
+        can_hub0.unregister_port(&g_injector);
+    }
+
+    /// @return number of frames injected.
+    unsigned injected()
+    {
+        return injected_;
+    }
+
+    /// @return number of frames skipped due to -a.
+    unsigned skipped()
+    {
+        return skipped_;
+    }
+
+    /// @return time from the first injection to the stack becoming idle after
+    /// the last one, in nsec.
+    long long elapsed_nsec()
+    {
+        return endTime_ - startTime_;
+    }
+
+private:
+    Action start_round()
+    {
+        if (round_ == 0)
+        {
+            startTime_ = os_get_time_monotonic();
+        }
+        if (round_ >= repeat)
+        {
+            return call_immediately(STATE(wait_idle));
+        }
+        ++round_;
+        next_ = 0;
+        roundStart_ = os_get_time_monotonic();
+        return call_immediately(STATE(inject));
+    }
+
+    Action inject()
+    {
+        for (unsigned n = 0; n < batch; ++n)
+        {
+            if (next_ >= frames_->size())
+            {
+                return yield_and_call(STATE(start_round));
+            }
+            const GcCaptureFrame &f = (*frames_)[next_];
+            long long now = os_get_time_monotonic();
+            if (speed > 0)
+            {
+                long long due = roundStart_ +
+                    (long long)((f.timeNsec - (*frames_)[0].timeNsec) / speed);
+                if (due > now)
+                {
+                    if (n == 0)
+                    {
+                        return sleep_and_call(
+                            &timer_, due - now, STATE(inject));
+                    }
+                    break;
+                }
+            }
+            ++next_;
+            uint32_t id = GET_CAN_FRAME_ID_EFF(f.frame);
+            unsigned src = openlcb::CanDefs::get_src(id);
+            if (IS_CAN_FRAME_EFF(f.frame) && (*skipSrc_)[src])
+            {
+                ++skipped_;
+                continue;
+            }
+            auto *b = can_hub0.alloc();
+            *b->data()->mutable_frame() = f.frame;
+            b->data()->skipMember_ = &g_injector;
+            g_state.hubPending.push_back({id, now});
+            g_state.dispatchPending.push_back({id, now});
+            g_state.lastBySrc[src] = now;
+            ++injected_;
+            can_hub0.send(b);
+        }
+        if (speed > 0)
+        {
+            return yield_and_call(STATE(inject));
+        }
+        return yield_and_call(STATE(wait_batch));
+    }
+
+    /// Waits for the executor to run out of work before injecting the next
+    /// batch.
+    Action wait_batch()
+    {
+        if (!service()->executor()->empty())
+        {
+            return yield_and_call(STATE(wait_batch));
+        }
+        return call_immediately(STATE(inject));
+    }
+
+    Action wait_idle()
+    {
+        if (!service()->executor()->empty())
+        {
+            return yield_and_call(STATE(wait_idle));
+        }
+        endTime_ = os_get_time_monotonic();
+        done_->notify();
+        return exit();
+    }
+
+    const std::vector<GcCaptureFrame> *frames_;
+    const std::vector<bool> *skipSrc_;
+    Notifiable *done_;
+    StateFlowTimer timer_ {this};
+    /// Index of the next frame to inject.
+    size_t next_ {0};
+    /// Number of rounds started.
+    unsigned round_ {0};
+    long long startTime_ {0};
+    long long roundStart_ {0};
+    long long endTime_ {0};
+    unsigned injected_ {0};
+    unsigned skipped_ {0};
+};
+
+/// Collects the destination aliases of addressed messages and datagrams.
+/// @param frames is the capture. @param aliases is filled with 4096 entries,
+/// true for every destination alias.
+void find_destinations(
+    const std::vector<GcCaptureFrame> &frames, std::vector<bool> *aliases)
+{
+    using openlcb::CanDefs;
+    for (const auto &f : frames)
+    {
+        if (!IS_CAN_FRAME_EFF(f.frame))
+        {
+            continue;
+        }
+        uint32_t id = GET_CAN_FRAME_ID_EFF(f.frame);
+        if (CanDefs::get_frame_type(id) != CanDefs::NMRANET_MSG)
+        {
+            continue;
+        }
+        unsigned dst = 0;
+        auto type = CanDefs::get_can_frame_type(id);
+        if (type >= CanDefs::DATAGRAM_ONE_FRAME &&
+            type <= CanDefs::DATAGRAM_FINAL_FRAME)
+        {
+            dst = CanDefs::get_dst(id);
+        }
+        else if (type == CanDefs::GLOBAL_ADDRESSED &&
+            (CanDefs::get_mti(id) & openlcb::Defs::MTI_ADDRESS_MASK) &&
+            f.frame.can_dlc >= 2)
+        {
+            dst = ((f.frame.data[0] & 0xF) << 8) | f.frame.data[1];
+        }
+        if (dst)
+        {
+            (*aliases)[dst] = true;
+        }
+    }
+}
+
+/**
+ * The application entry point.
+ *
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ *
+ * @return 0, should never return
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+    FILE *f = stdin;
+    if (input_path)
+    {
+        f = fopen(input_path, "r");
+        if (!f)
+        {
+            perror(input_path);
+            return 1;
+        }
+    }
+    std::vector<GcCaptureFrame> frames;
+    unsigned errors = 0;
+    gc_capture_read(f, &frames, &errors);
+    if (f != stdin)
+    {
+        fclose(f);
+    }
+    if (frames.empty())
+    {
+        fprintf(stderr, "No frames in the capture.\n");
+        return 1;
+    }
+
+    std::vector<bool> adopted(4096, false);
+    unsigned num_adopted = 0;
+    if (adopt)
+    {
+        find_destinations(frames, &adopted);
+        for (bool a : adopted)
+        {
+            num_adopted += a;
+        }
+    }
+
+    // The stack is never destroyed, because the executor thread keeps running
+    // until the process exits.
+    auto *iface = new openlcb::IfCan(
+        &g_executor, &can_hub0, num_adopted + 10, 1024, num_adopted + 1);
+    iface->add_addressed_message_support();
+    new openlcb::EventService(iface);
+    auto *datagram_service = new openlcb::CanDatagramService(iface, 256, 2);
+    new openlcb::InitializeFlow(&g_service);
+    for (unsigned alias = 1; alias < adopted.size(); ++alias)
+    {
+        if (adopted[alias])
+        {
+            openlcb::NodeID id = ADOPTED_NODE_ID_BASE | alias;
+            iface->local_aliases()->add(id, alias);
+            new openlcb::DefaultNode(iface, id);
+        }
+    }
+    if (profile)
+    {
+        g_executor.enable_profiling(true);
+    }
+
+    new HubTap();
+    iface->frame_dispatcher()->register_handler(new FrameTap(), 0, 0);
+    new EventTap();
+    new DatagramTap(datagram_service);
+
+    SyncNotifiable done;
+    ReplayFlow flow(&frames, &adopted, &done);
+    done.wait_for_notification();
+
+    double sec = flow.elapsed_nsec() / 1e9;
+    double capture_sec =
+        (frames.back().timeNsec - frames.front().timeNsec) / 1e9;
+    printf("Replayed %u frames (%u skipped, %u parse errors) in %.3f s: "
+           "%.0f frames/sec\n",
+        flow.injected(), flow.skipped(), errors, sec,
+        sec > 0 ? flow.injected() / sec : 0.0);
+    if (speed > 0)
+    {
+        printf("Capture length %.3f s, replayed at %gx, %u time(s).\n",
+            capture_sec, speed, repeat);
+    }
+    else
+    {
+        printf("Capture length %.3f s, replayed as fast as possible in "
+               "batches of %u, %u time(s).\n",
+            capture_sec, batch, repeat);
+    }
+    if (adopt)
+    {
+        printf("Adopted %u destination aliases.\n", num_adopted);
+    }
+    printf("The stack sent %u frames.\n\n", g_state.generated);
+    printf("%-10s %10s %10s %10s %10s %10s %10s\n", "latency", "count",
+        "mean_usec", "p50_usec", "p90_usec", "p99_usec", "max_usec");
+    g_state.hub.print();
+    g_state.dispatch.print();
+    g_state.event.print();
+    g_state.datagram.print();
+
+    if (print_metrics)
+    {
+        std::string m;
+        MetricsRegistry::instance()->render(&m, "");
+        printf("\n%s", m.c_str());
+    }
+    if (profile)
+    {
+        printf("\n");
+        g_executor.profiler()->print(stdout, 10);
+    }
+    return 0;
+}
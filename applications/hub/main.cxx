@@ -38,12 +38,15 @@
 #include <unistd.h>
 
 #include <memory>
+#include <string.h>
 
 #include "os/os.h"
 #include "utils/constants.hxx"
 #include "utils/Hub.hxx"
 #include "utils/GcTcpHub.hxx"
+#include "utils/HubPortLimit.hxx"
 #include "utils/ClientConnection.hxx"
+#include "utils/Metrics.hxx"
 #include "executor/Executor.hxx"
 #include "executor/Service.hxx"
 
@@ -63,11 +66,17 @@ const char *upstream_host = nullptr;
 bool timestamped = false;
 bool export_mdns = false;
 const char* mdns_name = "openmrn_hub";
+int metrics_period_sec = 0;
+int num_shards = 1;
+int queue_limit = 0;
+HubPortOverflow overflow_policy = HubPortOverflow::DROP_OLDEST;
+bool accept_binary = false;
 
 void usage(const char *e)
 {
     fprintf(stderr, "Usage: %s [-p port] [-d device_path] [-u upstream_host] "
-                    "[-q upstream_port] [-m] [-n mdns_name] [-t]\n\n",
+                    "[-q upstream_port] [-m] [-n mdns_name] [-t] [-s seconds] "
+                    "[-j threads] [-l queue_limit] [-o policy] [-b]\n\n",
             e);
     fprintf(stderr, "GridConnect CAN HUB.\nListens to a specific TCP port, "
                     "reads CAN packets from the incoming connections using "
@@ -85,6 +94,30 @@ void usage(const char *e)
             "\t-q upstream_port   is the port number for the upstream hub.\n");
     fprintf(stderr,
             "\t-t prints timestamps for each packet.\n");
+    fprintf(stderr,
+            "\t-s seconds   prints the hub metrics to stderr with this "
+            "period.\n");
+    fprintf(stderr,
+            "\t-j threads   distributes the TCP connections over this many "
+            "threads. Each thread does the socket IO and GridConnect "
+            "conversion of its connections; only binary frames go through "
+            "the central hub thread. Default 1: every connection has its own "
+            "reader and writer thread, and the conversion runs on the "
+            "central hub thread.\n");
+    fprintf(stderr,
+            "\t-l queue_limit   is the number of buffers waiting to be sent "
+            "to a TCP client at which the overflow policy kicks in. 0 for "
+            "unlimited. Default 0.\n");
+    fprintf(stderr,
+            "\t-o policy   is what happens to a TCP client that does not "
+            "keep up with the traffic once the queue limit is reached: "
+            "'drop_oldest' discards the oldest queued data (default), "
+            "'drop_priority' discards all but the CAN control frames until "
+            "the queue drains, 'disconnect' closes the connection.\n");
+    fprintf(stderr,
+            "\t-b accepts the binary CAN stream format. TCP clients that "
+            "open the connection with the binary CAN hello are switched to "
+            "binary frames. Off by default.\n");
 #ifdef HAVE_AVAHI_CLIENT
     fprintf(stderr,
             "\t-m exports the current service on mDNS.\n");
@@ -97,7 +130,7 @@ void usage(const char *e)
 void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hp:d:u:q:tmn:")) >= 0)
+    while ((opt = getopt(argc, argv, "hp:d:u:q:tmn:s:j:l:o:b")) >= 0)
     {
         switch (opt)
         {
@@ -126,6 +159,40 @@ void parse_args(int argc, char *argv[])
                 mdns_name = optarg;
                 export_mdns = true;
                 break;
+            case 's':
+                metrics_period_sec = atoi(optarg);
+                break;
+            case 'j':
+                num_shards = atoi(optarg);
+                if (num_shards < 1)
+                {
+                    usage(argv[0]);
+                }
+                break;
+            case 'l':
+                queue_limit = atoi(optarg);
+                break;
+            case 'o':
+                if (!strcmp(optarg, "disconnect"))
+                {
+                    overflow_policy = HubPortOverflow::DISCONNECT;
+                }
+                else if (!strcmp(optarg, "drop_oldest"))
+                {
+                    overflow_policy = HubPortOverflow::DROP_OLDEST;
+                }
+                else if (!strcmp(optarg, "drop_priority"))
+                {
+                    overflow_policy = HubPortOverflow::DROP_BY_PRIORITY;
+                }
+                else
+                {
+                    usage(argv[0]);
+                }
+                break;
+            case 'b':
+                accept_binary = true;
+                break;
             default:
                 fprintf(stderr, "Unknown option %c\n", opt);
                 usage(argv[0]);
@@ -141,8 +208,32 @@ void parse_args(int argc, char *argv[])
 int appl_main(int argc, char *argv[])
 {
     parse_args(argc, argv);
+    g_executor.register_metrics("executor");
+    can_hub0.register_metrics("hub.can");
     GcPacketPrinter packet_printer(&can_hub0, timestamped);
-    GcTcpHub hub(&can_hub0, port);
+    vector<Service *> shards;
+    if (num_shards > 1)
+    {
+        for (int i = 0; i < num_shards; ++i)
+        {
+            // These live as long as the process does.
+            auto *e = new Executor<1>("shard", 0, 1024);
+            char prefix[32];
+            snprintf(prefix, sizeof(prefix), "executor.shard%d", i);
+            e->register_metrics(prefix);
+            shards.push_back(new Service(e));
+        }
+    }
+    HubPortStats tcp_stats;
+    tcp_stats.register_metrics("hub.tcp");
+    HubPortLimits limits;
+    if (queue_limit > 0)
+    {
+        limits = HubPortLimits(
+            overflow_policy, queue_limit, queue_limit / 2, &tcp_stats);
+    }
+    GcTcpHub hub(&can_hub0, port, shards, limits);
+    hub.set_accept_binary(accept_binary);
     vector<std::unique_ptr<ConnectionClient>> connections;
 
 #ifdef HAVE_AVAHI_CLIENT
@@ -167,6 +258,7 @@ int appl_main(int argc, char *argv[])
             new DeviceConnectionClient("device", &can_hub0, device_path));
     }
 
+    int seconds = 0;
     while (1)
     {
         for (const auto &p : connections)
@@ -174,6 +266,13 @@ int appl_main(int argc, char *argv[])
             p->ping();
         }
         sleep(1);
+        if (metrics_period_sec > 0 && ++seconds >= metrics_period_sec)
+        {
+            seconds = 0;
+            string m;
+            MetricsRegistry::instance()->render(&m);
+            fprintf(stderr, "%s\n", m.c_str());
+        }
     }
     return 0;
 }
@@ -0,0 +1,1274 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Load generator: simulates a swarm of virtual OpenLCB nodes connected to a
+ * GridConnect TCP hub, runs a configurable mix of traffic between them, and
+ * reports throughput and latency percentiles.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "executor/Executor.hxx"
+#include "executor/Service.hxx"
+#include "openlcb/AliasAllocator.hxx"
+#include "openlcb/DatagramCan.hxx"
+#include "openlcb/DatagramHandlerDefault.hxx"
+#include "openlcb/DefaultNode.hxx"
+#include "openlcb/EventHandlerTemplates.hxx"
+#include "openlcb/EventService.hxx"
+#include "openlcb/IfCan.hxx"
+#include "openlcb/MemoryConfig.hxx"
+#include "openlcb/NodeInitializeFlow.hxx"
+#include "openlcb/SimpleNodeInfo.hxx"
+#include "openlcb/TractionDefs.hxx"
+#include "openlcb/TractionTestTrain.hxx"
+#include "openlcb/TractionTrain.hxx"
+#include "os/OS.hxx"
+#include "os/os.h"
+#include "utils/BinaryCanStream.hxx"
+#include "utils/GcTcpHub.hxx"
+#include "utils/GridConnectHub.hxx"
+#include "utils/Hub.hxx"
+#include "utils/Metrics.hxx"
+#include "utils/StringPrintf.hxx"
+#include "utils/socket_listener.hxx"
+
+Executor<1> g_executor("g_executor", 0, 1024);
+Service g_service(&g_executor);
+CanHubFlow can_hub0(&g_service);
+
+OVERRIDE_CONST_TRUE(gridconnect_tcp_accept_binary);
+
+/// The swarm nodes have no SNIP handler; this only satisfies the linker.
+const char *const openlcb::SNIP_DYNAMIC_FILENAME = nullptr;
+
+using openlcb::Defs;
+using openlcb::EventId;
+using openlcb::NodeHandle;
+using openlcb::NodeID;
+
+/// Node ID of the swarm node with index 0.
+static const NodeID NODE_ID_BASE = 0x090099EE0000ULL;
+/// Node ID of the train node with index 0.
+static const NodeID TRAIN_NODE_ID_BASE = 0x090099EF0000ULL;
+/// Events produced by the swarm are EVENT_BASE | node << 16 | index.
+static const EventId EVENT_BASE = 0x0901990000000000ULL;
+/// Memory space the configuration reads are sent to. This is below 0xFD so
+/// that the replies use the plain read reply command, which is what
+/// MemoryConfigHandler forwards to its client.
+static const uint8_t READ_SPACE = 0xEF;
+/// Number of bytes in each configuration read.
+static const unsigned READ_LENGTH = 8;
+/// Maximum number of configuration reads in flight in the whole swarm.
+static const unsigned MAX_READ_SLOTS = 512;
+/// A configuration read without a response for this long is counted as
+/// timed out.
+static const long long READ_TIMEOUT_NSEC = SEC_TO_NSEC(5);
+
+int port = 12021;
+const char *upstream_host = nullptr;
+int upstream_port = 12021;
+unsigned num_nodes = 100;
+unsigned num_workers = 4;
+unsigned events_per_node = 4;
+unsigned num_trains = 0;
+unsigned duration_sec = 10;
+unsigned reads_in_flight = 8;
+double pcer_rate = 1000;
+double identify_rate = 0;
+double read_rate = 0;
+double traction_rate = 0;
+bool print_metrics = false;
+bool binary_stream = false;
+
+void usage(const char *e)
+{
+    fprintf(stderr, "Usage: %s [-n nodes] [-e events] [-t trains] "
+                    "[-w threads] [-d seconds] [-E rate] [-I rate] [-R rate] "
+                    "[-T rate] [-c reads] [-p port | -u host [-q port]] [-b] "
+                    "[-m]"
+                    "\n\n",
+            e);
+    fprintf(stderr, "OpenLCB load generator. Simulates a swarm of virtual "
+                    "nodes connected to a GridConnect TCP hub, sends a mix of "
+                    "traffic between them and reports throughput and "
+                    "latency.\n\nArguments:\n");
+    fprintf(stderr, "\t-n nodes    number of virtual nodes. Default 100.\n");
+    fprintf(stderr, "\t-e events   number of events each node produces and "
+                    "consumes. Node i consumes the events of node i+1. "
+                    "Default 4.\n");
+    fprintf(stderr, "\t-t trains   number of virtual train nodes. Default "
+                    "0.\n");
+    fprintf(stderr, "\t-w threads  number of worker threads; each has its own "
+                    "executor, interface and hub connection. Default 4.\n");
+    fprintf(stderr, "\t-d seconds  length of the traffic phase. Default "
+                    "10.\n");
+    fprintf(stderr, "\t-E rate     event reports (PCER) per second. Default "
+                    "1000.\n");
+    fprintf(stderr, "\t-I rate     Identify Events (global) per second. Each "
+                    "one makes every node identify all of its events.\n");
+    fprintf(stderr, "\t-R rate     configuration memory reads (datagrams) per "
+                    "second. The nodes of the first half of the threads "
+                    "read the nodes of the second half; needs at least two "
+                    "threads.\n");
+    fprintf(stderr, "\t-T rate     traction set speed commands per second; "
+                    "needs -t.\n");
+    fprintf(stderr, "\t-c reads    maximum configuration reads in flight per "
+                    "thread. Default 8.\n");
+    fprintf(stderr, "\t-p port     port of the built-in hub the swarm "
+                    "connects to if -u is not given. Default 12021.\n");
+    fprintf(stderr, "\t-u host     connects to an external hub instead.\n");
+    fprintf(stderr, "\t-q port     port of the external hub. Default "
+                    "12021.\n");
+    fprintf(stderr, "\t-b          the threads switch their hub connection "
+                    "to the binary CAN stream format instead of "
+                    "GridConnect. An external hub has to be started with "
+                    "-b.\n");
+    fprintf(stderr, "\t-m          prints all registered metrics at the "
+                    "end.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:e:t:w:d:E:I:R:T:c:p:u:q:bm")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 'n':
+                num_nodes = atoi(optarg);
+                break;
+            case 'e':
+                events_per_node = atoi(optarg);
+                break;
+            case 't':
+                num_trains = atoi(optarg);
+                break;
+            case 'w':
+                num_workers = atoi(optarg);
+                break;
+            case 'd':
+                duration_sec = atoi(optarg);
+                break;
+            case 'E':
+                pcer_rate = atof(optarg);
+                break;
+            case 'I':
+                identify_rate = atof(optarg);
+                break;
+            case 'R':
+                read_rate = atof(optarg);
+                break;
+            case 'T':
+                traction_rate = atof(optarg);
+                break;
+            case 'c':
+                reads_in_flight = atoi(optarg);
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'u':
+                upstream_host = optarg;
+                break;
+            case 'q':
+                upstream_port = atoi(optarg);
+                break;
+            case 'b':
+                binary_stream = true;
+                break;
+            case 'm':
+                print_metrics = true;
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (num_nodes == 0 || num_nodes > 0xFFFF || events_per_node == 0 ||
+        events_per_node > 0xFFFF || num_workers == 0 || reads_in_flight == 0 ||
+        reads_in_flight * num_workers > MAX_READ_SLOTS ||
+        (read_rate > 0 && num_workers < 2) ||
+        (traction_rate > 0 && num_trains == 0))
+    {
+        usage(argv[0]);
+    }
+}
+
+/// Upper bounds of the latency histogram buckets in microseconds.
+static const uint32_t LATENCY_BOUNDS_USEC[] = {10, 20, 50, 100, 200, 500,
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000,
+    2000000, 5000000};
+
+/// Counters and latency distribution of one kind of traffic. Samples are
+/// added from all worker threads.
+class LatencyStats
+{
+public:
+    /// Constructor. @param name is printed in the report and used for the
+    /// metric name.
+    LatencyStats(const char *name)
+        : name_(name)
+        , hist_(LATENCY_BOUNDS_USEC, ARRAYSIZE(LATENCY_BOUNDS_USEC))
+    {
+        MetricsRegistry::instance()->add(
+            this, std::string("load.") + name, &hist_);
+    }
+
+    ~LatencyStats()
+    {
+        MetricsRegistry::instance()->remove(this);
+    }
+
+    /// Counts an outgoing request.
+    void sent()
+    {
+        ++sent_;
+    }
+
+    /// Counts a request that failed or timed out.
+    void failed()
+    {
+        ++failed_;
+    }
+
+    /// Adds a latency sample. @param nsec is the latency in nanoseconds.
+    void add(long long nsec)
+    {
+        uint32_t usec = nsec < 0 ? 0 : std::min(nsec / 1000, 0xFFFFFFFFLL);
+        OSMutexLock l(&lock_);
+        hist_.add(usec);
+        maxUsec_ = std::max(maxUsec_, usec);
+    }
+
+    /// Prints one line of the report. @param sec is the length of the
+    /// measurement in seconds.
+    void print(double sec)
+    {
+        OSMutexLock l(&lock_);
+        unsigned count = hist_.value();
+        printf("%-10s %9u %9u %7u %9.0f", name_, (unsigned)sent_,
+            count, (unsigned)failed_, count / sec);
+        if (count)
+        {
+            printf(" %9.0f %9u %9u %9u %9u",
+                (double)hist_.sum() / count, percentile(50), percentile(90),
+                percentile(99), (unsigned)maxUsec_);
+        }
+        printf("\n");
+    }
+
+private:
+    /// @return a percentile of the latency in usec, never above the largest
+    /// sample. @param pct is the percentile, 0..100.
+    unsigned percentile(unsigned pct)
+    {
+        return std::min(hist_.percentile(pct), maxUsec_);
+    }
+
+    /// Name of the traffic kind.
+    const char *name_;
+    /// Protects hist_ and maxUsec_.
+    OSMutex lock_;
+    /// Latency distribution in usec.
+    HistogramMetricT<true> hist_;
+    /// Largest sample seen.
+    uint32_t maxUsec_ {0};
+    /// Number of requests sent.
+    std::atomic<unsigned> sent_ {0};
+    /// Number of failed requests.
+    std::atomic<unsigned> failed_ {0};
+};
+
+LatencyStats g_pcer("pcer");
+LatencyStats g_identify("identify");
+LatencyStats g_read("read");
+LatencyStats g_traction("traction");
+
+/// Send times of the outstanding traffic, os_get_time_monotonic() or 0.
+struct SendTimes
+{
+    /// Indexed by node * events_per_node + event.
+    std::vector<std::atomic<long long>> pcer;
+    /// Indexed by read slot.
+    std::vector<std::atomic<long long>> read;
+    /// Indexed by train.
+    std::vector<std::atomic<long long>> traction;
+    /// Last Identify Events (global) sent.
+    std::atomic<long long> identify {0};
+};
+
+SendTimes *g_times = nullptr;
+
+/// True while the traffic phase is running.
+std::atomic<bool> g_running {false};
+
+/// Backing storage of the memory space the configuration reads go to. Each
+/// read slot reads its own READ_LENGTH bytes, so the reply identifies the
+/// request.
+static const uint8_t g_config_data[MAX_READ_SLOTS * READ_LENGTH] = {0};
+
+/// @return the event ID the given node produces. @param node is the node
+/// index. @param i is the event index within the node.
+static EventId node_event(unsigned node, unsigned i)
+{
+    return EVENT_BASE | ((uint64_t)node << 16) | i;
+}
+
+/// Event handler of one swarm node. Produces events_per_node events, and
+/// consumes the events of the next node.
+///
+/// There is only one event registry in the process, so every worker's
+/// interface delivers every event message to every handler. The handler only
+/// acts on the messages arriving on its own node's interface, i.e. on its
+/// own worker thread.
+class SwarmEventHandler : public openlcb::SimpleEventHandler
+{
+public:
+    /// Constructor. @param node is the virtual node owning the events.
+    /// @param index is the node's index in the swarm.
+    SwarmEventHandler(openlcb::Node *node, unsigned index)
+        : node_(node)
+    {
+        unsigned next = (index + 1) % num_nodes;
+        for (unsigned i = 0; i < events_per_node; ++i)
+        {
+            openlcb::EventRegistry::instance()->register_handler(
+                openlcb::EventRegistryEntry(
+                    this, node_event(index, i), IS_PRODUCER),
+                0);
+            if (next != index)
+            {
+                openlcb::EventRegistry::instance()->register_handler(
+                    openlcb::EventRegistryEntry(
+                        this, node_event(next, i), IS_CONSUMER),
+                    0);
+            }
+        }
+    }
+
+    ~SwarmEventHandler()
+    {
+        openlcb::EventRegistry::instance()->unregister_handler(this);
+    }
+
+    void handle_event_report(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        if ((entry.user_arg & IS_CONSUMER) && on_own_thread())
+        {
+            unsigned node = (entry.event >> 16) & 0xFFFF;
+            unsigned i = entry.event & 0xFFFF;
+            long long t = g_times->pcer[node * events_per_node + i];
+            if (t)
+            {
+                g_pcer.add(os_get_time_monotonic() - t);
+            }
+        }
+        done->notify();
+    }
+
+    void handle_producer_identified(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        long long t = g_times->identify;
+        if ((entry.user_arg & IS_CONSUMER) && t && on_own_thread())
+        {
+            g_identify.add(os_get_time_monotonic() - t);
+        }
+        done->notify();
+    }
+
+    void handle_identify_global(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        if (on_own_thread() &&
+            (!event->dst_node || event->dst_node == node_))
+        {
+            send_identified(entry, done);
+        }
+        done->notify();
+    }
+
+    void handle_identify_consumer(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        if ((entry.user_arg & IS_CONSUMER) && on_own_thread())
+        {
+            send_identified(entry, done);
+        }
+        done->notify();
+    }
+
+    void handle_identify_producer(const EventRegistryEntry &entry,
+        EventReport *event, BarrierNotifiable *done) override
+    {
+        if ((entry.user_arg & IS_PRODUCER) && on_own_thread())
+        {
+            send_identified(entry, done);
+        }
+        done->notify();
+    }
+
+private:
+    /// Values of EventRegistryEntry::user_arg.
+    enum
+    {
+        IS_PRODUCER = 1,
+        IS_CONSUMER = 2,
+    };
+
+    /// @return true if the current message came in on this node's
+    /// interface.
+    bool on_own_thread()
+    {
+        return os_thread_self() == node_->iface()->executor()->thread_handle();
+    }
+
+    /// Sends a Producer or Consumer Identified message for a registry entry.
+    void send_identified(const EventRegistryEntry &entry,
+        BarrierNotifiable *done)
+    {
+        if (!node_->is_initialized())
+        {
+            return;
+        }
+        Defs::MTI mti = (entry.user_arg & IS_PRODUCER)
+            ? Defs::MTI_PRODUCER_IDENTIFIED_UNKNOWN
+            : Defs::MTI_CONSUMER_IDENTIFIED_UNKNOWN;
+        auto *flow = node_->iface()->global_message_write_flow();
+        auto *b = flow->alloc();
+        b->data()->reset(
+            mti, node_->node_id(), openlcb::eventid_to_buffer(entry.event));
+        b->set_done(done->new_child());
+        flow->send(b);
+    }
+
+    openlcb::Node *node_;
+};
+
+/// One virtual node of the swarm.
+class SwarmNode : public openlcb::DefaultNode
+{
+public:
+    /// @param iface is the interface of the worker. @param index is the
+    /// node's index in the swarm.
+    SwarmNode(openlcb::If *iface, unsigned index)
+        : DefaultNode(iface, NODE_ID_BASE + index)
+        , index_(index)
+        , events_(this, index)
+    {
+    }
+
+    /// @return the index of the node in the swarm.
+    unsigned index()
+    {
+        return index_;
+    }
+
+private:
+    unsigned index_;
+    SwarmEventHandler events_;
+};
+
+/// Train implementation that measures how long set speed commands take to
+/// arrive.
+class SwarmTrain : public openlcb::LoggingTrain
+{
+public:
+    /// @param index is the train's index in the swarm.
+    SwarmTrain(unsigned index)
+        : LoggingTrain(index + 1)
+        , index_(index)
+    {
+    }
+
+    void set_speed(openlcb::SpeedType speed) override
+    {
+        long long t = g_times->traction[index_];
+        if (t)
+        {
+            g_traction.add(os_get_time_monotonic() - t);
+        }
+        speed_ = speed;
+    }
+
+    openlcb::SpeedType get_speed() override
+    {
+        return speed_;
+    }
+
+private:
+    unsigned index_;
+    openlcb::SpeedType speed_;
+};
+
+/// Receives the replies to the configuration reads and measures their
+/// round-trip time.
+class ReadReplyHandler : public openlcb::DefaultDatagramHandler
+{
+public:
+    /// @param service is the datagram service of the worker.
+    ReadReplyHandler(openlcb::DatagramService *service)
+        : DefaultDatagramHandler(service)
+    {
+    }
+
+private:
+    Action entry() override
+    {
+        if (size() >= 6)
+        {
+            const uint8_t *p = payload();
+            uint32_t offset = ((uint32_t)p[2] << 24) | ((uint32_t)p[3] << 16) |
+                ((uint32_t)p[4] << 8) | p[5];
+            unsigned slot = offset / READ_LENGTH;
+            if (slot < g_times->read.size())
+            {
+                long long t = g_times->read[slot].exchange(0);
+                if (t)
+                {
+                    g_read.add(os_get_time_monotonic() - t);
+                }
+            }
+        }
+        return respond_ok(0);
+    }
+};
+
+/// Sends one configuration read datagram for a read slot.
+class ReadProbeFlow : public StateFlowBase
+{
+public:
+    /// @param service is the datagram service of the worker. @param slot is
+    /// the read slot owned by this flow.
+    ReadProbeFlow(openlcb::DatagramService *service, unsigned slot)
+        : StateFlowBase(service)
+        , slot_(slot)
+    {
+    }
+
+    /// @return true if a new read can be started.
+    bool idle()
+    {
+        return is_terminated() && !g_times->read[slot_];
+    }
+
+    /// Starts a read. Must be called on the worker's executor.
+    /// @param src is the requesting node. @param dst is the node to read.
+    void start(openlcb::Node *src, NodeID dst)
+    {
+        src_ = src;
+        dst_ = dst;
+        start_flow(STATE(allocate_client));
+    }
+
+    /// Fails the outstanding read if it is too old. @param now is the
+    /// current time.
+    void expire(long long now)
+    {
+        long long t = g_times->read[slot_];
+        if (t && now - t > READ_TIMEOUT_NSEC &&
+            g_times->read[slot_].compare_exchange_strong(t, 0))
+        {
+            g_read.failed();
+        }
+    }
+
+private:
+    openlcb::DatagramService *dg_service()
+    {
+        return static_cast<openlcb::DatagramService *>(service());
+    }
+
+    Action allocate_client()
+    {
+        return allocate_and_call(
+            STATE(send_read), dg_service()->client_allocator());
+    }
+
+    Action send_read()
+    {
+        client_ = full_allocation_result(dg_service()->client_allocator());
+        auto *b = dg_service()->iface()->dispatcher()->alloc();
+        b->data()->reset(Defs::MTI_DATAGRAM, src_->node_id(), NodeHandle(dst_),
+            openlcb::MemoryConfigDefs::read_datagram(
+                READ_SPACE, slot_ * READ_LENGTH, READ_LENGTH));
+        b->set_done(bn_.reset(this));
+        g_times->read[slot_] = os_get_time_monotonic();
+        client_->write_datagram(b);
+        return wait_and_call(STATE(sent));
+    }
+
+    Action sent()
+    {
+        if (!(client_->result() & openlcb::DatagramClient::OPERATION_SUCCESS))
+        {
+            g_times->read[slot_] = 0;
+            g_read.failed();
+        }
+        dg_service()->client_allocator()->typed_insert(client_);
+        client_ = nullptr;
+        return exit();
+    }
+
+    unsigned slot_;
+    openlcb::Node *src_ {nullptr};
+    NodeID dst_ {0};
+    openlcb::DatagramClient *client_ {nullptr};
+    BarrierNotifiable bn_;
+};
+
+class Worker;
+
+/// Generates the traffic of one worker at the configured rates.
+class TrafficFlow : public StateFlowBase
+{
+public:
+    /// @param worker is the worker whose nodes send the traffic.
+    /// @param seed initializes the random number generator.
+    TrafficFlow(Worker *worker, Service *service, uint32_t seed)
+        : StateFlowBase(service)
+        , worker_(worker)
+        , random_(seed | 1)
+    {
+    }
+
+    /// Starts generating traffic until g_running becomes false.
+    void start()
+    {
+        start_flow(STATE(tick));
+    }
+
+private:
+    /// How often the credits are refilled.
+    static constexpr long long TICK_NSEC = MSEC_TO_NSEC(5);
+
+    Action tick();
+
+    /// @return a pseudo-random number.
+    uint32_t random()
+    {
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 17;
+        random_ ^= random_ << 5;
+        return random_;
+    }
+
+    /// Adds the credit for the elapsed time. @param credit is the credit to
+    /// update. @param rate is the swarm-wide rate per second. @param sec is
+    /// the elapsed time. @param workers is the number of workers sharing the
+    /// rate.
+    static void refill(
+        double *credit, double rate, double sec, unsigned workers = num_workers)
+    {
+        double per_worker = rate / workers;
+        // Does not let the credits pile up while the executor is overloaded.
+        *credit = std::min(*credit + per_worker * sec, per_worker * 0.1 + 1);
+    }
+
+    void send_pcer(long long now);
+    void send_identify(long long now);
+    void send_read();
+    void send_traction(long long now);
+
+    Worker *worker_;
+    StateFlowTimer timer_ {this};
+    uint32_t random_;
+    long long lastTick_ {0};
+    double pcerCredit_ {0};
+    double identifyCredit_ {0};
+    double readCredit_ {0};
+    double tractionCredit_ {0};
+};
+
+/// A worker thread with its own executor, interface and hub connection,
+/// hosting a share of the swarm's nodes and trains.
+class Worker
+{
+public:
+    /// @param index is the index of the worker. @param local_nodes is the
+    /// number of nodes and trains this worker will host.
+    Worker(unsigned index, unsigned local_nodes)
+        : index_(index)
+        , name_(StringPrintf("worker%u", index))
+        , executor_(name_.c_str(), 0, 2048)
+        , service_(&executor_)
+        , hub_(&service_)
+        , ifCan_(&executor_, &hub_, local_nodes + 10,
+              num_nodes + num_trains + 10, local_nodes)
+        , datagramService_(&ifCan_, 10, reads_in_flight + 2)
+        , memoryConfig_(&datagramService_, nullptr, 4)
+        , configSpace_(g_config_data, sizeof(g_config_data))
+        , readReplies_(&datagramService_)
+        , trainService_(&ifCan_)
+        , traffic_(this, &service_, 0x9E3779B9u * (index + 1))
+    {
+        ifCan_.add_addressed_message_support();
+        // The first node on this worker has the index of the worker.
+        ifCan_.set_alias_allocator(
+            new openlcb::AliasAllocator(NODE_ID_BASE + index, &ifCan_));
+        memoryConfig_.registry()->insert(nullptr, READ_SPACE, &configSpace_);
+        memoryConfig_.set_client(&readReplies_);
+        for (unsigned i = 0; i < reads_in_flight; ++i)
+        {
+            probes_.emplace_back(new ReadProbeFlow(
+                &datagramService_, index * reads_in_flight + i));
+        }
+        hub_.register_metrics((name_ + ".hub").c_str());
+        ifCan_.register_metrics((name_ + ".if").c_str());
+    }
+
+    /// @return true if the nodes of this worker send configuration reads.
+    /// The first half of the workers read the nodes of the second half. If
+    /// two workers were reading each other, their MemoryConfigHandlers could
+    /// both be waiting for the other to acknowledge a reply datagram, while
+    /// the reply addressed to them is queued behind the wait.
+    bool reads()
+    {
+        return index_ < num_workers / 2;
+    }
+
+    /// @return the interface of this worker.
+    openlcb::IfCan *iface()
+    {
+        return &ifCan_;
+    }
+
+    /// Creates a swarm node. @param index is the node's index in the swarm.
+    void add_node(unsigned index)
+    {
+        nodes_.emplace_back(new SwarmNode(&ifCan_, index));
+    }
+
+    /// Creates a train node. @param index is the train's index in the swarm.
+    void add_train(unsigned index)
+    {
+        trainImpls_.emplace_back(new SwarmTrain(index));
+        trains_.emplace_back(new openlcb::TrainNodeWithId(&trainService_,
+            trainImpls_.back().get(), TRAIN_NODE_ID_BASE + index));
+    }
+
+    /// Connects to the hub. @param host is the hub's host name. @param port
+    /// is the hub's port. @return false on error.
+    bool connect(const char *host, int port)
+    {
+        int fd = ConnectSocket(host, port);
+        if (fd < 0)
+        {
+            return false;
+        }
+        if (binary_stream && !binary_can_client_handshake(fd, 5000))
+        {
+            fprintf(stderr, "Hub did not accept the binary format.\n");
+            close(fd);
+            return false;
+        }
+        fd_ = fd;
+        create_port_for_can_hub(&hub_, fd,
+            binary_stream ? CanStreamFormat::BINARY
+                          : CanStreamFormat::GRIDCONNECT,
+            &portExited_);
+        return true;
+    }
+
+    /// Closes the connection to the hub, and waits until the port of the
+    /// connection is removed from the worker's hub.
+    void disconnect()
+    {
+        if (fd_ < 0)
+        {
+            return;
+        }
+        // The port's reader and writer see the error and close fd.
+        ::shutdown(fd_, SHUT_RDWR);
+        portExited_.wait_for_notification();
+        fd_ = -1;
+    }
+
+    /// Lets the executor finish the work that is already queued, then stops
+    /// its thread, so that nothing runs on this worker after appl_main
+    /// returns.
+    void stop()
+    {
+        do
+        {
+            executor_.sync_run([]() {});
+        } while (!executor_.empty());
+        executor_.shutdown();
+    }
+
+    /// Starts reserving an alias for every local node.
+    void allocate_aliases()
+    {
+        auto *a = ifCan_.alias_allocator();
+        for (unsigned i = 0; i < nodes_.size() + trains_.size(); ++i)
+        {
+            a->send(a->alloc());
+        }
+    }
+
+    /// @return the number of local nodes and trains that are initialized.
+    unsigned num_initialized()
+    {
+        unsigned n = 0;
+        for (auto &node : nodes_)
+        {
+            n += node->is_initialized();
+        }
+        for (auto &train : trains_)
+        {
+            n += train->is_initialized();
+        }
+        return n;
+    }
+
+    /// Starts the traffic generator.
+    void start_traffic()
+    {
+        traffic_.start();
+    }
+
+private:
+    friend class TrafficFlow;
+
+    unsigned index_;
+    std::string name_;
+    Executor<1> executor_;
+    Service service_;
+    CanHubFlow hub_;
+    openlcb::IfCan ifCan_;
+    openlcb::CanDatagramService datagramService_;
+    openlcb::MemoryConfigHandler memoryConfig_;
+    openlcb::ReadOnlyMemoryBlock configSpace_;
+    ReadReplyHandler readReplies_;
+    openlcb::TrainService trainService_;
+    std::vector<std::unique_ptr<SwarmNode>> nodes_;
+    std::vector<std::unique_ptr<SwarmTrain>> trainImpls_;
+    std::vector<std::unique_ptr<openlcb::TrainNode>> trains_;
+    std::vector<std::unique_ptr<ReadProbeFlow>> probes_;
+    TrafficFlow traffic_;
+    /// Socket of the hub connection, -1 if not connected.
+    int fd_ {-1};
+    /// Notified when the port of the hub connection is gone.
+    SyncNotifiable portExited_;
+};
+
+constexpr long long TrafficFlow::TICK_NSEC;
+
+StateFlowBase::Action TrafficFlow::tick()
+{
+    if (!g_running)
+    {
+        return exit();
+    }
+    long long now = os_get_time_monotonic();
+    if (lastTick_)
+    {
+        double sec = (now - lastTick_) / 1e9;
+        refill(&pcerCredit_, pcer_rate, sec);
+        if (worker_->index_ == 0)
+        {
+            // Each identify involves the whole swarm, and the latency is
+            // measured from a single send time.
+            refill(&identifyCredit_, identify_rate, sec, 1);
+        }
+        if (worker_->reads())
+        {
+            refill(&readCredit_, read_rate, sec, num_workers / 2);
+        }
+        refill(&tractionCredit_, traction_rate, sec);
+    }
+    lastTick_ = now;
+    for (; pcerCredit_ >= 1; pcerCredit_ -= 1)
+    {
+        send_pcer(now);
+    }
+    for (; identifyCredit_ >= 1; identifyCredit_ -= 1)
+    {
+        send_identify(now);
+    }
+    for (; readCredit_ >= 1; readCredit_ -= 1)
+    {
+        send_read();
+    }
+    for (; tractionCredit_ >= 1; tractionCredit_ -= 1)
+    {
+        send_traction(now);
+    }
+    for (auto &p : worker_->probes_)
+    {
+        p->expire(now);
+    }
+    return sleep_and_call(&timer_, TICK_NSEC, STATE(tick));
+}
+
+void TrafficFlow::send_pcer(long long now)
+{
+    if (worker_->nodes_.empty())
+    {
+        return;
+    }
+    SwarmNode *node = worker_->nodes_[random() % worker_->nodes_.size()].get();
+    if (!node->is_initialized())
+    {
+        return;
+    }
+    unsigned i = random() % events_per_node;
+    g_times->pcer[node->index() * events_per_node + i] = now;
+    auto *flow = worker_->ifCan_.global_message_write_flow();
+    auto *b = flow->alloc();
+    b->data()->reset(Defs::MTI_EVENT_REPORT, node->node_id(),
+        openlcb::eventid_to_buffer(node_event(node->index(), i)));
+    flow->send(b);
+    g_pcer.sent();
+}
+
+void TrafficFlow::send_identify(long long now)
+{
+    if (worker_->nodes_.empty())
+    {
+        return;
+    }
+    SwarmNode *node = worker_->nodes_[random() % worker_->nodes_.size()].get();
+    if (!node->is_initialized())
+    {
+        return;
+    }
+    g_times->identify = now;
+    auto *flow = worker_->ifCan_.global_message_write_flow();
+    auto *b = flow->alloc();
+    b->data()->reset(Defs::MTI_EVENTS_IDENTIFY_GLOBAL, node->node_id(),
+        openlcb::EMPTY_PAYLOAD);
+    flow->send(b);
+    g_identify.sent();
+}
+
+void TrafficFlow::send_read()
+{
+    if (worker_->nodes_.empty())
+    {
+        return;
+    }
+    ReadProbeFlow *probe = nullptr;
+    for (auto &p : worker_->probes_)
+    {
+        if (p->idle())
+        {
+            probe = p.get();
+            break;
+        }
+    }
+    if (!probe)
+    {
+        // All slots are waiting for a reply; the configured rate is more
+        // than the swarm can serve.
+        g_read.failed();
+        return;
+    }
+    SwarmNode *node = worker_->nodes_[random() % worker_->nodes_.size()].get();
+    if (!node->is_initialized())
+    {
+        return;
+    }
+    // The target is on one of the workers that serve reads (see
+    // Worker::reads()).
+    unsigned servers = num_workers - num_workers / 2;
+    unsigned dst = random() % num_nodes;
+    dst = dst - dst % num_workers + num_workers / 2 + random() % servers;
+    if (dst >= num_nodes)
+    {
+        if (dst < num_workers)
+        {
+            return;
+        }
+        dst -= num_workers;
+    }
+    probe->start(node, NODE_ID_BASE + dst);
+    g_read.sent();
+}
+
+void TrafficFlow::send_traction(long long now)
+{
+    if (worker_->nodes_.empty())
+    {
+        return;
+    }
+    SwarmNode *node = worker_->nodes_[random() % worker_->nodes_.size()].get();
+    if (!node->is_initialized())
+    {
+        return;
+    }
+    unsigned train = random() % num_trains;
+    g_times->traction[train] = now;
+    auto *flow = worker_->ifCan_.addressed_message_write_flow();
+    auto *b = flow->alloc();
+    b->data()->reset(Defs::MTI_TRACTION_CONTROL_COMMAND, node->node_id(),
+        NodeHandle(TRAIN_NODE_ID_BASE + train),
+        openlcb::TractionDefs::speed_set_payload(
+            openlcb::Velocity::from_mph(random() % 100)));
+    flow->send(b);
+    g_traction.sent();
+}
+
+/// @return the sum of a metric over all workers. @param suffix is the metric
+/// name after the worker's prefix.
+static int64_t sum_worker_metric(const char *suffix)
+{
+    int64_t sum = 0;
+    for (unsigned i = 0; i < num_workers; ++i)
+    {
+        sum += MetricsRegistry::instance()->get(
+            StringPrintf("worker%u.%s", i, suffix));
+    }
+    return sum;
+}
+
+/// @return the CPU time used by the process (all threads), in nsec.
+static long long process_cpu_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return SEC_TO_NSEC((long long)ts.tv_sec) + ts.tv_nsec;
+}
+
+/// Tears down the swarm before the static destructors run. The workers close
+/// their connections, then we wait until the built-in hub has dropped the
+/// ports of these connections and its executor finished deleting them.
+/// Finally the worker threads are stopped.
+/// @param workers is the swarm.
+/// @param tcp_hub is the built-in hub's listener, or nullptr if the swarm is
+/// connected to an upstream hub.
+static void disconnect_swarm(
+    const std::vector<Worker *> &workers, GcTcpHub *tcp_hub)
+{
+    for (auto *w : workers)
+    {
+        w->disconnect();
+    }
+    if (tcp_hub)
+    {
+        while (can_hub0.size() > 0)
+        {
+            usleep(1000);
+        }
+        // A port that left the hub might still be yielding on the executor
+        // before deleting itself, and the hub might still be routing the
+        // last frames it got.
+        do
+        {
+            g_executor.sync_run([]() {});
+        } while (!g_executor.empty() || !can_hub0.is_waiting());
+        delete tcp_hub;
+    }
+    for (auto *w : workers)
+    {
+        w->stop();
+    }
+}
+
+/// Sleeps until a point in time. Unlike sleep() this is not cut short by
+/// signals. @param deadline is in os_get_time_monotonic() units.
+static void sleep_until(long long deadline)
+{
+    long long now;
+    while ((now = os_get_time_monotonic()) < deadline)
+    {
+        usleep(std::min(deadline - now, MSEC_TO_NSEC(100)) / 1000);
+    }
+}
+
+/**
+ * The application entry point.
+ *
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ *
+ * @return 0 on success
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+
+    // The swarm is never deleted; disconnect_swarm() stops its threads before
+    // appl_main returns.
+    g_times = new SendTimes;
+    g_times->pcer = std::vector<std::atomic<long long>>(
+        num_nodes * events_per_node);
+    g_times->read = std::vector<std::atomic<long long>>(
+        num_workers * reads_in_flight);
+    g_times->traction = std::vector<std::atomic<long long>>(num_trains);
+
+    const char *host = upstream_host;
+    int hub_port = upstream_port;
+    GcTcpHub *tcp_hub = nullptr;
+    if (!host)
+    {
+        can_hub0.register_metrics("hub");
+        tcp_hub = new GcTcpHub(&can_hub0, port);
+        while (!tcp_hub->is_started())
+        {
+            usleep(1000);
+        }
+        host = "localhost";
+        hub_port = port;
+    }
+
+    std::vector<Worker *> workers;
+    for (unsigned w = 0; w < num_workers; ++w)
+    {
+        unsigned local = (num_nodes + num_workers - 1 - w) / num_workers +
+            (num_trains + num_workers - 1 - w) / num_workers;
+        workers.push_back(new Worker(w, local));
+    }
+    // There can be only one event registry, so one event service serves all
+    // the interfaces.
+    auto *event_service = new openlcb::EventService(workers[0]->iface());
+    for (unsigned w = 1; w < num_workers; ++w)
+    {
+        event_service->register_interface(workers[w]->iface());
+    }
+    new openlcb::InitializeFlow(&g_service);
+    for (unsigned i = 0; i < num_nodes; ++i)
+    {
+        workers[i % num_workers]->add_node(i);
+    }
+    for (unsigned i = 0; i < num_trains; ++i)
+    {
+        workers[i % num_workers]->add_train(i);
+    }
+    for (auto *w : workers)
+    {
+        if (!w->connect(host, hub_port))
+        {
+            fprintf(stderr, "Could not connect to the hub at %s:%d\n", host,
+                hub_port);
+            disconnect_swarm(workers, tcp_hub);
+            return 1;
+        }
+    }
+
+    printf("Starting %u nodes (%u events each) and %u trains on %u threads, "
+           "hub %s:%d.\n",
+        num_nodes, events_per_node, num_trains, num_workers, host, hub_port);
+    long long start = os_get_time_monotonic();
+    for (auto *w : workers)
+    {
+        w->allocate_aliases();
+    }
+    unsigned total = num_nodes + num_trains;
+    unsigned initialized = 0;
+    long long last_progress = start;
+    while (initialized < total)
+    {
+        usleep(100000);
+        unsigned n = 0;
+        for (auto *w : workers)
+        {
+            n += w->num_initialized();
+        }
+        long long now = os_get_time_monotonic();
+        if (n != initialized)
+        {
+            initialized = n;
+            last_progress = now;
+        }
+        else if (now - last_progress > SEC_TO_NSEC(10))
+        {
+            fprintf(stderr, "Node initialization stuck at %u of %u.\n",
+                initialized, total);
+            disconnect_swarm(workers, tcp_hub);
+            return 1;
+        }
+    }
+    printf("All nodes initialized in %.1f s.\n",
+        (os_get_time_monotonic() - start) / 1e9);
+
+    int64_t hub_frames = MetricsRegistry::instance()->get("hub.packets");
+    int64_t worker_frames = sum_worker_metric("hub.packets");
+    long long cpu = process_cpu_nsec();
+    start = os_get_time_monotonic();
+    g_running = true;
+    for (auto *w : workers)
+    {
+        w->start_traffic();
+    }
+    sleep_until(start + SEC_TO_NSEC(duration_sec));
+    g_running = false;
+    double sec = (os_get_time_monotonic() - start) / 1e9;
+    // Lets the responses in flight arrive.
+    sleep_until(os_get_time_monotonic() + SEC_TO_NSEC(1));
+    hub_frames = MetricsRegistry::instance()->get("hub.packets") - hub_frames;
+    worker_frames = sum_worker_metric("hub.packets") - worker_frames;
+    cpu = process_cpu_nsec() - cpu;
+
+    printf("Traffic ran for %.1f s.\n", sec);
+    if (!upstream_host)
+    {
+        printf("Hub: %" PRId64 " frames, %.0f frames/sec.\n", hub_frames,
+            hub_frames / sec);
+    }
+    printf("Worker hubs: %" PRId64 " frames in+out, %.0f frames/sec.\n",
+        worker_frames, worker_frames / sec);
+    printf("Process CPU: %.2f s, %.2f usec per worker frame.\n\n",
+        cpu / 1e9, worker_frames ? cpu / 1e3 / worker_frames : 0.0);
+    printf("%-10s %9s %9s %7s %9s %9s %9s %9s %9s %9s\n", "traffic", "sent",
+        "received", "failed", "recv/sec", "mean_usec", "p50_usec", "p90_usec",
+        "p99_usec", "max_usec");
+    g_pcer.print(sec);
+    g_identify.print(sec);
+    g_read.print(sec);
+    g_traction.print(sec);
+
+    if (print_metrics)
+    {
+        std::string m;
+        MetricsRegistry::instance()->render(&m, "");
+        printf("\n%s", m.c_str());
+    }
+    disconnect_swarm(workers, tcp_hub);
+    return 0;
+}
@@ -0,0 +1,824 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Microbenchmarks of the executor, buffer pool, queues, dispatcher,
+ * GridConnect codec, alias cache and event registry. Results can be compared
+ * against a baseline file to catch performance regressions.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "can_frame.h"
+#include "executor/Dispatcher.hxx"
+#include "executor/Executor.hxx"
+#include "executor/Notifiable.hxx"
+#include "executor/Service.hxx"
+#include "executor/StateFlow.hxx"
+#include "openlcb/AliasCache.hxx"
+#include "openlcb/EventHandlerContainer.hxx"
+#include "openlcb/EventHandlerTemplates.hxx"
+#include "os/os.h"
+#include "utils/BinaryCanStream.hxx"
+#include "utils/Buffer.hxx"
+#include "utils/Queue.hxx"
+#include "utils/StringPrintf.hxx"
+#include "utils/gc_format.h"
+
+Executor<1> g_executor("g_executor", 0, 1024);
+Service g_service(&g_executor);
+
+const char *filter = nullptr;
+unsigned min_time_msec = 200;
+unsigned repeats = 3;
+const char *baseline_path = nullptr;
+unsigned threshold_pct = 25;
+bool list_only = false;
+
+void usage(const char *e)
+{
+    fprintf(stderr, "Usage: %s [-f filter] [-t msec] [-r repeats] "
+                    "[-b baseline [-x percent]] [-l]\n\n",
+            e);
+    fprintf(stderr, "Runs microbenchmarks of the executor, buffer pool, "
+                    "queues, dispatcher, GridConnect codec, alias cache and "
+                    "event registry, and prints the time per operation. The "
+                    "output can be saved as a baseline for later runs.\n\n"
+                    "Arguments:\n");
+    fprintf(stderr, "\t-f filter   runs only the benchmarks whose name "
+                    "contains filter.\n");
+    fprintf(stderr, "\t-t msec     minimum time of one measurement. Default "
+                    "200.\n");
+    fprintf(stderr, "\t-r repeats  number of measurements per benchmark; the "
+                    "median is reported. Default 3.\n");
+    fprintf(stderr, "\t-b baseline compares the results against a file "
+                    "written by an earlier run. Exits with status 1 if any "
+                    "benchmark regressed.\n");
+    fprintf(stderr, "\t-x percent  slowdown compared to the baseline that "
+                    "counts as a regression. Default 25.\n");
+    fprintf(stderr, "\t-l          lists the benchmarks without running "
+                    "them.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hf:t:r:b:x:l")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 'f':
+                filter = optarg;
+                break;
+            case 't':
+                min_time_msec = atoi(optarg);
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            case 'b':
+                baseline_path = optarg;
+                break;
+            case 'x':
+                threshold_pct = atoi(optarg);
+                break;
+            case 'l':
+                list_only = true;
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (min_time_msec == 0 || repeats == 0)
+    {
+        usage(argv[0]);
+    }
+}
+
+/// Keeps the compiler from optimizing away the results of the measured
+/// operations.
+volatile uintptr_t g_sink;
+
+/// Base class of the benchmarks. A benchmark performs a given number of
+/// operations; the harness chooses the number so that a measurement takes
+/// long enough to be reliable.
+class Benchmark
+{
+public:
+    /// @param name is the name printed in the results and baselines.
+    Benchmark(std::string name)
+        : name_(std::move(name))
+    {
+    }
+
+    virtual ~Benchmark()
+    {
+    }
+
+    /// @return the name of the benchmark.
+    const std::string &name()
+    {
+        return name_;
+    }
+
+    /// Called before the measurements. The time spent here is not counted.
+    virtual void setup()
+    {
+    }
+
+    /// Performs the measured operation. @param iterations is the number of
+    /// operations to perform.
+    virtual void run(unsigned iterations) = 0;
+
+    /// Called after the measurements.
+    virtual void teardown()
+    {
+    }
+
+private:
+    std::string name_;
+};
+
+/// Adds an executable to the executor and waits until it has run, from a
+/// different thread.
+class ExecutorRoundTripBenchmark : public Benchmark
+{
+public:
+    ExecutorRoundTripBenchmark()
+        : Benchmark("executor.sync_run")
+    {
+    }
+
+    void run(unsigned iterations) override
+    {
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            g_executor.sync_run([]() {});
+        }
+    }
+};
+
+/// A state flow that yields to the executor a given number of times, then
+/// deletes itself. Each yield is an Executor::add and a run of the flow.
+class YieldFlow : public StateFlowBase
+{
+public:
+    /// @param count is the number of yields. @param done is notified at the
+    /// end.
+    YieldFlow(unsigned count, Notifiable *done)
+        : StateFlowBase(&g_service)
+        , count_(count)
+        , done_(done)
+    {
+        start_flow(STATE(step));
+    }
+
+private:
+    Action step()
+    {
+        if (!count_)
+        {
+            done_->notify();
+            return delete_this();
+        }
+        --count_;
+        return yield_and_call(STATE(step));
+    }
+
+    unsigned count_;
+    Notifiable *done_;
+};
+
+/// Measures Executor::add and run within the executor thread.
+class ExecutorYieldBenchmark : public Benchmark
+{
+public:
+    ExecutorYieldBenchmark()
+        : Benchmark("executor.yield")
+    {
+    }
+
+    void run(unsigned iterations) override
+    {
+        SyncNotifiable n;
+        new YieldFlow(iterations, &n);
+        n.wait_for_notification();
+    }
+};
+
+/// Payload of a given size, for allocating from a specific size class of the
+/// buffer pool.
+template <unsigned SIZE> struct Blob
+{
+    uint8_t data[SIZE];
+};
+
+/// Allocates and frees buffers of one size from the main buffer pool.
+template <unsigned SIZE> class PoolBenchmark : public Benchmark
+{
+public:
+    PoolBenchmark()
+        : Benchmark(StringPrintf(
+              "pool.alloc_free/%u", (unsigned)sizeof(Buffer<Blob<SIZE>>)))
+    {
+    }
+
+    void run(unsigned iterations) override
+    {
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            Buffer<Blob<SIZE>> *b;
+            mainBufferPool->alloc(&b);
+            b->unref();
+        }
+    }
+};
+
+/// Inserts entries into a QList and takes them out in priority order.
+class QListBenchmark : public Benchmark
+{
+public:
+    /// @param priority is the priority of the entries; -1 cycles through all
+    /// priorities.
+    QListBenchmark(int priority)
+        : Benchmark(priority < 0 ? std::string("qlist.insert_next/mixed")
+                                 : StringPrintf("qlist.insert_next/p%d",
+                                       priority))
+        , priority_(priority)
+    {
+    }
+
+    void run(unsigned iterations) override
+    {
+        while (iterations)
+        {
+            unsigned n = std::min(iterations, (unsigned)ARRAYSIZE(items_));
+            for (unsigned i = 0; i < n; ++i)
+            {
+                queue_.insert(&items_[i], priority_ < 0 ? i % NUM_PRIO
+                                                        : priority_);
+            }
+            for (unsigned i = 0; i < n; ++i)
+            {
+                g_sink = (uintptr_t)queue_.next().item;
+            }
+            iterations -= n;
+        }
+    }
+
+private:
+    static constexpr unsigned NUM_PRIO = 4;
+
+    /// Queue entry.
+    struct Item : public QMember
+    {
+    };
+
+    int priority_;
+    QList<NUM_PRIO> queue_;
+    Item items_[64];
+};
+
+/// Message type dispatched by the DispatchFlow benchmark.
+struct BenchPayload
+{
+    typedef uint32_t id_type;
+    /// @return the ID used by the dispatcher.
+    id_type id()
+    {
+        return id_;
+    }
+    uint32_t id_;
+};
+
+typedef Buffer<BenchPayload> BenchMessage;
+
+/// Handler of the DispatchFlow benchmark. Counts and frees the messages.
+class CountingHandler : public FlowInterface<BenchMessage>
+{
+public:
+    /// Sets up the handler to notify after a number of messages.
+    /// @param count is the number of messages. @param done is notified.
+    void expect(unsigned count, Notifiable *done)
+    {
+        count_ = count;
+        done_ = done;
+    }
+
+    void send(BenchMessage *message, unsigned priority) override
+    {
+        message->unref();
+        if (!--count_)
+        {
+            done_->notify();
+        }
+    }
+
+private:
+    unsigned count_ {0};
+    Notifiable *done_ {nullptr};
+};
+
+/// Sends messages through a DispatchFlow with many registered handlers, of
+/// which exactly one matches each message. Includes the buffer allocation
+/// and the queueing to the executor.
+class DispatchBenchmark : public Benchmark
+{
+public:
+    /// @param handlers is the number of registered handlers.
+    DispatchBenchmark(unsigned handlers)
+        : Benchmark(StringPrintf("dispatch.match/%u", handlers))
+        , numHandlers_(handlers)
+    {
+    }
+
+    void setup() override
+    {
+        dispatcher_.reset(new DispatchFlow<BenchMessage, 4>(&g_service));
+        for (unsigned i = 0; i < numHandlers_; ++i)
+        {
+            dispatcher_->register_handler(&handler_, i, 0xFFFFFFFFu);
+        }
+    }
+
+    void run(unsigned iterations) override
+    {
+        unsigned id = 0;
+        while (iterations)
+        {
+            // Limits the number of buffers in flight.
+            unsigned n = std::min(iterations, 256u);
+            SyncNotifiable done;
+            handler_.expect(n, &done);
+            for (unsigned i = 0; i < n; ++i)
+            {
+                BenchMessage *b;
+                mainBufferPool->alloc(&b);
+                b->data()->id_ = id;
+                if (++id >= numHandlers_)
+                {
+                    id = 0;
+                }
+                dispatcher_->send(b);
+            }
+            done.wait_for_notification();
+            iterations -= n;
+        }
+    }
+
+    void teardown() override
+    {
+        g_executor.sync_run([this]() { dispatcher_.reset(); });
+    }
+
+private:
+    unsigned numHandlers_;
+    CountingHandler handler_;
+    std::unique_ptr<DispatchFlow<BenchMessage, 4>> dispatcher_;
+};
+
+/// Formats CAN frames in GridConnect format.
+class GcGenerateBenchmark : public Benchmark
+{
+public:
+    GcGenerateBenchmark()
+        : Benchmark("gridconnect.generate")
+    {
+    }
+
+    void run(unsigned iterations) override
+    {
+        struct can_frame frame;
+        CLR_CAN_FRAME_ERR(frame);
+        CLR_CAN_FRAME_RTR(frame);
+        SET_CAN_FRAME_EFF(frame);
+        frame.can_dlc = 8;
+        memset(frame.data, 0xA5, 8);
+        char buf[32];
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            SET_CAN_FRAME_ID_EFF(frame, 0x195B4000 | (i & 0xFFF));
+            g_sink = gc_format_generate(&frame, buf, 0) - buf;
+        }
+    }
+};
+
+/// Parses GridConnect packets.
+class GcParseBenchmark : public Benchmark
+{
+public:
+    GcParseBenchmark()
+        : Benchmark("gridconnect.parse")
+    {
+    }
+
+    void run(unsigned iterations) override
+    {
+        // The leading ':' and the trailing ';' are already removed.
+        static const char PACKET[] = "X195B4123N0102030405060708";
+        struct can_frame frame;
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            g_sink = gc_format_parse(PACKET, &frame);
+        }
+        g_sink = frame.can_id;
+    }
+};
+
+/// Encodes CAN frames in the binary CAN stream format.
+class BinaryCanGenerateBenchmark : public Benchmark
+{
+public:
+    BinaryCanGenerateBenchmark()
+        : Benchmark("binary_can.generate")
+    {
+    }
+
+    void run(unsigned iterations) override
+    {
+        struct can_frame frame;
+        CLR_CAN_FRAME_ERR(frame);
+        CLR_CAN_FRAME_RTR(frame);
+        SET_CAN_FRAME_EFF(frame);
+        frame.can_dlc = 8;
+        memset(frame.data, 0xA5, 8);
+        uint8_t buf[BINARY_CAN_MAX_FRAME_LENGTH];
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            SET_CAN_FRAME_ID_EFF(frame, 0x195B4000 | (i & 0xFFF));
+            g_sink = binary_can_format_generate(&frame, buf);
+        }
+    }
+};
+
+/// Parses binary CAN stream frames. Unlike gridconnect.parse, this includes
+/// finding the frame boundaries byte by byte.
+class BinaryCanParseBenchmark : public Benchmark
+{
+public:
+    BinaryCanParseBenchmark()
+        : Benchmark("binary_can.parse")
+    {
+    }
+
+    void run(unsigned iterations) override
+    {
+        static const uint8_t PACKET[] = {
+            0x88, 0x19, 0x5B, 0x41, 0x23, 1, 2, 3, 4, 5, 6, 7, 8};
+        BinaryCanStreamParser parser;
+        struct can_frame frame;
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (uint8_t c : PACKET)
+            {
+                if (parser.consume_byte(c))
+                {
+                    parser.parse_frame_to_output(&frame);
+                }
+            }
+        }
+        g_sink = frame.can_id;
+    }
+};
+
+/// Looks up entries of a full alias cache.
+class AliasCacheBenchmark : public Benchmark
+{
+public:
+    /// @param entries is the size of the cache. @param by_alias selects
+    /// looking up by alias instead of by node ID.
+    AliasCacheBenchmark(unsigned entries, bool by_alias)
+        : Benchmark(StringPrintf("alias_cache.lookup_%s/%u",
+              by_alias ? "alias" : "id", entries))
+        , entries_(entries)
+        , byAlias_(by_alias)
+    {
+        HASSERT(entries < 0xFFF);
+    }
+
+    void setup() override
+    {
+        cache_.reset(new openlcb::AliasCache(NODE_ID_BASE, entries_));
+        for (unsigned i = 0; i < entries_; ++i)
+        {
+            cache_->add(NODE_ID_BASE + i, i + 1);
+        }
+    }
+
+    void run(unsigned iterations) override
+    {
+        unsigned k = 0;
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            if (byAlias_)
+            {
+                g_sink = cache_->lookup(openlcb::NodeAlias(k + 1));
+            }
+            else
+            {
+                g_sink = cache_->lookup(openlcb::NodeID(NODE_ID_BASE + k));
+            }
+            // Strides through the entries in a cache-unfriendly order.
+            k += 37;
+            if (k >= entries_)
+            {
+                k %= entries_;
+            }
+        }
+    }
+
+    void teardown() override
+    {
+        cache_.reset();
+    }
+
+private:
+    static constexpr openlcb::NodeID NODE_ID_BASE = 0x050101010000ULL;
+
+    unsigned entries_;
+    bool byAlias_;
+    std::unique_ptr<openlcb::AliasCache> cache_;
+};
+
+constexpr openlcb::NodeID AliasCacheBenchmark::NODE_ID_BASE;
+
+/// Event handler that is only registered, never called.
+class NullEventHandler : public openlcb::SimpleEventHandler
+{
+public:
+    void handle_identify_global(const openlcb::EventRegistryEntry &entry,
+        openlcb::EventReport *event, BarrierNotifiable *done) override
+    {
+        done->notify();
+    }
+};
+
+/// Iterates the handlers of a TreeEventHandlers registry for an event.
+class EventIterationBenchmark : public Benchmark
+{
+public:
+    /// @param handlers is the number of registered handlers, each for a
+    /// different event. @param all selects iterating over all handlers (as
+    /// for an Identify Events message) instead of looking up one event.
+    EventIterationBenchmark(unsigned handlers, bool all)
+        : Benchmark(StringPrintf(
+              "event_registry.%s/%u", all ? "iterate_all" : "lookup", handlers))
+        , numHandlers_(handlers)
+        , all_(all)
+    {
+    }
+
+    void setup() override
+    {
+        registry_.reset(new openlcb::TreeEventHandlers());
+        for (unsigned i = 0; i < numHandlers_; ++i)
+        {
+            registry_->register_handler(
+                openlcb::EventRegistryEntry(&handler_, EVENT_BASE + i * 4), 0);
+        }
+        iterator_.reset(registry_->create_iterator());
+    }
+
+    void run(unsigned iterations) override
+    {
+        openlcb::EventReport report;
+        // Same as the report of an Identify Events (global) message.
+        report.event = 0;
+        report.mask = all_ ? 0xFFFFFFFFFFFFFFFFULL : 0;
+        unsigned k = 0;
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            if (!all_)
+            {
+                report.event = EVENT_BASE + k * 4;
+                if (++k >= numHandlers_)
+                {
+                    k = 0;
+                }
+            }
+            iterator_->init_iteration(&report);
+            unsigned found = 0;
+            while (iterator_->next_entry())
+            {
+                ++found;
+            }
+            g_sink = found;
+        }
+    }
+
+    void teardown() override
+    {
+        iterator_.reset();
+        registry_.reset();
+    }
+
+private:
+    static constexpr openlcb::EventId EVENT_BASE = 0x0501010100000000ULL;
+
+    unsigned numHandlers_;
+    bool all_;
+    NullEventHandler handler_;
+    std::unique_ptr<openlcb::TreeEventHandlers> registry_;
+    std::unique_ptr<openlcb::EventIterator> iterator_;
+};
+
+constexpr openlcb::EventId EventIterationBenchmark::EVENT_BASE;
+
+/// @return all benchmarks in the order they are run.
+std::vector<std::unique_ptr<Benchmark>> create_benchmarks()
+{
+    std::vector<std::unique_ptr<Benchmark>> v;
+    v.emplace_back(new ExecutorYieldBenchmark());
+    v.emplace_back(new ExecutorRoundTripBenchmark());
+    v.emplace_back(new PoolBenchmark<4>());
+    v.emplace_back(new PoolBenchmark<28>());
+    v.emplace_back(new PoolBenchmark<200>());
+    v.emplace_back(new QListBenchmark(0));
+    v.emplace_back(new QListBenchmark(3));
+    v.emplace_back(new QListBenchmark(-1));
+    for (unsigned n : {1, 10, 100, 1000})
+    {
+        v.emplace_back(new DispatchBenchmark(n));
+    }
+    v.emplace_back(new GcGenerateBenchmark());
+    v.emplace_back(new GcParseBenchmark());
+    v.emplace_back(new BinaryCanGenerateBenchmark());
+    v.emplace_back(new BinaryCanParseBenchmark());
+    for (unsigned n : {16, 256, 2048})
+    {
+        v.emplace_back(new AliasCacheBenchmark(n, false));
+        v.emplace_back(new AliasCacheBenchmark(n, true));
+    }
+    for (unsigned n : {10, 100, 1000})
+    {
+        v.emplace_back(new EventIterationBenchmark(n, false));
+        v.emplace_back(new EventIterationBenchmark(n, true));
+    }
+    return v;
+}
+
+/// Runs a benchmark. @param b is the benchmark. @param iterations is set to
+/// the number of operations per measurement. @return the median time per
+/// operation in nanoseconds.
+double measure(Benchmark *b, unsigned *iterations)
+{
+    long long min_nsec = MSEC_TO_NSEC(min_time_msec);
+    // Finds an iteration count that takes about the minimum time.
+    unsigned n = 1;
+    while (true)
+    {
+        long long start = os_get_time_monotonic();
+        b->run(n);
+        long long elapsed = os_get_time_monotonic() - start;
+        if (elapsed >= min_nsec / 10 || n >= (1u << 30))
+        {
+            double scaled = (double)n * min_nsec / std::max(elapsed, 1LL);
+            n = (unsigned)std::min(std::max(scaled, (double)n), 2e9);
+            break;
+        }
+        n *= 10;
+    }
+    std::vector<double> results;
+    for (unsigned i = 0; i < repeats; ++i)
+    {
+        long long start = os_get_time_monotonic();
+        b->run(n);
+        results.push_back(double(os_get_time_monotonic() - start) / n);
+    }
+    std::sort(results.begin(), results.end());
+    *iterations = n;
+    return results[results.size() / 2];
+}
+
+/// Reads a file written by an earlier run. @param path is the file name.
+/// @param baseline receives the time per operation for each benchmark name.
+/// @return false if the file cannot be read.
+bool read_baseline(const char *path, std::map<std::string, double> *baseline)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        char name[128];
+        double nsec;
+        if (line[0] != '#' && sscanf(line, "%127s %lf", name, &nsec) == 2)
+        {
+            (*baseline)[name] = nsec;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * The application entry point.
+ *
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0 on success, 1 if a benchmark regressed compared to the baseline
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+    std::map<std::string, double> baseline;
+    if (baseline_path && !read_baseline(baseline_path, &baseline))
+    {
+        fprintf(stderr, "Could not read baseline %s\n", baseline_path);
+        return 1;
+    }
+    // Makes sure the pool exists and the executor thread is running before
+    // the first measurement.
+    init_main_buffer_pool();
+    g_executor.sync_run([]() {});
+
+    auto benchmarks = create_benchmarks();
+    printf("# %-34s %12s %12s", "benchmark", "nsec/op", "iterations");
+    if (baseline_path)
+    {
+        printf(" %12s %8s", "baseline", "change");
+    }
+    printf("\n");
+    unsigned regressions = 0;
+    for (auto &b : benchmarks)
+    {
+        if (filter && !strstr(b->name().c_str(), filter))
+        {
+            continue;
+        }
+        if (list_only)
+        {
+            printf("%s\n", b->name().c_str());
+            continue;
+        }
+        b->setup();
+        unsigned iterations;
+        double nsec = measure(b.get(), &iterations);
+        b->teardown();
+        printf("%-36s %12.1f %12u", b->name().c_str(), nsec, iterations);
+        auto it = baseline.find(b->name());
+        if (it != baseline.end())
+        {
+            double change = (nsec / it->second - 1) * 100;
+            printf(" %12.1f %+7.0f%%", it->second, change);
+            if (change > threshold_pct)
+            {
+                printf(" REGRESSION");
+                ++regressions;
+            }
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+    if (regressions)
+    {
+        fprintf(stderr, "%u benchmark(s) regressed by more than %u%%.\n",
+            regressions, threshold_pct);
+        return 1;
+    }
+    return 0;
+}
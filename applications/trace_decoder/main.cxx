@@ -0,0 +1,133 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file main.cxx
+ *
+ * Decodes the binary trace files written by TraceDrainer into text.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "os/os.h"
+#include "utils/Trace.hxx"
+
+const char *input_path = nullptr;
+const char *output_path = nullptr;
+
+void usage(const char *e)
+{
+    fprintf(stderr, "Usage: %s [-o output_file] [trace_file]\n", e);
+    fprintf(stderr, "Decodes a binary trace written by TraceDrainer into "
+                    "text, one record per line.\n");
+    fprintf(stderr, "Reads from standard input if no trace_file is given, "
+                    "and writes to standard output if no -o is given.\n");
+    exit(1);
+}
+
+void parse_args(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "ho:")) >= 0)
+    {
+        switch (opt)
+        {
+            case 'h':
+                usage(argv[0]);
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            default:
+                fprintf(stderr, "Unknown option %c\n", opt);
+                usage(argv[0]);
+        }
+    }
+    if (optind < argc)
+    {
+        input_path = argv[optind];
+    }
+}
+
+/** Entry point to application.
+ * @param argc number of command line arguments
+ * @param argv array of command line arguments
+ * @return 0 on success, 1 if the input is not a valid trace.
+ */
+int appl_main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+    int in_fd = 0;
+    if (input_path)
+    {
+        in_fd = ::open(input_path, O_RDONLY);
+        if (in_fd < 0)
+        {
+            perror(input_path);
+            return 1;
+        }
+    }
+    std::string input;
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::read(in_fd, buf, sizeof(buf))) > 0)
+    {
+        input.append(buf, n);
+    }
+
+    std::string output;
+    bool ok = trace_decode(input, &output);
+
+    FILE *out = stdout;
+    if (output_path)
+    {
+        out = fopen(output_path, "w");
+        if (!out)
+        {
+            perror(output_path);
+            return 1;
+        }
+    }
+    fwrite(output.data(), 1, output.size(), out);
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Invalid or truncated trace file.\n");
+        return 1;
+    }
+    return 0;
+}
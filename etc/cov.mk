@@ -20,8 +20,10 @@ CSHAREDFLAGS = -c -frandom-seed=$(shell echo $(abspath $<) | md5sum  | sed 's/\(
 
 CFLAGS = $(CSHAREDFLAGS) -std=gnu99
 
+# The coverage build has its own copy of the libraries, so it can turn on the
+# buffer timestamps to cover the latency measurement code.
 CXXFLAGS = $(CSHAREDFLAGS) -std=c++0x -D__STDC_FORMAT_MACROS \
-           -D__STDC_LIMIT_MACROS #-D__LINEAR_MAP__
+           -D__STDC_LIMIT_MACROS -DBUFFER_TIMESTAMPS #-D__LINEAR_MAP__
 
 LDFLAGS = $(ARCHOPTIMIZATION) -pg -Wl,-Map="$(@:%=%.map)"
 SYSLIB_SUBDIRS +=
@@ -110,8 +110,14 @@ endif
 
 $(EXECUTABLE)$(EXTENTION): cdi.o
 
+# Set COMPRESS_CDI=1 in the target Makefile to store the CDI xml compressed in
+# the binary.
+ifneq ($(COMPRESS_CDI),)
+COMPILE_CDI_ARGS := -c
+endif
+
 cdi.o : compile_cdi
-	./compile_cdi > cdi.cxx
+	./compile_cdi $(COMPILE_CDI_ARGS) > cdi.cxx
 	$(CXX) $(CXXFLAGS) -x c++ cdi.cxx -o $@
 	mv cdi.cxx cdi.cxxout
 	rm -f cdi.d
@@ -112,6 +112,10 @@ DECLARE_CONST(gridconnect_buffer_delay_usec);
  * two threads per client (multi-threaded) execution model. */
 DECLARE_CONST(gridconnect_tcp_use_select);
 
+/** Whether clients of the GridConnect TCP server may switch their connection
+ * to the binary CAN stream format (see utils/BinaryCanStream.hxx). */
+DECLARE_CONST(gridconnect_tcp_accept_binary);
+
 /** Number of entries in the remote alias cache */
 DECLARE_CONST(remote_alias_cache_size);
 
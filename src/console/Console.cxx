@@ -33,6 +33,11 @@
 
 #include "console/Console.hxx"
 
+#include <stdlib.h>
+
+#include "executor/ExecutorProfiler.hxx"
+#include "utils/Metrics.hxx"
+
 #if defined (CONSOLE_NETWORKING)
 #include <netinet/tcp.h>
 #include <sys/socket.h>
@@ -72,6 +77,74 @@ Console::Console(ExecutorBase *executor, int fd_in, int fd_out, int port)
     add_command("quit", quit_command, this);
 }
 
+/*
+ * Console::profile_command()
+ */
+Console::CommandStatus Console::profile_command(FILE *fp, int argc, const char *argv[], void *context)
+{
+    if (argc == 0)
+    {
+        fprintf(fp, "executor profiling: on | off | clear | show [count]\n");
+        return COMMAND_OK;
+    }
+    ExecutorBase *executor = static_cast<ExecutorBase*>(context);
+    const char *op = argc > 1 ? argv[1] : "show";
+    if (!strcmp(op, "on"))
+    {
+        executor->enable_profiling(true);
+    }
+    else if (!strcmp(op, "off"))
+    {
+        executor->enable_profiling(false);
+    }
+    else if (!strcmp(op, "clear"))
+    {
+        if (executor->profiler())
+        {
+            executor->profiler()->clear();
+        }
+    }
+    else if (!strcmp(op, "show"))
+    {
+        if (!executor->profiler())
+        {
+            fprintf(fp, "profiling was never enabled\n");
+            return COMMAND_OK;
+        }
+        unsigned count = argc > 2 ? strtoul(argv[2], nullptr, 10) : 10;
+        executor->profiler()->print(fp, count);
+    }
+    else
+    {
+        return COMMAND_ERROR;
+    }
+    return COMMAND_OK;
+}
+
+/*
+ * Console::metrics_command()
+ */
+Console::CommandStatus Console::metrics_command(FILE *fp, int argc, const char *argv[], void *context)
+{
+    switch (argc)
+    {
+        case 0:
+            fprintf(fp, "print metrics: metrics [name_prefix]\n");
+            return COMMAND_OK;
+        case 1:
+        case 2:
+        {
+            std::string out;
+            MetricsRegistry::instance()->render(
+                &out, argc > 1 ? argv[1] : nullptr);
+            fwrite(out.data(), 1, out.size(), fp);
+            return COMMAND_OK;
+        }
+        default:
+            return COMMAND_ERROR;
+    }
+}
+
 /*
  * Console::open_session()
  */
@@ -130,6 +130,25 @@ public:
      */
     void add_command(const char *name, Callback callback, void *context = NULL);
 
+    /** Add a command to control and display the profiler of an executor.
+     * @param executor executor whose profiler the command operates on
+     * @param name command name
+     */
+    void add_profile_command(ExecutorBase *executor,
+                             const char *name = "profile")
+    {
+        add_command(name, profile_command, executor);
+    }
+
+    /** Add a command to print the metrics from the MetricsRegistry. An
+     * optional argument filters the metrics by name prefix.
+     * @param name command name
+     */
+    void add_metrics_command(const char *name = "metrics")
+    {
+        add_command(name, metrics_command, nullptr);
+    }
+
     /** Default STDIN file descriptor */
     static const int FD_STDIN = 0;
 
@@ -490,6 +509,24 @@ private:
      */
     CommandStatus quit_command(FILE *fp, int argc, const char *argv[]);
 
+    /** Turn on, turn off, clear or print the profiler of an executor.
+     * @param fp file pointer to console
+     * @param argc number of arguments including the command itself
+     * @param argv array of arguments starting with the command itself
+     * @param context pointer to the ExecutorBase to profile
+     * @return COMMAND_OK on success, COMMAND_ERROR on bad arguments
+     */
+    static CommandStatus profile_command(FILE *fp, int argc, const char *argv[], void *context);
+
+    /** Print the registered metrics.
+     * @param fp file pointer to console
+     * @param argc number of arguments including the command itself
+     * @param argv array of arguments starting with the command itself
+     * @param context unused
+     * @return COMMAND_OK on success, COMMAND_ERROR on bad arguments
+     */
+    static CommandStatus metrics_command(FILE *fp, int argc, const char *argv[], void *context);
+
     /** Open and initialize a new session.
      * @param fd_in input file descriptor belonging to session
      * @param fd_out output file descriptor belonging to session
@@ -36,6 +36,8 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+#include <algorithm>
+
 
 #define LOGLEVEL INFO
 
@@ -71,4 +73,122 @@ StateFlowBase::Action LocalTrackIfSelect::entry() {
     return write_repeated(&helper_, fd_, p, sizeof(*p), STATE(finish));
 }
 
+LocalTrackIfBatched::LocalTrackIfBatched(Service *service, int pool_size,
+    unsigned ring_size, unsigned max_batch, bool use_select)
+    : LocalTrackIf(service, pool_size)
+    , ring_(new dcc::Packet[ring_size])
+    , ringSize_(ring_size)
+    , maxBatch_(max_batch)
+    , useSelect_(use_select)
+{
+    HASSERT(ring_size > 0 && max_batch > 0);
+}
+
+LocalTrackIfBatched::~LocalTrackIfBatched()
+{
+    delete[] ring_;
+}
+
+StateFlowBase::Action LocalTrackIfBatched::entry()
+{
+    HASSERT(fd_ >= 0);
+    if (count_ >= ringSize_)
+    {
+        // The writer will notify us when there is space.
+        if (!producerWaiting_)
+        {
+            ++stats_.ringFull;
+        }
+        producerWaiting_ = true;
+        return wait();
+    }
+    producerWaiting_ = false;
+    unsigned head = tail_ + count_;
+    if (head >= ringSize_)
+    {
+        head -= ringSize_;
+    }
+    ring_[head] = *message()->data();
+    ++count_;
+    writer_.kick();
+    return finish();
+}
+
+LocalTrackIfBatched::Writer::Writer(LocalTrackIfBatched *parent)
+    : StateFlowBase(parent->service())
+    , parent_(parent)
+{
+}
+
+void LocalTrackIfBatched::Writer::kick()
+{
+    if (is_terminated())
+    {
+        start_flow(STATE(write_next));
+    }
+}
+
+StateFlowBase::Action LocalTrackIfBatched::Writer::write_next()
+{
+    auto *p = parent_;
+    if (!p->count_)
+    {
+        return exit();
+    }
+    if (p->count_ < p->maxBatch_ && p->count_ != lastCount_)
+    {
+        // Gives the update loop a chance to add more packets to this batch,
+        // so long as it is making progress.
+        lastCount_ = p->count_;
+        return yield_and_call(STATE(write_next));
+    }
+    lastCount_ = 0;
+    unsigned num = std::min(p->count_, p->ringSize_ - p->tail_);
+    num = std::min(num, p->maxBatch_);
+    dcc::Packet *start = p->ring_ + p->tail_;
+    if (p->useSelect_)
+    {
+        inFlight_ = num;
+        ++p->stats_.writes;
+        return write_repeated(&helper_, p->fd_, start, num * sizeof(*start),
+            STATE(write_done));
+    }
+    int ret = ::write(p->fd_, start, num * sizeof(*start));
+    if (ret < 0)
+    {
+        HASSERT(errno == ENOSPC);
+        ::ioctl(p->fd_, CAN_IOC_WRITE_ACTIVE, this);
+        return wait();
+    }
+    HASSERT(ret % sizeof(*start) == 0);
+    ++p->stats_.writes;
+    consume(ret / sizeof(*start));
+    return again();
+}
+
+StateFlowBase::Action LocalTrackIfBatched::Writer::write_done()
+{
+    HASSERT(!helper_.hasError_);
+    consume(inFlight_);
+    inFlight_ = 0;
+    return call_immediately(STATE(write_next));
+}
+
+void LocalTrackIfBatched::Writer::consume(unsigned num)
+{
+    auto *p = parent_;
+    p->tail_ += num;
+    if (p->tail_ >= p->ringSize_)
+    {
+        p->tail_ -= p->ringSize_;
+    }
+    p->count_ -= num;
+    p->stats_.packets += num;
+    if (p->producerWaiting_)
+    {
+        p->producerWaiting_ = false;
+        p->notify();
+    }
+}
+
 } // namespace dcc
@@ -114,6 +114,117 @@ protected:
     StateFlowSelectHelper helper_{this};
 };
 
+/// StateFlow that accepts dcc::Packet structures and sends them to a local
+/// device driver in batches.
+///
+/// Incoming packets are copied into an internal ring and their buffers are
+/// released immediately, so the update loop can generate the next packet
+/// while the previous ones are still being written. A separate writer flow
+/// hands up to max_batch packets to the device in a single write() call,
+/// which saves system calls (and, on a host with a userspace driver behind a
+/// pipe or character device, context switches) per packet.
+///
+/// The device driver must accept writes of any whole number of dcc::Packet
+/// structures, and return the number of bytes that it took. Both the select()
+/// model and the notifiable-based asynchronous write model are supported.
+class LocalTrackIfBatched : public LocalTrackIf
+{
+public:
+    /** Constructs a TrackInterface from an fd to the mainline.
+     *
+     * @param service Usually the main executor.
+     * @param pool_size will determine how many packets the current flow's
+     * alloc() will have.
+     * @param ring_size how many packets can be buffered between the update
+     * loop and the device.
+     * @param max_batch the maximum number of packets to send to the device
+     * in a single write call.
+     * @param use_select if true, the device is waited for using select();
+     * if false, using the CAN_IOC_WRITE_ACTIVE notifiable ioctl.
+     */
+    LocalTrackIfBatched(Service *service, int pool_size,
+        unsigned ring_size = 16, unsigned max_batch = 8,
+        bool use_select = true);
+
+    ~LocalTrackIfBatched();
+
+    /// Counters about the writes performed.
+    struct Stats
+    {
+        /// Number of packets handed to the device.
+        unsigned packets{0};
+        /// Number of (successful or partial) write calls to the device.
+        unsigned writes{0};
+        /// Number of times the update loop had to wait for ring space.
+        unsigned ringFull{0};
+    };
+
+    /// @return counters about the writes performed so far.
+    const Stats &stats()
+    {
+        return stats_;
+    }
+
+    /// @return number of packets in the ring not yet handed to the device.
+    unsigned pending()
+    {
+        return count_;
+    }
+
+protected:
+    Action entry() OVERRIDE;
+
+private:
+    /// Flow that drains the ring into the device.
+    class Writer : public StateFlowBase
+    {
+    public:
+        /// @param parent the owning track interface.
+        Writer(LocalTrackIfBatched *parent);
+
+        /// Starts the flow if it is not running yet.
+        void kick();
+
+    private:
+        /// Writes the next contiguous chunk from the ring. @return next
+        /// action.
+        Action write_next();
+        /// Called when a select-based write is complete. @return next action.
+        Action write_done();
+        /// Removes packets from the ring after they were written.
+        /// @param num how many packets to remove.
+        void consume(unsigned num);
+
+        /// Owning track interface.
+        LocalTrackIfBatched *parent_;
+        /// Number of packets in the currently outstanding select write.
+        unsigned inFlight_{0};
+        /// Ring fill level when we last yielded before a write.
+        unsigned lastCount_{0};
+        /// Helper class for select() ing the target device.
+        StateFlowSelectHelper helper_{this};
+    };
+
+    /// Ring of packets waiting to be written.
+    dcc::Packet *ring_;
+    /// Number of entries in ring_.
+    unsigned ringSize_;
+    /// Maximum number of packets per write call.
+    unsigned maxBatch_;
+    /// Index of the oldest packet in the ring.
+    unsigned tail_{0};
+    /// Number of packets in the ring.
+    unsigned count_{0};
+    /// True if the device is waited for with select().
+    bool useSelect_;
+    /// True if entry() is blocked waiting for ring space.
+    bool producerWaiting_{false};
+    /// Counters.
+    Stats stats_;
+    /// Flow draining the ring.
+    Writer writer_{this};
+};
+
 } // namespace dcc
 
 #endif // _DCC_LOCALTRACKIF_HXX_
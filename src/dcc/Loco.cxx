@@ -95,11 +95,7 @@ void DccTrain<Payload>::get_next_packet(unsigned code, Packet *packet)
     }
     if (code == REFRESH)
     {
-        code = MIN_REFRESH + this->p.nextRefresh_++;
-        if (this->p.nextRefresh_ > MAX_REFRESH - MIN_REFRESH)
-        {
-            this->p.nextRefresh_ = 0;
-        }
+        code = this->p.next_refresh_code();
     }
     else
     {
@@ -214,21 +210,9 @@ void MMNewTrain::get_next_packet(unsigned code, Packet *packet)
 
     if (code == REFRESH)
     {
-        unsigned r = p.nextRefresh_;
-        if ((r & 1) == 0) {
-            code = SPEED;
-        } else {
-            // TODO(bracz): check if this refresh cycle confuses the marklin
-            // engines' directional state.
-            r >>= 1;
-            r += MM_F1;
-            code = r;
-        }
-        if (p.nextRefresh_ == MM_MAX_REFRESH) {
-            p.nextRefresh_ = 0;
-        } else {
-            ++p.nextRefresh_;
-        }
+        // TODO(bracz): check if this refresh cycle confuses the marklin
+        // engines' directional state.
+        code = p.next_refresh_code();
     }
     else
     {
@@ -248,7 +232,7 @@ void MMNewTrain::get_next_packet(unsigned code, Packet *packet)
         {
             packet->add_mm_new_speed(!p.direction_, Packet::CHANGE_DIR);
             p.directionChanged_ = 0;
-            p.nextRefresh_ = 0; // sends another speed packet
+            p.force_speed_refresh(); // sends another speed packet
             packet->mm_shift();
         }
         else
@@ -68,14 +68,147 @@ enum DccTrainUpdateCode
     MM_F2,
     MM_F3,
     MM_F4,
-    MIN_REFRESH = SPEED,
-    /** @TODO(balazs.racz) choose adaptive max-refresh based on how many
-     * functions are actually in use for the loco. */
-    MAX_REFRESH = FUNCTION9,
-    MM_MAX_REFRESH = 7,
     ESTOP = 16,
 };
 
+/// Decides which packet a train should send when it is polled for a
+/// background refresh packet.
+///
+/// Every other refresh packet is a speed packet. The remaining slots go to
+/// the function groups in a round robin, but each group has an aging level
+/// that is incremented every time the group is refreshed, and reset when a
+/// function in the group changes. A group at level L is refreshed only in
+/// every 2^L-th round, so function groups nobody touched for a while take up
+/// little track bandwidth. If no function group is due, the slot goes to
+/// speed.
+///
+/// The state is stored in STATE_BITS bits of the train payload (all zero is
+/// the initial state); this class is a temporary accessor to it.
+class RefreshPolicy
+{
+public:
+    /// Number of bits needed to store the state.
+    static constexpr unsigned STATE_BITS = 22;
+    /// Highest aging level. Groups at this level are refreshed in every
+    /// 2^MAX_LEVEL-th round.
+    static constexpr unsigned MAX_LEVEL = 3;
+    /// Maximum number of function groups.
+    static constexpr unsigned MAX_GROUPS = 5;
+
+    /// Constructor.
+    /// @param state is the stored state from the train payload.
+    /// @param num_groups is the number of function groups. The update code of
+    /// group g is FUNCTION0 + g.
+    /// @param num_mandatory groups above this number are not refreshed until
+    /// a function in them has been set.
+    RefreshPolicy(uint32_t state, unsigned num_groups, unsigned num_mandatory)
+        : state_(state)
+        , numGroups_(num_groups)
+        , numMandatory_(num_mandatory)
+    {
+        HASSERT(num_groups <= MAX_GROUPS);
+    }
+
+    /// @return the state to store back in the train payload.
+    uint32_t state()
+    {
+        return state_;
+    }
+
+    /// Notifies the policy that the train state has changed.
+    /// @param code is the update code sent to the update loop.
+    void changed(unsigned code)
+    {
+        unsigned g = code - FUNCTION0;
+        if (code < FUNCTION0 || g >= numGroups_)
+        {
+            return;
+        }
+        set(USED_SHIFT + g, 1, 1);
+        set(g * LEVEL_BITS, LEVEL_BITS, 0);
+    }
+
+    /// Makes the next refresh packet a speed packet.
+    void force_speed()
+    {
+        set(FUNCTION_SLOT_SHIFT, 1, 0);
+    }
+
+    /// @return the update code for the next background refresh packet.
+    unsigned next_code()
+    {
+        if (!get(FUNCTION_SLOT_SHIFT, 1))
+        {
+            set(FUNCTION_SLOT_SHIFT, 1, 1);
+            return SPEED;
+        }
+        set(FUNCTION_SLOT_SHIFT, 1, 0);
+        for (unsigned i = 0; i < numGroups_; ++i)
+        {
+            unsigned g = get(NEXT_GROUP_SHIFT, 3);
+            unsigned round = get(ROUND_SHIFT, MAX_LEVEL);
+            if (g + 1 >= numGroups_)
+            {
+                set(NEXT_GROUP_SHIFT, 3, 0);
+                set(ROUND_SHIFT, MAX_LEVEL, round + 1);
+            }
+            else
+            {
+                set(NEXT_GROUP_SHIFT, 3, g + 1);
+            }
+            unsigned level = get(g * LEVEL_BITS, LEVEL_BITS);
+            if ((g >= numMandatory_ && !get(USED_SHIFT + g, 1)) ||
+                (round & ((1 << level) - 1)))
+            {
+                continue;
+            }
+            if (level < MAX_LEVEL)
+            {
+                set(g * LEVEL_BITS, LEVEL_BITS, level + 1);
+            }
+            return FUNCTION0 + g;
+        }
+        return SPEED;
+    }
+
+private:
+    /// Bits per function group for the aging level.
+    static constexpr unsigned LEVEL_BITS = 2;
+    /// Bitmask of optional function groups that have been used.
+    static constexpr unsigned USED_SHIFT = MAX_GROUPS * LEVEL_BITS;
+    /// Which function group to look at next (3 bits).
+    static constexpr unsigned NEXT_GROUP_SHIFT = USED_SHIFT + MAX_GROUPS;
+    /// Counts the function group round robin cycles (MAX_LEVEL bits).
+    static constexpr unsigned ROUND_SHIFT = NEXT_GROUP_SHIFT + 3;
+    /// 1 if the next refresh slot is for a function group.
+    static constexpr unsigned FUNCTION_SLOT_SHIFT = ROUND_SHIFT + MAX_LEVEL;
+
+    /// @return a bit field from the state.
+    /// @param shift is the offset of the field.
+    /// @param bits is the width of the field.
+    unsigned get(unsigned shift, unsigned bits)
+    {
+        return (state_ >> shift) & ((1u << bits) - 1);
+    }
+
+    /// Sets a bit field in the state.
+    /// @param shift is the offset of the field.
+    /// @param bits is the width of the field.
+    /// @param value is the new value (will be truncated).
+    void set(unsigned shift, unsigned bits, unsigned value)
+    {
+        uint32_t mask = ((1u << bits) - 1) << shift;
+        state_ = (state_ & ~mask) | ((value << shift) & mask);
+    }
+
+    /// Refresh state.
+    uint32_t state_;
+    /// Number of function groups.
+    unsigned numGroups_;
+    /// Number of function groups that are refreshed even when not used.
+    unsigned numMandatory_;
+};
+
 /// AbstractTrain is a templated class for train implementations in a command
 /// station. It gives implementations for most functions that the OpenLCB
 /// command station neeeds, while using a compact structure for representing
@@ -111,11 +244,14 @@ public:
             return;
         }
         p.lastSetSpeed_ = new_speed;
+        bool changed = false;
         if (speed.direction() != p.direction_)
         {
             p.directionChanged_ = 1;
             p.direction_ = speed.direction();
+            changed = true;
         }
+        unsigned old_step = p.speed_;
         float f_speed = speed.mph();
         if (f_speed > 0)
         {
@@ -131,6 +267,11 @@ public:
         {
             p.speed_ = 0;
         }
+        if (!changed && p.speed_ == old_step)
+        {
+            // The packet on the track would be the same as the refresh.
+            return;
+        }
         packet_processor_notify_update(this, SPEED);
     }
 
@@ -167,6 +308,7 @@ public:
             return;
         }
         unsigned bit = 1 << address;
+        unsigned old_fn = p.fn_;
         if (value)
         {
             p.fn_ |= bit;
@@ -175,7 +317,13 @@ public:
         {
             p.fn_ &= ~bit;
         }
-        packet_processor_notify_update(this, p.get_fn_update_code(address));
+        if (p.fn_ == old_fn)
+        {
+            return;
+        }
+        unsigned code = p.get_fn_update_code(address);
+        p.fn_changed(code);
+        packet_processor_notify_update(this, code);
     }
     /// @return the last set value of a given function, or 0 if the function is
     /// not known. @param address is the function address.
@@ -221,12 +369,12 @@ struct Dcc28Payload
     unsigned lastSetSpeed_ : 16;
     /// functions f0-f28.
     unsigned fn_ : 29;
-    /// Which refresh packet should go out next.
-    unsigned nextRefresh_ : 3;
     /// Speed step we last set.
     unsigned speed_ : 5;
     /// Whether the direction change packet still needs to go out.
     unsigned directionChanged_ : 1;
+    /// State of the background refresh, see @ref RefreshPolicy.
+    unsigned refreshState_ : RefreshPolicy::STATE_BITS;
 
     /** @return the number of speed steps (in float). */
     static unsigned get_speed_steps()
@@ -240,6 +388,31 @@ struct Dcc28Payload
         return 28;
     }
 
+    /// Number of function groups for the background refresh.
+    static const unsigned NUM_FN_GROUPS = 5;
+    /// Function groups above this are only refreshed once they are used.
+    static const unsigned NUM_MANDATORY_FN_GROUPS = 3;
+
+    /// Records a change for the background refresh policy.
+    /// @param code is the update code sent to the update loop.
+    void fn_changed(unsigned code)
+    {
+        RefreshPolicy r(
+            refreshState_, NUM_FN_GROUPS, NUM_MANDATORY_FN_GROUPS);
+        r.changed(code);
+        refreshState_ = r.state();
+    }
+
+    /// @return the update code for the next background refresh packet.
+    unsigned next_refresh_code()
+    {
+        RefreshPolicy r(
+            refreshState_, NUM_FN_GROUPS, NUM_MANDATORY_FN_GROUPS);
+        unsigned code = r.next_code();
+        refreshState_ = r.state();
+        return code;
+    }
+
     /** @return the update code to send ot the packet handler for a given
      * function value change. @param address is the function number(0..28). */
     static unsigned get_fn_update_code(unsigned address);
@@ -313,12 +486,12 @@ struct Dcc128Payload
     unsigned lastSetSpeed_ : 16;
     /// functions f0-f28.
     unsigned fn_ : 29;
-    /// Which refresh packet should go out next.
-    unsigned nextRefresh_ : 3;
     /// Speed step we last set.
     unsigned speed_ : 7;
     /// Whether the direction change packet still needs to go out.
     unsigned directionChanged_ : 1;
+    /// State of the background refresh, see @ref RefreshPolicy.
+    unsigned refreshState_ : RefreshPolicy::STATE_BITS;
 
     /** @return the number of speed steps (the largest valid speed step). */
     static unsigned get_speed_steps()
@@ -332,6 +505,31 @@ struct Dcc128Payload
         return 28;
     }
 
+    /// Number of function groups for the background refresh.
+    static const unsigned NUM_FN_GROUPS = 5;
+    /// Function groups above this are only refreshed once they are used.
+    static const unsigned NUM_MANDATORY_FN_GROUPS = 3;
+
+    /// Records a change for the background refresh policy.
+    /// @param code is the update code sent to the update loop.
+    void fn_changed(unsigned code)
+    {
+        RefreshPolicy r(
+            refreshState_, NUM_FN_GROUPS, NUM_MANDATORY_FN_GROUPS);
+        r.changed(code);
+        refreshState_ = r.state();
+    }
+
+    /// @return the update code for the next background refresh packet.
+    unsigned next_refresh_code()
+    {
+        RefreshPolicy r(
+            refreshState_, NUM_FN_GROUPS, NUM_MANDATORY_FN_GROUPS);
+        unsigned code = r.next_code();
+        refreshState_ = r.state();
+        return code;
+    }
+
     /** @return the update code to send ot the packet handler for a given
      * function value change. */
     static unsigned get_fn_update_code(unsigned address)
@@ -397,6 +595,13 @@ struct MMOldPayload
         return 0;
     }
 
+    /// Records a change for the background refresh policy. There are no
+    /// function packets in this protocol. @param code is ignored.
+    void fn_changed(unsigned code)
+    {
+    }
+
+
     /** @return the update code to send to the packet handler for a given
      * function value change. @param address is ignored */
     unsigned get_fn_update_code(unsigned address)
@@ -448,8 +653,8 @@ struct MMNewPayload
     unsigned resvd1_ : 1;
     /// Speed step we last set.
     unsigned speed_ : 4;
-    /// internal refresh cycle state machine
-    unsigned nextRefresh_ : 3;
+    /// State of the background refresh, see @ref RefreshPolicy.
+    unsigned refreshState_ : RefreshPolicy::STATE_BITS;
 
     /** @return the number of speed steps (in float). */
     unsigned get_speed_steps()
@@ -463,6 +668,40 @@ struct MMNewPayload
         return 4;
     }
 
+    /// Number of function groups for the background refresh.
+    static const unsigned NUM_FN_GROUPS = 4;
+    /// Function groups above this are only refreshed once they are used.
+    static const unsigned NUM_MANDATORY_FN_GROUPS = 4;
+
+    /// Records a change for the background refresh policy.
+    /// @param code is the update code sent to the update loop.
+    void fn_changed(unsigned code)
+    {
+        RefreshPolicy r(
+            refreshState_, NUM_FN_GROUPS, NUM_MANDATORY_FN_GROUPS);
+        r.changed(code);
+        refreshState_ = r.state();
+    }
+
+    /// @return the update code for the next background refresh packet.
+    unsigned next_refresh_code()
+    {
+        RefreshPolicy r(
+            refreshState_, NUM_FN_GROUPS, NUM_MANDATORY_FN_GROUPS);
+        unsigned code = r.next_code();
+        refreshState_ = r.state();
+        return code;
+    }
+
+    /// Makes the next background refresh packet a speed packet.
+    void force_speed_refresh()
+    {
+        RefreshPolicy r(
+            refreshState_, NUM_FN_GROUPS, NUM_MANDATORY_FN_GROUPS);
+        r.force_speed();
+        refreshState_ = r.state();
+    }
+
     /** @return the update code to send to the packet handler for a given
      * function value change. @param address is the function number (0..4) */
     unsigned get_fn_update_code(unsigned address)
@@ -153,6 +153,30 @@ void Packet::add_dcc_speed14(bool is_fwd, bool light, unsigned speed)
     add_dcc_checksum();
 }
 
+/// @return the speed bits of a 28-step baseline speed byte (without the
+/// direction). @param speed is the speed step 0..28.
+static constexpr uint8_t dcc_speed28_bits(unsigned speed)
+{
+    // The speed step is offset by 3 to avoid 00, 01 (stop) and 10 11
+    // (e-stop). The lowest bit goes into the position of the light bit.
+    return speed == 0 ? 0
+                      : ((((speed + 3) & 1) ? DCC_BASELINE_SPEED_LIGHT : 0) |
+                            (((speed + 3) >> 1) & 0xf));
+}
+
+/// Expands to the speed bits of four consecutive speed steps.
+#define SPEED28_4(s)                                                           \
+    dcc_speed28_bits(s), dcc_speed28_bits(s + 1), dcc_speed28_bits(s + 2),     \
+        dcc_speed28_bits(s + 3)
+
+/// Lookup table from 28-step speed step to the speed bits of the baseline
+/// speed byte.
+static const uint8_t dcc_speed28_table[29] = {SPEED28_4(0), SPEED28_4(4),
+    SPEED28_4(8), SPEED28_4(12), SPEED28_4(16), SPEED28_4(20), SPEED28_4(24),
+    dcc_speed28_bits(28)};
+
+#undef SPEED28_4
+
 void Packet::add_dcc_speed28(bool is_fwd, unsigned speed)
 {
     uint8_t b1 = DCC_BASELINE_SPEED;
@@ -162,16 +186,10 @@ void Packet::add_dcc_speed28(bool is_fwd, unsigned speed)
     {
         b1 |= 1;
     }
-    else if (speed == 0)
-    {
-    }
     else
     {
         HASSERT(speed <= 28);
-        speed += 3; // avoids 00, 01 (stop) and 10 11 (e-stop)
-        if (speed & 1)
-            b1 |= DCC_BASELINE_SPEED_LIGHT;
-        b1 |= (speed >> 1) & 0xf;
+        b1 |= dcc_speed28_table[speed];
     }
     payload[dlc++] = b1;
     add_dcc_checksum();
@@ -273,47 +291,84 @@ void Packet::start_mm_packet()
     header_raw_data = MARKLIN_DEFAULT_CMD;
 }
 
-/// Helper array to translate a marklin address to a bit sequence.
-static const uint8_t marklin_address[3] = {0b00, 0b11, 0b10};
 /// Helper array to translate a marklin function set command to a packet.
 static const uint8_t marklin_fn_bits[5] = {0,          0b01010000, 0b00000100,
                                            0b00010100, 0b01010100};
 
+/// @return the bit sequence for one trit of a marklin address. @param t is
+/// the trit value (0..2).
+static constexpr uint8_t marklin_trit(unsigned t)
+{
+    return t == 0 ? 0b00 : (t == 1 ? 0b11 : 0b10);
+}
+
+/// @return the address bits of payload[0] (high byte) and payload[1] (low
+/// byte) for a marklin address. @param a is the address (0..80).
+static constexpr uint16_t marklin_address_bits(unsigned a)
+{
+    return (marklin_trit(a % 3) << 8) | (marklin_trit(a / 3 % 3) << 6) |
+        (marklin_trit(a / 9 % 3) << 4) | (marklin_trit(a / 27 % 3) << 2);
+}
+
+/// Expands to the address bits of three consecutive addresses.
+#define MM_ADDR_3(a)                                                           \
+    marklin_address_bits(a), marklin_address_bits(a + 1),                      \
+        marklin_address_bits(a + 2)
+/// Expands to the address bits of nine consecutive addresses.
+#define MM_ADDR_9(a) MM_ADDR_3(a), MM_ADDR_3(a + 3), MM_ADDR_3(a + 6)
+/// Expands to the address bits of 27 consecutive addresses.
+#define MM_ADDR_27(a) MM_ADDR_9(a), MM_ADDR_9(a + 9), MM_ADDR_9(a + 18)
+
+/// Lookup table from marklin address to the address bits. Saves the
+/// divisions, which are expensive on MCUs without a hardware divider.
+static const uint16_t marklin_address_table[81] = {
+    MM_ADDR_27(0), MM_ADDR_27(27), MM_ADDR_27(54)};
+
+#undef MM_ADDR_3
+#undef MM_ADDR_9
+#undef MM_ADDR_27
+
 /** Sets the address bits of an MM packet to a specific loco address. @param a
  * is the train address @param light if true, light (f0) will be set to ON. */
 void Packet::add_mm_address(MMAddress a, bool light)
 {
-    uint8_t address = a.value;
-    payload[0] |= marklin_address[address % 3];
-    address /= 3;
-    payload[1] |= marklin_address[address % 3] << 6;
-    address /= 3;
-    payload[1] |= marklin_address[address % 3] << 4;
-    address /= 3;
-    payload[1] |= marklin_address[address % 3] << 2;
+    uint16_t bits = marklin_address_table[a.value];
+    payload[0] |= bits >> 8;
+    payload[1] |= bits & 0xff;
     if (light)
     {
         payload[1] |= 0b11;
     }
 }
 
+/// @return the speed bits of payload[2] of an MM packet. @param speed is the
+/// (already offset and clipped) speed value 0..15.
+static constexpr uint8_t marklin_speed_bits(unsigned speed)
+{
+    return ((speed & 1) ? 0x80 : 0) | ((speed & 2) ? 0x20 : 0) |
+        ((speed & 4) ? 0x08 : 0) | ((speed & 8) ? 0x02 : 0);
+}
+
+/// Expands to the speed bits of four consecutive speed values.
+#define MM_SPEED_4(s)                                                          \
+    marklin_speed_bits(s), marklin_speed_bits(s + 1),                          \
+        marklin_speed_bits(s + 2), marklin_speed_bits(s + 3)
+
+/// Lookup table from MM speed value to the speed bits.
+static const uint8_t marklin_speed_table[16] = {
+    MM_SPEED_4(0), MM_SPEED_4(4), MM_SPEED_4(8), MM_SPEED_4(12)};
+
+#undef MM_SPEED_4
+
 unsigned Packet::set_mm_speed_bits(unsigned speed)
 {
-    payload[2] = 0;
     // avoids speed step 1.
     if (speed > 0)
         ++speed;
     // clips speed
     if (speed > 15)
         speed = 15;
-    if (speed & 1)
-        payload[2] |= 0x80;
-    if (speed & 2)
-        payload[2] |= 0x20;
-    if (speed & 4)
-        payload[2] |= 0x08;
-    if (speed & 8)
-        payload[2] |= 0x02;
+    payload[2] = marklin_speed_table[speed];
     return speed;
 }
 
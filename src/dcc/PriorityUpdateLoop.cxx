@@ -0,0 +1,300 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file PriorityUpdateLoop.cxx
+ *
+ * Command station update loop that sends changed train state to the track
+ * ahead of the background refresh.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "dcc/PriorityUpdateLoop.hxx"
+
+#include "dcc/PacketSource.hxx"
+#include "dcc/Loco.hxx"
+
+namespace dcc
+{
+
+/// Number of preamble bits the DCC drivers send.
+static const unsigned DCC_PREAMBLE_BITS = 14;
+/// Number of preamble bits for a long preamble.
+static const unsigned DCC_LONG_PREAMBLE_BITS = 20;
+/// Length of a DCC one bit in usec.
+static const unsigned DCC_ONE_USEC = 116;
+/// Length of a DCC zero bit in usec.
+static const unsigned DCC_ZERO_USEC = 200;
+/// Length of a Marklin-Motorola packet in usec: 18 trits of 208 usec, sent
+/// twice, with the mandatory pauses.
+static const unsigned MM_PACKET_USEC = 2 * 18 * 208 + 2 * 1250;
+
+constexpr unsigned PriorityUpdateLoop::DEFAULT_URGENT_REPEATS;
+constexpr unsigned PriorityUpdateLoop::MAX_URGENT_BURST;
+constexpr unsigned PriorityUpdateLoop::MIN_REFRESH_SPACING_USEC;
+constexpr unsigned PriorityUpdateLoop::HOT_PERIOD_USEC;
+constexpr unsigned PriorityUpdateLoop::HOT_WEIGHT;
+
+PriorityUpdateLoop::PriorityUpdateLoop(Service *service,
+    PacketFlowInterface *track_send, unsigned urgent_repeats)
+    : StateFlow(service)
+    , trackSend_(track_send)
+    , urgentRepeats_(urgent_repeats ? urgent_repeats : 1)
+{
+}
+
+PriorityUpdateLoop::~PriorityUpdateLoop()
+{
+}
+
+void PriorityUpdateLoop::add_refresh_source(dcc::PacketSource *source)
+{
+    AtomicHolder h(this);
+    refreshSources_.push_back({source, 0, 0});
+}
+
+void PriorityUpdateLoop::remove_refresh_source(dcc::PacketSource *source)
+{
+    AtomicHolder h(this);
+    for (unsigned i = 0; i < refreshSources_.size(); ++i)
+    {
+        if (refreshSources_[i].source == source)
+        {
+            // Order does not matter for the refresh scheduler.
+            refreshSources_[i] = refreshSources_.back();
+            refreshSources_.pop_back();
+            break;
+        }
+    }
+    for (auto it = urgentQueue_.begin(); it != urgentQueue_.end();)
+    {
+        if (it->source == source)
+        {
+            it = urgentQueue_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    if (lastSource_ == source)
+    {
+        lastSource_ = nullptr;
+    }
+}
+
+void PriorityUpdateLoop::notify_update(PacketSource *source, unsigned code)
+{
+    AtomicHolder h(this);
+    RefreshEntry *e = find_entry(source);
+    if (e)
+    {
+        e->hotUntilUsec = trackUsec_ + HOT_PERIOD_USEC;
+    }
+    for (auto &u : urgentQueue_)
+    {
+        if (u.source == source && u.code == code)
+        {
+            // The packet will be generated from the latest state of the
+            // train. Restarts the repeats for the new value.
+            u.repeats = urgentRepeats_;
+            return;
+        }
+    }
+    if (code == ESTOP)
+    {
+        urgentQueue_.push_front({source, code, urgentRepeats_});
+    }
+    else
+    {
+        urgentQueue_.push_back({source, code, urgentRepeats_});
+    }
+}
+
+PriorityUpdateLoop::RefreshEntry *PriorityUpdateLoop::find_entry(
+    PacketSource *source)
+{
+    for (auto &e : refreshSources_)
+    {
+        if (e.source == source)
+        {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+bool PriorityUpdateLoop::take_urgent(UrgentEntry *e, bool allow_same)
+{
+    auto it = urgentQueue_.begin();
+    if (!allow_same)
+    {
+        while (it != urgentQueue_.end() && it->source == lastSource_ &&
+            it->code != ESTOP)
+        {
+            ++it;
+        }
+    }
+    if (it == urgentQueue_.end())
+    {
+        return false;
+    }
+    *e = *it;
+    urgentQueue_.erase(it);
+    return true;
+}
+
+int PriorityUpdateLoop::pick_refresh()
+{
+    int best = -1;
+    uint64_t best_score = 0;
+    for (unsigned i = 0; i < refreshSources_.size(); ++i)
+    {
+        const RefreshEntry &e = refreshSources_[i];
+        uint64_t age = trackUsec_ - e.lastSentUsec;
+        if (age < MIN_REFRESH_SPACING_USEC ||
+            (e.source == lastSource_ && refreshSources_.size() > 1))
+        {
+            continue;
+        }
+        uint64_t score = age;
+        if (trackUsec_ < e.hotUntilUsec)
+        {
+            score *= HOT_WEIGHT;
+        }
+        if (score > best_score)
+        {
+            best = i;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+StateFlowBase::Action PriorityUpdateLoop::entry()
+{
+    Packet *pkt = message()->data();
+    unsigned usec;
+    {
+        AtomicHolder h(this);
+        int idx = -1;
+        UrgentEntry u;
+        PacketSource *source = nullptr;
+        bool urgent =
+            urgentBurst_ < MAX_URGENT_BURST && take_urgent(&u, false);
+        if (!urgent && (idx = pick_refresh()) < 0)
+        {
+            // Nothing else to do, repeating to the same train is okay.
+            urgent = take_urgent(&u, true);
+        }
+        if (urgent)
+        {
+            source = u.source;
+            if (--u.repeats)
+            {
+                urgentQueue_.push_back(u);
+            }
+            ++urgentBurst_;
+            source->get_next_packet(u.code, pkt);
+            usec = packet_usec(*pkt);
+            ++stats_.urgentPackets;
+            stats_.urgentUsec += usec;
+        }
+        else if (idx >= 0)
+        {
+            source = refreshSources_[idx].source;
+            urgentBurst_ = 0;
+            source->get_next_packet(REFRESH, pkt);
+            usec = packet_usec(*pkt);
+            ++stats_.refreshPackets;
+            stats_.refreshUsec += usec;
+        }
+        else
+        {
+            // Nothing is due. We do not want to send another packet to the
+            // same locomotive too quick.
+            urgentBurst_ = 0;
+            pkt->set_dcc_idle();
+            usec = packet_usec(*pkt);
+            ++stats_.idlePackets;
+            stats_.idleUsec += usec;
+        }
+        lastSource_ = source;
+        trackUsec_ += usec;
+        if (source)
+        {
+            RefreshEntry *e = find_entry(source);
+            if (e)
+            {
+                e->lastSentUsec = trackUsec_;
+            }
+        }
+    }
+    // We pass on the filled packet to the track processor.
+    trackSend_->send(transfer_message());
+    return exit();
+}
+
+unsigned PriorityUpdateLoop::packet_usec(const Packet &pkt)
+{
+    if (pkt.header_raw_data & 1)
+    {
+        // Command to the track driver.
+        return 0;
+    }
+    unsigned usec;
+    if (pkt.packet_header.is_marklin)
+    {
+        usec = MM_PACKET_USEC;
+    }
+    else
+    {
+        unsigned ones = pkt.packet_header.send_long_preamble
+            ? DCC_LONG_PREAMBLE_BITS
+            : DCC_PREAMBLE_BITS;
+        unsigned zeros = 0;
+        unsigned ec = 0;
+        for (unsigned i = 0; i < pkt.dlc; ++i)
+        {
+            ec ^= pkt.payload[i];
+            unsigned n = __builtin_popcount(pkt.payload[i]);
+            ones += n;
+            zeros += 8 - n + 1; // with the byte start bit
+        }
+        if (!pkt.packet_header.skip_ec)
+        {
+            unsigned n = __builtin_popcount(ec);
+            ones += n;
+            zeros += 8 - n + 1;
+        }
+        ones += 1; // packet end bit
+        usec = ones * DCC_ONE_USEC + zeros * DCC_ZERO_USEC;
+    }
+    return usec * (1 + pkt.packet_header.rept_count);
+}
+
+} // namespace dcc
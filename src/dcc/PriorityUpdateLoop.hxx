@@ -0,0 +1,210 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file PriorityUpdateLoop.hxx
+ *
+ * Command station update loop that sends changed train state to the track
+ * ahead of the background refresh.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _DCC_PRIORITYUPDATELOOP_HXX_
+#define _DCC_PRIORITYUPDATELOOP_HXX_
+
+#include <deque>
+#include <vector>
+
+#include "dcc/Packet.hxx"
+#include "dcc/UpdateLoop.hxx"
+#include "executor/StateFlow.hxx"
+
+namespace dcc
+{
+
+/// Implementation of a command station update loop that prioritizes user
+/// actions over the background refresh.
+///
+/// - Every packet_processor_notify_update call puts an entry into an urgent
+///   queue. The urgent queue is served ahead of the refresh, so a speed
+///   change goes out in the next packet slot no matter how many trains are
+///   on the refresh list. Each urgent entry is sent multiple times (with
+///   other packets in between) to make up for packets lost on the track. An
+///   entry that is already queued is not duplicated; when it comes up, the
+///   train generates the packet from its freshest state anyway. Emergency
+///   stops jump the queue.
+///
+/// - The background refresh picks the train that has waited the longest
+///   since it last got a packet. The waiting time of trains that changed
+///   recently counts multiple times, so these get refreshed more often than
+///   parked trains.
+///
+/// - All scheduling is done on track time: the sum of the transmission time
+///   of the packets sent so far. The loop keeps account of how much of the
+///   track bandwidth goes to urgent packets, refresh and idle packets.
+///
+/// Usage is the same as @ref SimpleUpdateLoop.
+class PriorityUpdateLoop : public StateFlow<Buffer<dcc::Packet>, QList<1>>,
+                           private UpdateLoopBase
+{
+public:
+    /// Constructor.
+    /// @param service defines which executor to run on.
+    /// @param track_send is where to send the filled packets.
+    /// @param urgent_repeats how many times each urgent packet should be sent
+    /// to the track.
+    PriorityUpdateLoop(Service *service, PacketFlowInterface *track_send,
+        unsigned urgent_repeats = DEFAULT_URGENT_REPEATS);
+    ~PriorityUpdateLoop();
+
+    /// Adds a new refresh source to the background refresh packets.
+    void add_refresh_source(dcc::PacketSource *source) override;
+
+    /// Deletes a packet refresh source, including any pending urgent
+    /// packets for it.
+    void remove_refresh_source(dcc::PacketSource *source) override;
+
+    /// Puts a packet for a source into the urgent queue.
+    /// @param source is the packet source that experienced a change
+    /// @param code is a source-specific value that will be sent to the source
+    /// in the get_next_packet callback.
+    void notify_update(PacketSource *source, unsigned code) override;
+
+    /// Entry to the state flow -- when a new packet needs to be sent.
+    Action entry() override;
+
+    /// Track bandwidth accounting. All times are in usec of track time.
+    struct Stats
+    {
+        /// Number of packets sent from the urgent queue.
+        unsigned urgentPackets{0};
+        /// Number of background refresh packets sent.
+        unsigned refreshPackets{0};
+        /// Number of idle packets sent.
+        unsigned idlePackets{0};
+        /// Track time used by urgent packets.
+        uint64_t urgentUsec{0};
+        /// Track time used by refresh packets.
+        uint64_t refreshUsec{0};
+        /// Track time used by idle packets.
+        uint64_t idleUsec{0};
+    };
+
+    /// @return the bandwidth accounting data.
+    const Stats &stats()
+    {
+        return stats_;
+    }
+
+    /// @return the track time elapsed since the loop started, in usec.
+    uint64_t track_usec()
+    {
+        return trackUsec_;
+    }
+
+    /// Computes how long it takes to send a packet to the track. This is an
+    /// estimate; the exact value depends on the settings of the driver.
+    /// @param pkt is the packet to send, including the repeat count.
+    /// @return the transmission time in usec.
+    static unsigned packet_usec(const Packet &pkt);
+
+    /// Default for the number of times an urgent packet is sent.
+    static constexpr unsigned DEFAULT_URGENT_REPEATS = 2;
+    /// How many urgent packets may go out in a row before a refresh packet
+    /// is interleaved.
+    static constexpr unsigned MAX_URGENT_BURST = 4;
+    /// Minimum track time between two refresh packets to the same train.
+    static constexpr unsigned MIN_REFRESH_SPACING_USEC = 5000;
+    /// For this long after a change, a train counts as recently changed.
+    static constexpr unsigned HOT_PERIOD_USEC = 10000000;
+    /// The waiting time of recently changed trains is multiplied by this
+    /// factor in the refresh scheduler.
+    static constexpr unsigned HOT_WEIGHT = 4;
+
+private:
+    /// Scheduling state of a refresh source.
+    struct RefreshEntry
+    {
+        /// The train.
+        PacketSource *source;
+        /// Track time when a packet was last sent to this train.
+        uint64_t lastSentUsec;
+        /// The train counts as recently changed until this track time.
+        uint64_t hotUntilUsec;
+    };
+
+    /// A pending urgent packet.
+    struct UrgentEntry
+    {
+        /// The train.
+        PacketSource *source;
+        /// Code to pass to get_next_packet.
+        unsigned code;
+        /// How many more times to send this packet.
+        unsigned repeats;
+    };
+
+    /// Removes the next urgent entry from the queue. Must be called with the
+    /// lock held.
+    /// @param e will be filled in with the entry.
+    /// @param allow_same if false, entries for the train that got the
+    /// previous packet are skipped (except emergency stops), to avoid
+    /// sending back to back packets to the same train.
+    /// @return false if there was no suitable entry in the queue.
+    bool take_urgent(UrgentEntry *e, bool allow_same);
+
+    /// Selects the train to refresh next. Must be called with the lock held.
+    /// @return the index in refreshSources_, or -1 if no train is due for a
+    /// refresh.
+    int pick_refresh();
+
+    /// @return the refresh entry for a given source, or nullptr if it is not
+    /// on the refresh list. Must be called with the lock held.
+    /// @param source is the train to look up.
+    RefreshEntry *find_entry(PacketSource *source);
+
+    /// Place where we forward the packets filled in.
+    PacketFlowInterface *trackSend_;
+    /// Packet sources to ask about refreshing data periodically.
+    std::vector<RefreshEntry> refreshSources_;
+    /// Pending packets for changed trains.
+    std::deque<UrgentEntry> urgentQueue_;
+    /// Bandwidth accounting.
+    Stats stats_;
+    /// Track time of all packets sent so far.
+    uint64_t trackUsec_{0};
+    /// The last train we sent a packet to.
+    PacketSource *lastSource_{nullptr};
+    /// How many times to send each urgent packet.
+    unsigned urgentRepeats_;
+    /// How many urgent packets went out since the last refresh packet.
+    unsigned urgentBurst_{0};
+};
+
+} // namespace dcc
+
+#endif // _DCC_PRIORITYUPDATELOOP_HXX_
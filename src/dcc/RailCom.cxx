@@ -79,6 +79,76 @@ const uint8_t railcom_decode[256] =
        INV,    INV,    INV,    INV,    INV,    INV,    INV,    INV,
 };
 
+/// Length value in @ref railcom_first_byte for bytes that do not start a
+/// valid datagram.
+static constexpr uint8_t LEN_GARBAGE = 0;
+/// Length value in @ref railcom_first_byte for packet IDs whose length we
+/// do not know.
+static constexpr uint8_t LEN_UNKNOWN = 15;
+
+/// @return the RailcomPacket type for a mobile decoder packet id, or
+/// GARBAGE for unknown ids. @param id is the packet id.
+static constexpr uint8_t railcom_mob_type(unsigned id)
+{
+    return id == RMOB_POM ? RailcomPacket::MOB_POM
+        : id == RMOB_ADRHIGH ? RailcomPacket::MOB_ADRHIGH
+        : id == RMOB_ADRLOW ? RailcomPacket::MOB_ADRLOW
+        : id == RMOB_EXT ? RailcomPacket::MOB_EXT
+        : id == RMOB_DYN ? RailcomPacket::MOB_DYN
+                         : RailcomPacket::GARBAGE;
+}
+
+/// @return the datagram length in bytes for a mobile decoder packet id.
+/// POM is listed as 2; the 6-byte form is detected from the payload. @param
+/// id is the packet id.
+static constexpr uint8_t railcom_mob_len(unsigned id)
+{
+    // TODO: according to the standard RMOB_EXT should be a len==3 packet,
+    // but the ESU LokPilot 3 is sending it as 2-byte packet.
+    return id == RMOB_DYN ? 3
+        : (id == RMOB_POM || id == RMOB_ADRHIGH || id == RMOB_ADRLOW ||
+              id == RMOB_EXT)
+        ? 2
+        : LEN_UNKNOWN;
+}
+
+/// @return the classification of a decoded railcom byte when it starts a
+/// datagram: the RailcomPacket type in the low nibble and the datagram
+/// length in the high nibble. @param d is the value from railcom_decode.
+static constexpr uint8_t railcom_classify(uint8_t d)
+{
+    return d == RailcomDefs::ACK ? (RailcomPacket::ACK | (1 << 4))
+        : d == RailcomDefs::NACK ? (RailcomPacket::NACK | (1 << 4))
+        : d == RailcomDefs::BUSY ? (RailcomPacket::BUSY | (1 << 4))
+        : d >= 64 ? (RailcomPacket::GARBAGE | (LEN_GARBAGE << 4))
+                  : (railcom_mob_type(d >> 2) | (railcom_mob_len(d >> 2) << 4));
+}
+
+/// Expands to the classification of four consecutive raw bytes.
+#define RC_CLASS_4(b)                                                          \
+    railcom_classify(railcom_decode[b]),                                       \
+        railcom_classify(railcom_decode[b + 1]),                               \
+        railcom_classify(railcom_decode[b + 2]),                               \
+        railcom_classify(railcom_decode[b + 3])
+/// Expands to the classification of 16 consecutive raw bytes.
+#define RC_CLASS_16(b)                                                         \
+    RC_CLASS_4(b), RC_CLASS_4(b + 4), RC_CLASS_4(b + 8), RC_CLASS_4(b + 12)
+/// Expands to the classification of 64 consecutive raw bytes.
+#define RC_CLASS_64(b)                                                         \
+    RC_CLASS_16(b), RC_CLASS_16(b + 16), RC_CLASS_16(b + 32),                  \
+        RC_CLASS_16(b + 48)
+
+/// Lookup table from the raw (4/8 encoded) railcom byte that starts a
+/// datagram to the datagram type and length. See @ref railcom_classify. The
+/// elements of the const railcom_decode table are constant expressions, so
+/// this table is computed by the compiler.
+static constexpr uint8_t railcom_first_byte[256] = {
+    RC_CLASS_64(0), RC_CLASS_64(64), RC_CLASS_64(128), RC_CLASS_64(192)};
+
+#undef RC_CLASS_64
+#undef RC_CLASS_16
+#undef RC_CLASS_4
+
 /// Helper function to parse a part of a railcom packet.
 ///
 /// @param fb_channel Which hardware channel did the railcom message arrive
@@ -91,108 +161,60 @@ const uint8_t railcom_decode[256] =
 /// @param output where to put the decoded packets (or GARBAGE packets if
 /// decoding fails).
 ///
-void parse_internal(uint8_t fb_channel, uint8_t railcom_channel,
+static void parse_internal(uint8_t fb_channel, uint8_t railcom_channel,
     const uint8_t *ptr, unsigned size,
     std::vector<struct RailcomPacket> *output)
 {
-    if (!size)
-        return;
     for (unsigned ofs = 0; ofs < size; ++ofs)
     {
-        uint8_t decoded = railcom_decode[ptr[ofs]];
-        uint8_t type = 0xff;
-        uint32_t arg = 0;
-        if (decoded == RailcomDefs::ACK)
-        {
-            type = RailcomPacket::ACK;
-        }
-        else if (decoded == RailcomDefs::NACK)
-        {
-            type = RailcomPacket::NACK;
-        }
-        else if (decoded == RailcomDefs::BUSY)
-        {
-            type = RailcomPacket::BUSY;
-        }
-        else if (decoded >= 64)
-        {
-            output->emplace_back(
-                fb_channel, railcom_channel, RailcomPacket::GARBAGE, 0);
-            break;
-        }
-        if (type != 0xff)
+        uint8_t cls = railcom_first_byte[ptr[ofs]];
+        uint8_t type = cls & 0xf;
+        unsigned len = cls >> 4;
+        if (len == 1)
         {
+            // ACK, NACK, BUSY
             output->emplace_back(fb_channel, railcom_channel, type, 0);
             continue;
         }
-        // Now: we have a packet.
-        uint8_t packet_id = decoded >> 2;
-        uint8_t len = 2;
-        arg = decoded & 3;
-        switch (packet_id)
+        if (type == RailcomPacket::MOB_POM && size == 6 && ofs == 0
+            // The ESU LokPilot V4 decoder fills the CV read (a 2-byte
+            // packet) with four NACK bytes, presumably to report that it is
+            // not actually giving back a 32-bit response but only an 8-bit
+            // response.
+            && railcom_decode[ptr[2]] < 64)
         {
-            case RMOB_ADRHIGH:
-                type = RailcomPacket::MOB_ADRHIGH;
-                break;
-            case RMOB_ADRLOW:
-                type = RailcomPacket::MOB_ADRLOW;
-                break;
-            case RMOB_EXT:
-                type = RailcomPacket::MOB_EXT;
-                // TODO: according to the standardthis should be a len==3
-                // packet, but the ESU LokPilot 3 is sending it as 2-byte
-                // packet.
-                break;
-            case RMOB_POM:
-                type = RailcomPacket::MOB_POM;
-                if (size == 6 && ofs == 0
-                    // The ESU LokPilot V4 decoder fills the CV read (a 2-byte
-                    // packet) with four NACK bytes, presumably to report that
-                    // it is not actually giving back a 32-bit response but
-                    // only an 8-bit response.
-                    && railcom_decode[ptr[2]] < 64)
-                {
-                    len = 6;
-                }
-                else
-                {
-                    len = 2;
-                }
-                break;
-            case RMOB_DYN:
-                type = RailcomPacket::MOB_DYN;
-                len = 3;
-                break;
-            default:
-                // Don't know the size of the fragment. Throws out response.
-                len = 255;
-                break;
+            len = 6;
         }
-        if (ofs + len > size)
+        if (len == LEN_GARBAGE || len == LEN_UNKNOWN || ofs + len > size)
         {
-            // The expected message size does not fit.
+            // Invalid byte, or the expected message size does not fit.
             output->emplace_back(
                 fb_channel, railcom_channel, RailcomPacket::GARBAGE, 0);
             break;
         }
-        for (int i = 1; i < len; ++i, ++ofs)
+        // Assembles the payload: two bits from the first byte and six from
+        // each further one, so at most 32 bits for a 6-byte packet. Any
+        // invalid byte sets one of the top two bits in the accumulated OR.
+        uint32_t arg = railcom_decode[ptr[ofs]] & 3;
+        uint8_t bad = 0;
+        for (unsigned i = 1; i < len; ++i)
         {
-            arg <<= 6;
-            uint8_t decoded = railcom_decode[ptr[ofs + 1]];
-            if (decoded >= 64)
-            {
-                type = RailcomPacket::GARBAGE;
-            }
-            arg |= decoded;
+            uint8_t d = railcom_decode[ptr[ofs + i]];
+            bad |= d;
+            arg = (arg << 6) | d;
         }
-        output->emplace_back(fb_channel, railcom_channel, type, arg);
+        ofs += len - 1;
+        output->emplace_back(fb_channel, railcom_channel,
+            (bad & 0xC0) ? (uint8_t)RailcomPacket::GARBAGE : type, arg);
     }
 }
 
-void parse_railcom_data(
+/// Appends the decoded packets of one feedback to the output list.
+/// @param fb is the feedback to decode.
+/// @param output is the list to append to.
+static void parse_one(
     const dcc::Feedback &fb, std::vector<struct RailcomPacket> *output)
 {
-    output->clear();
     if (fb.channel == 0xff)
         return; // Occupancy feedback information
     if (fb.ch1Size == 1 && (railcom_decode[fb.ch1Data[0]] != RailcomDefs::INV) && fb.ch2Size >= 1)
@@ -208,21 +230,36 @@ void parse_railcom_data(
         parse_internal(fb.channel, 2, data, fb.ch1Size + fb.ch2Size, output);
         return;
     }
-    for (bool ch1 : {true, false})
+    parse_internal(fb.channel, 1, fb.ch1Data, fb.ch1Size, output);
+    parse_internal(fb.channel, 2, fb.ch2Data, fb.ch2Size, output);
+}
+
+void parse_railcom_data(
+    const dcc::Feedback &fb, std::vector<struct RailcomPacket> *output)
+{
+    output->clear();
+    parse_one(fb, output);
+}
+
+void parse_railcom_data(const dcc::Feedback *fb, unsigned count,
+    std::vector<struct RailcomPacket> *output, std::vector<unsigned> *first)
+{
+    output->clear();
+    if (first)
     {
-        uint8_t size;
-        const uint8_t *ptr;
-        if (ch1)
-        {
-            size = fb.ch1Size;
-            ptr = fb.ch1Data;
-        }
-        else
+        first->resize(count + 1);
+    }
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (first)
         {
-            size = fb.ch2Size;
-            ptr = fb.ch2Data;
+            (*first)[i] = output->size();
         }
-        parse_internal(fb.channel, ch1 ? 1 : 2, ptr, size, output);
+        parse_one(fb[i], output);
+    }
+    if (first)
+    {
+        (*first)[count] = output->size();
     }
 }
 
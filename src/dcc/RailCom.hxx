@@ -166,6 +166,21 @@ struct RailcomPacket
 void parse_railcom_data(
     const dcc::Feedback &fb, std::vector<struct RailcomPacket> *output);
 
+/** Interprets the data from many railcom feedbacks at once, such as all
+ * channels of a multi-channel detector after a cutout. The decoded packets
+ * of all feedbacks are put into the output list in order; occupancy-only
+ * feedbacks produce no packets.
+ *
+ * @param fb is an array of feedbacks.
+ * @param count is the number of entries in fb.
+ * @param output will be cleared and filled with the decoded packets.
+ * @param first if not null, will be resized to count + 1 entries. Entry i is
+ * the index in output of the first packet of fb[i]; entry count is the size
+ * of output. */
+void parse_railcom_data(const dcc::Feedback *fb, unsigned count,
+    std::vector<struct RailcomPacket> *output,
+    std::vector<unsigned> *first = nullptr);
+
 }  // namespace dcc
 
 #endif // _DCC_RAILCOM_HXX_
@@ -0,0 +1,255 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file RailcomTracker.cxx
+ *
+ * Tracks occupancy and RailCom broadcast addresses for many detector channels
+ *  * and reports the changes as OpenLCB events.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+
+#include "dcc/RailcomTracker.hxx"
+
+#include <string.h>
+
+#include "openlcb/If.hxx"
+#include "openlcb/Node.hxx"
+#include "os/os.h"
+
+namespace dcc
+{
+
+constexpr uint8_t RailcomTracker::OCCUPANCY_DEBOUNCE;
+constexpr uint8_t RailcomTracker::ADDRESS_REPEAT;
+constexpr uint32_t RailcomTracker::ADDRESS_TIMEOUT_MSEC;
+
+RailcomTracker::RailcomTracker(unsigned num_channels)
+    : channels_(num_channels)
+{
+    HASSERT(num_channels <= 64);
+}
+
+void RailcomTracker::process(const Feedback *fb, unsigned count,
+    uint32_t now_msec, std::vector<Transition> *out)
+{
+    parse_railcom_data(fb, count, &packets_, &first_);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (fb[i].channel == 0xff)
+        {
+            process_occupancy(fb[i], out);
+            continue;
+        }
+        if (fb[i].channel >= channels_.size())
+        {
+            continue;
+        }
+        for (unsigned j = first_[i]; j < first_[i + 1]; ++j)
+        {
+            const RailcomPacket &p = packets_[j];
+            if (p.type == RailcomPacket::MOB_ADRHIGH ||
+                p.type == RailcomPacket::MOB_ADRLOW)
+            {
+                process_address(p.hw_channel, p.type, p.argument, now_msec,
+                    out);
+            }
+        }
+    }
+    for (unsigned ch = 0; ch < channels_.size(); ++ch)
+    {
+        if (channels_[ch].address &&
+            now_msec - channels_[ch].lastSeenMsec > ADDRESS_TIMEOUT_MSEC)
+        {
+            clear_address(ch, out);
+        }
+    }
+}
+
+void RailcomTracker::process_occupancy(
+    const Feedback &fb, std::vector<Transition> *out)
+{
+    uint8_t mask[8] = {0};
+    memcpy(mask, fb.ch1Data, fb.ch1Size);
+    memcpy(mask + fb.ch1Size, fb.ch2Data, fb.ch2Size);
+    for (unsigned ch = 0; ch < channels_.size(); ++ch)
+    {
+        Channel &c = channels_[ch];
+        bool sample = (mask[ch >> 3] >> (ch & 7)) & 1;
+        if (sample == c.occupied)
+        {
+            c.debounce = 0;
+            continue;
+        }
+        if (++c.debounce < OCCUPANCY_DEBOUNCE)
+        {
+            continue;
+        }
+        c.debounce = 0;
+        c.occupied = sample;
+        out->push_back({(uint8_t)ch,
+            sample ? Transition::OCCUPIED : Transition::CLEAR, 0});
+        if (!sample)
+        {
+            clear_address(ch, out);
+        }
+    }
+}
+
+void RailcomTracker::process_address(unsigned ch, uint8_t type,
+    uint8_t payload, uint32_t now_msec, std::vector<Transition> *out)
+{
+    Channel &c = channels_[ch];
+    if (type == RailcomPacket::MOB_ADRHIGH)
+    {
+        if (c.high == payload && c.highCount)
+        {
+            if (c.highCount < ADDRESS_REPEAT)
+            {
+                ++c.highCount;
+            }
+        }
+        else
+        {
+            c.high = payload;
+            c.highCount = 1;
+        }
+    }
+    else
+    {
+        if (c.low == payload && c.lowCount)
+        {
+            if (c.lowCount < ADDRESS_REPEAT)
+            {
+                ++c.lowCount;
+            }
+        }
+        else
+        {
+            c.low = payload;
+            c.lowCount = 1;
+        }
+    }
+    if (c.highCount < ADDRESS_REPEAT || c.lowCount < ADDRESS_REPEAT)
+    {
+        return;
+    }
+    uint16_t address = (uint16_t(c.high) << 8) | c.low;
+    c.lastSeenMsec = now_msec;
+    if (address == c.address)
+    {
+        return;
+    }
+    if (c.address)
+    {
+        out->push_back({(uint8_t)ch, Transition::ADDRESS_LEAVE, c.address});
+    }
+    c.address = address;
+    out->push_back({(uint8_t)ch, Transition::ADDRESS_ENTER, address});
+}
+
+void RailcomTracker::clear_address(unsigned ch, std::vector<Transition> *out)
+{
+    Channel &c = channels_[ch];
+    c.highCount = 0;
+    c.lowCount = 0;
+    if (c.address)
+    {
+        out->push_back({(uint8_t)ch, Transition::ADDRESS_LEAVE, c.address});
+        c.address = 0;
+    }
+}
+
+RailcomTrackerFlow::RailcomTrackerFlow(RailcomHubFlow *hub,
+    openlcb::Node *node, unsigned num_channels, uint64_t occupancy_base,
+    uint64_t identification_base)
+    : RailcomHubPort(hub->service())
+    , hub_(hub)
+    , node_(node)
+    , tracker_(num_channels)
+    , occupancyBase_(occupancy_base)
+    , identificationBase_(identification_base)
+{
+    HASSERT((identification_base & 0xFFFFFF) == 0);
+    hub_->register_port(this);
+}
+
+RailcomTrackerFlow::~RailcomTrackerFlow()
+{
+    hub_->unregister_port(this);
+}
+
+uint64_t RailcomTrackerFlow::event_for(const RailcomTracker::Transition &t)
+{
+    switch (t.type)
+    {
+        case RailcomTracker::Transition::OCCUPIED:
+            return occupancyBase_ + 2 * t.channel;
+        case RailcomTracker::Transition::CLEAR:
+            return occupancyBase_ + 2 * t.channel + 1;
+        case RailcomTracker::Transition::ADDRESS_ENTER:
+            return identificationBase_ | (uint64_t(t.channel) << 17) |
+                t.address;
+        case RailcomTracker::Transition::ADDRESS_LEAVE:
+        default:
+            return identificationBase_ | (uint64_t(t.channel) << 17) |
+                (1 << 16) | t.address;
+    }
+}
+
+StateFlowBase::Action RailcomTrackerFlow::entry()
+{
+    uint32_t now_msec = os_get_time_monotonic() / 1000000;
+    tracker_.process(message()->data(), 1, now_msec, &pending_);
+    release();
+    nextPending_ = 0;
+    return call_immediately(STATE(send_next));
+}
+
+StateFlowBase::Action RailcomTrackerFlow::send_next()
+{
+    if (nextPending_ >= pending_.size())
+    {
+        pending_.clear();
+        return exit();
+    }
+    return allocate_and_call(
+        node_->iface()->global_message_write_flow(), STATE(event_allocated));
+}
+
+StateFlowBase::Action RailcomTrackerFlow::event_allocated()
+{
+    auto *b =
+        get_allocation_result(node_->iface()->global_message_write_flow());
+    b->data()->reset(openlcb::Defs::MTI_EVENT_REPORT, node_->node_id(),
+        openlcb::eventid_to_buffer(event_for(pending_[nextPending_++])));
+    node_->iface()->global_message_write_flow()->send(b);
+    return call_immediately(STATE(send_next));
+}
+
+} // namespace dcc
@@ -0,0 +1,261 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file RailcomTracker.hxx
+ *
+ * Tracks occupancy and RailCom broadcast addresses for many detector channels
+ *  * and reports the changes as OpenLCB events.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+
+#ifndef _DCC_RAILCOMTRACKER_HXX_
+#define _DCC_RAILCOMTRACKER_HXX_
+
+#include <vector>
+
+#include "dcc/RailCom.hxx"
+#include "dcc/RailcomHub.hxx"
+
+namespace openlcb
+{
+class Node;
+}
+
+namespace dcc
+{
+
+/// Occupancy and locomotive address tracking for a multi-channel RailCom
+/// detector. This is the same logic as @ref RailcomBroadcastDecoder, but
+/// the state of all channels is kept in one compact array, and a batch of
+/// feedbacks is processed in one pass, with only the changes being reported.
+///
+/// Input:
+///
+/// - Feedbacks with channel == 0xff carry occupancy samples. The ch1 and ch2
+///   data bytes together form a bitmask: channel i is occupied if bit (i % 8)
+///   of byte (i / 8) is set. Detectors with up to eight channels only send a
+///   single ch1 byte; missing bytes count as unoccupied.
+///
+/// - All other feedbacks carry the RailCom data of the channel given in the
+///   feedback. Only the address broadcast (ADR_HIGH / ADR_LOW datagrams) is
+///   used.
+///
+/// Debouncing and timeouts:
+///
+/// - The occupancy of a channel changes when OCCUPANCY_DEBOUNCE consecutive
+///   samples disagree with the current state.
+///
+/// - An address is accepted when both halves were received ADDRESS_REPEAT
+///   times in a row. A different address on the same channel replaces the
+///   previous one.
+///
+/// - An address is dropped when the channel goes unoccupied, or when it was
+///   not received for ADDRESS_TIMEOUT_MSEC. Timeouts are checked at the end
+///   of each process() call, so the detector has to keep sending feedbacks
+///   (the occupancy samples suffice).
+class RailcomTracker
+{
+public:
+    /// @param num_channels how many detector channels to track (at most 64).
+    RailcomTracker(unsigned num_channels);
+
+    /// A change in the state of a channel.
+    struct Transition
+    {
+        /// What happened.
+        enum Type : uint8_t
+        {
+            /// The channel became occupied.
+            OCCUPIED,
+            /// The channel became free.
+            CLEAR,
+            /// A locomotive address appeared in the channel.
+            ADDRESS_ENTER,
+            /// A locomotive address is not present in the channel anymore.
+            ADDRESS_LEAVE,
+        };
+
+        /// Which detector channel.
+        uint8_t channel;
+        /// What happened.
+        Type type;
+        /// For ADDRESS_ENTER and ADDRESS_LEAVE: the 16-bit broadcast address
+        /// (ADR_HIGH in the high byte, ADR_LOW in the low byte).
+        uint16_t address;
+    };
+
+    /// Processes a batch of feedbacks.
+    /// @param fb is an array of feedbacks.
+    /// @param count is the number of entries in fb.
+    /// @param now_msec is the current time in milliseconds (may wrap).
+    /// @param out the changes will be appended here.
+    void process(const Feedback *fb, unsigned count, uint32_t now_msec,
+        std::vector<Transition> *out);
+
+    /// @return the number of tracked channels.
+    unsigned size()
+    {
+        return channels_.size();
+    }
+
+    /// @return true if the channel is occupied. @param ch is the channel.
+    bool occupied(unsigned ch)
+    {
+        return channels_[ch].occupied;
+    }
+
+    /// @return the address present in a channel, or 0 if none.
+    /// @param ch is the channel.
+    uint16_t address(unsigned ch)
+    {
+        return channels_[ch].address;
+    }
+
+    /// How many consecutive occupancy samples are needed to change state.
+    static constexpr uint8_t OCCUPANCY_DEBOUNCE = 3;
+    /// How many times in a row each address half has to be received.
+    static constexpr uint8_t ADDRESS_REPEAT = 3;
+    /// How long an address is kept without seeing it again.
+    static constexpr uint32_t ADDRESS_TIMEOUT_MSEC = 1000;
+
+private:
+    /// State of one detector channel.
+    struct Channel
+    {
+        /// Reported address, 0 if none.
+        uint16_t address{0};
+        /// Last received ADR_HIGH payload.
+        uint8_t high{0};
+        /// Last received ADR_LOW payload.
+        uint8_t low{0};
+        /// When the reported address was last received.
+        uint32_t lastSeenMsec{0};
+        /// How many times in a row high was received.
+        uint8_t highCount : 2;
+        /// How many times in a row low was received.
+        uint8_t lowCount : 2;
+        /// Reported occupancy.
+        uint8_t occupied : 1;
+        /// How many consecutive samples disagreed with occupied.
+        uint8_t debounce : 2;
+
+        Channel()
+            : highCount(0)
+            , lowCount(0)
+            , occupied(0)
+            , debounce(0)
+        {
+        }
+    };
+
+    /// Handles an occupancy sample. @param fb is the feedback with the
+    /// bitmask. @param out collects the changes.
+    void process_occupancy(const Feedback &fb, std::vector<Transition> *out);
+
+    /// Handles a decoded address half.
+    /// @param ch is the channel. @param type is MOB_ADRHIGH or MOB_ADRLOW.
+    /// @param payload is the datagram payload. @param now_msec is the
+    /// current time. @param out collects the changes.
+    void process_address(unsigned ch, uint8_t type, uint8_t payload,
+        uint32_t now_msec, std::vector<Transition> *out);
+
+    /// Forgets the address in a channel and reports it if there was one.
+    /// @param ch is the channel. @param out collects the changes.
+    void clear_address(unsigned ch, std::vector<Transition> *out);
+
+    /// Per-channel state.
+    std::vector<Channel> channels_;
+    /// Scratch space for the decoder.
+    std::vector<RailcomPacket> packets_;
+    /// Scratch space for the decoder.
+    std::vector<unsigned> first_;
+};
+
+/// Registers to a RailCom hub and reports the changes found by a
+/// @ref RailcomTracker as OpenLCB event reports.
+///
+/// Event IDs:
+///
+/// - occupancy_base + 2 * channel: channel occupied;
+///   occupancy_base + 2 * channel + 1: channel clear.
+///
+/// - identification_base | (channel << 17) | address: the address appeared
+///   in the channel; the same with bit 16 set: the address left the
+///   channel. The lowest three bytes of identification_base must be zero.
+class RailcomTrackerFlow : public RailcomHubPort
+{
+public:
+    /// @param hub is the RailCom hub to listen to.
+    /// @param node is the virtual node that will send the events.
+    /// @param num_channels how many detector channels to track.
+    /// @param occupancy_base first occupancy event ID.
+    /// @param identification_base base of the identification event IDs.
+    RailcomTrackerFlow(RailcomHubFlow *hub, openlcb::Node *node,
+        unsigned num_channels, uint64_t occupancy_base,
+        uint64_t identification_base);
+
+    ~RailcomTrackerFlow();
+
+    /// @return the tracker engine (for inspecting the current state).
+    RailcomTracker *tracker()
+    {
+        return &tracker_;
+    }
+
+    /// @return the event ID to send for a transition. @param t is the change.
+    uint64_t event_for(const RailcomTracker::Transition &t);
+
+private:
+    Action entry() override;
+
+    /// Sends the next pending event report. @return next action.
+    Action send_next();
+
+    /// Fills in an event report. @return next action.
+    Action event_allocated();
+
+    /// Hub we are registered to.
+    RailcomHubFlow *hub_;
+    /// Node sending the events.
+    openlcb::Node *node_;
+    /// Tracker engine.
+    RailcomTracker tracker_;
+    /// Base of the occupancy events.
+    uint64_t occupancyBase_;
+    /// Base of the identification events.
+    uint64_t identificationBase_;
+    /// Changes still to be reported.
+    std::vector<RailcomTracker::Transition> pending_;
+    /// Next entry in pending_ to report.
+    unsigned nextPending_{0};
+};
+
+} // namespace dcc
+
+#endif // _DCC_RAILCOMTRACKER_HXX_
@@ -288,6 +288,7 @@ protected:
         }
         MessageType *copy = this->get_allocation_result(h);
         copy->set_done(this->message()->new_child());
+        copy->set_timestamp(this->message()->timestamp());
         *copy->data() = *this->message()->data();
         h->send(copy);
         return call_immediately(STATE(clone_done));
@@ -55,8 +55,10 @@ extern "C" {
 }
 #endif
 
+#include "executor/ExecutorProfiler.hxx"
 #include "executor/Service.hxx"
 #include "nmranet_config.h"
+#include "utils/Metrics.hxx"
 
 ExecutorBase *ExecutorBase::list = NULL;
 
@@ -70,9 +72,11 @@ Executable::~Executable() {
 /** Constructor.
  */
 ExecutorBase::ExecutorBase()
-    : name_(NULL) /** @todo (Stuart Baker) is "name" still in use? */
+    : profiler_(nullptr)
+    , name_(NULL) /** @todo (Stuart Baker) is "name" still in use? */
     , next_(NULL)
     , activeTimers_(this)
+    , profilerStorage_(nullptr)
     , done_(0)
     , started_(0)
     , selectPrescaler_(0)
@@ -187,12 +191,54 @@ bool ExecutorBase::loop_once()
         done_ = 1;
         return false;
     }
-    current_ = msg;
-    msg->run();
-    current_ = nullptr;
+    run_executable(msg, priority);
     return true;
 }
 
+void ExecutorBase::enable_profiling(bool enable)
+{
+    if (!enable)
+    {
+        profiler_ = nullptr;
+        return;
+    }
+    if (!profilerStorage_)
+    {
+        profilerStorage_ = new ExecutorProfiler();
+    }
+    else if (!profiler_)
+    {
+        // Enqueue times recorded before profiling was last turned off are
+        // stale.
+        profilerStorage_->clear_pending();
+    }
+    profiler_ = profilerStorage_;
+}
+
+void ExecutorBase::profile_add(Executable *msg, unsigned band)
+{
+    ExecutorProfiler *p = profiler_;
+    if (!p)
+    {
+        queue_insert(msg, band);
+        return;
+    }
+    p->enqueued(band, [this, msg, band]() { queue_insert(msg, band); });
+}
+
+void ExecutorBase::profile_run(
+    ExecutorProfiler *p, Executable *msg, unsigned priority)
+{
+    const void *type = ExecutorProfiler::type_key(msg);
+    const char *type_name = ExecutorProfiler::type_name(msg);
+    long long start = OSTime::get_monotonic();
+    msg->run();
+    p->record_run(type, type_name, priority, start, OSTime::get_monotonic());
+    // Resynchronizes the enqueue timestamps with the queue, in case some
+    // executables were added without going through profile_add.
+    p->clear_pending_if([this]() { return empty(); });
+}
+
 long long ICACHE_FLASH_ATTR  ExecutorBase::loop_some() {
     for (int i = 12; i > 0; --i) {
         Executable *msg = nullptr;
@@ -210,9 +256,7 @@ long long ICACHE_FLASH_ATTR  ExecutorBase::loop_some() {
         }
         if (msg != NULL)
         {
-            current_ = msg;
-            msg->run();
-            current_ = nullptr;
+            run_executable(msg, priority);
         }
     }
     // Still stuff pending to run.
@@ -317,9 +361,7 @@ void *ExecutorBase::entry()
         if (msg != NULL)
         {
             ++sequence_;
-            current_ = msg;
-            msg->run();
-            current_ = nullptr;
+            run_executable(msg, priority);
         }
     }
 
@@ -434,4 +476,25 @@ ExecutorBase::~ExecutorBase()
     {
         shutdown();
     }
+    delete profilerStorage_;
+}
+
+void ExecutorBase::register_metrics(const char *prefix)
+{
+    if (!METRICS_ENABLED)
+    {
+        return;
+    }
+    MetricsRegistry *r = MetricsRegistry::instance();
+    std::string p(prefix);
+    r->add_gauge(this, p + ".queue", [this]() { return pending(); });
+    r->add_gauge(this, p + ".runs", [this]() { return sequence(); });
+}
+
+void ExecutorBase::unregister_metrics()
+{
+    if (METRICS_ENABLED)
+    {
+        MetricsRegistry::instance()->remove(this);
+    }
 }
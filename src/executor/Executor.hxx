@@ -55,6 +55,7 @@ extern "C" {
 #endif
 
 class ActiveTimers;
+class ExecutorProfiler;
 
 /** This class implements an execution of tasks pulled off an input queue.
  */
@@ -155,7 +156,35 @@ public:
     /// @return a number that gets incremented by one every time an executable
     /// runs.
     virtual uint32_t sequence() = 0;
-    
+
+    /// @return the number of executables waiting in the queue.
+    virtual size_t pending() = 0;
+
+    /// Exports the queue depth and run count of this executor into the
+    /// MetricsRegistry.
+    /// @param prefix is prepended to the metric names, e.g. "executor.main".
+    void register_metrics(const char *prefix);
+
+    /// Turns on or off collecting run time statistics on this executor. The
+    /// profiler is allocated upon the first enable and kept (with its
+    /// statistics) when profiling is turned off.
+    /// @param enable true to start profiling, false to stop.
+    void enable_profiling(bool enable);
+
+    /// @return the profiler of this executor, or nullptr if profiling was
+    /// never enabled. The statistics can be read even when profiling is
+    /// currently off.
+    ExecutorProfiler *profiler()
+    {
+        return profilerStorage_;
+    }
+
+    /// @return the profiler if profiling is currently enabled, else nullptr.
+    ExecutorProfiler *active_profiler()
+    {
+        return profiler_;
+    }
+
 protected:
     /** Thread entry point.
      * @return Should never return
@@ -164,9 +193,24 @@ protected:
 
     void run() override {}
 
+    /// Removes the metrics of this executor from the MetricsRegistry. Called
+    /// by the destructor of the derived class, because the gauges call its
+    /// virtual functions.
+    void unregister_metrics();
+
+    /// Adds an executable to the queue and records its enqueue time for the
+    /// profiler. The timestamp and the queue insertion happen under the same
+    /// lock, so that the timestamps of each band stay in queue order.
+    /// @param msg Executable instance to insert into the input queue
+    /// @param band priority band the executable is enqueued into
+    void profile_add(Executable *msg, unsigned band);
+
     /** Helper object for interruptible select calls. */
     OSSelectWakeup selectHelper_;
 
+    /// Profiler collecting statistics; nullptr when profiling is off.
+    ExecutorProfiler *volatile profiler_;
+
 private:
 #ifndef ESP_NONOS
     /** Wait for an item from the front of the queue.
@@ -191,6 +235,12 @@ private:
      */
     virtual Executable *next(unsigned *priority) = 0;
 
+    /** Inserts an item into the queue, bypassing the profiler.
+     * @param msg Executable instance to insert into the input queue
+     * @param priority priority band, already clamped
+     */
+    virtual void queue_insert(Executable *msg, unsigned priority) = 0;
+
     /** Executes a select call, and schedules any necessary executables based
      * on the return. Will not sleep at all if not empty, otherwise sleeps at
      * most next_timer_nsec nanoseconds (from now).
@@ -198,6 +248,31 @@ private:
      * @param next_timer_nsec is the maximum time to sleep in nanoseconds. */
     void wait_with_select(long long next_timer_nsec);
 
+    /// Runs an executable that was taken off the queue.
+    /// @param msg the executable to run
+    /// @param priority priority band the executable was taken from
+    void run_executable(Executable *msg, unsigned priority)
+    {
+        current_ = msg;
+        // Loaded once; another thread may turn profiling off meanwhile.
+        ExecutorProfiler *p = profiler_;
+        if (p)
+        {
+            profile_run(p, msg, priority);
+        }
+        else
+        {
+            msg->run();
+        }
+        current_ = nullptr;
+    }
+
+    /// Runs an executable and records its statistics in the profiler.
+    /// @param p the profiler to record into
+    /// @param msg the executable to run
+    /// @param priority priority band the executable was taken from
+    void profile_run(ExecutorProfiler *p, Executable *msg, unsigned priority);
+
     /// Helper function.
     ///
     /// @param type a select type: READ, WRITE or EXCEPT
@@ -231,6 +306,9 @@ private:
     /** List of active timers. */
     ActiveTimers activeTimers_;
 
+    /// Owns the profiler object once profiling was enabled.
+    ExecutorProfiler *profilerStorage_;
+
     /** fd to select for read. */
     fd_set selectRead_;
     /** fd to select for write. */
@@ -317,8 +395,18 @@ public:
      */
     void add(Executable *msg, unsigned priority = UINT_MAX) OVERRIDE
     {
-        queue_.insert(
-            msg, priority >= NUM_PRIO ? NUM_PRIO - 1 : priority);
+        if (priority >= NUM_PRIO)
+        {
+            priority = NUM_PRIO - 1;
+        }
+        if (profiler_)
+        {
+            profile_add(msg, priority);
+        }
+        else
+        {
+            queue_.insert(msg, priority);
+        }
 #ifdef ESP_NONOS
         extern void wakeup_executor(ExecutorBase* executor);
         wakeup_executor(this);
@@ -358,6 +446,11 @@ public:
 
     uint32_t sequence() OVERRIDE { return sequence_; }
 
+    size_t pending() OVERRIDE
+    {
+        return queue_.pending();
+    }
+
 private:
 #ifndef ESP_NONOS
     /** Wait for an item from the front of the queue.
@@ -397,6 +490,15 @@ private:
         return static_cast<Executable*>(result.item);
     }
 
+    /** Inserts an item into the queue, bypassing the profiler.
+     * @param msg Executable instance to insert into the input queue
+     * @param priority priority band, already clamped
+     */
+    void queue_insert(Executable *msg, unsigned priority) override
+    {
+        queue_.insert(msg, priority);
+    }
+
     /** Default Constructor.
      */
     Executor();
@@ -436,6 +538,7 @@ template <unsigned NUM_PRIO>
 /** Destructs the executor. Waits for the executor to run out of work first. */
 Executor<NUM_PRIO>::~Executor()
 {
+    unregister_metrics();
     shutdown();
 }
 
@@ -0,0 +1,247 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ExecutorProfiler.cxx
+ *
+ * Opt-in run time statistics collection for an Executor.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "executor/ExecutorProfiler.hxx"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GXX_RTTI)
+#include <typeinfo>
+#if defined(__linux__) || defined(__MACH__)
+#include <cxxabi.h>
+#define PROFILER_DEMANGLE
+#endif
+#endif
+
+#include "executor/Executable.hxx"
+#include "utils/StringPrintf.hxx"
+
+constexpr unsigned ExecutorProfiler::MAX_BANDS;
+
+ExecutorProfiler::ExecutorProfiler()
+{
+    clear();
+}
+
+void ExecutorProfiler::clear()
+{
+    OSMutexLock h(&lock_);
+    executables_.clear();
+    clear_pending_locked();
+    memset(queueWait_, 0, sizeof(queueWait_));
+    memset(&timerLateness_, 0, sizeof(timerLateness_));
+    totalRuns_ = 0;
+    totalBusyNsec_ = 0;
+    startTime_ = OSTime::get_monotonic();
+}
+
+void ExecutorProfiler::clear_pending()
+{
+    OSMutexLock h(&lock_);
+    clear_pending_locked();
+}
+
+void ExecutorProfiler::record_run(const void *type, const char *type_name,
+    unsigned band, long long start, long long end)
+{
+    long long took = end - start;
+    band = std::min(band, MAX_BANDS - 1);
+    OSMutexLock h(&lock_);
+    auto &q = enqueueTime_[band];
+    if (!q.empty())
+    {
+        // Items enqueued around enabling the profiler may be matched to a
+        // later timestamp.
+        add_sample(&queueWait_[band], std::max(start - q.front(), 0LL));
+        q.pop_front();
+    }
+    ExecutableStats &s = executables_[type];
+    s.type = type;
+    s.typeName = type_name;
+    ++s.runCount;
+    s.totalNsec += took;
+    if (took > s.maxNsec)
+    {
+        s.maxNsec = took;
+    }
+    ++totalRuns_;
+    totalBusyNsec_ += took;
+}
+
+const void *ExecutorProfiler::type_key(const Executable *e)
+{
+#if defined(__GXX_RTTI)
+    return &typeid(*e);
+#else
+    // Without RTTI the vtable pointer, which is the first word of every
+    // polymorphic object in the Itanium C++ ABI, identifies the type.
+    return *reinterpret_cast<const void *const *>(e);
+#endif
+}
+
+const char *ExecutorProfiler::type_name(const Executable *e)
+{
+#if defined(__GXX_RTTI)
+    return typeid(*e).name();
+#else
+    return nullptr;
+#endif
+}
+
+void ExecutorProfiler::timer_fired(long long lateness_nsec)
+{
+    OSMutexLock h(&lock_);
+    add_sample(&timerLateness_, lateness_nsec);
+}
+
+std::vector<ExecutorProfiler::ExecutableStats>
+ExecutorProfiler::top_executables(unsigned max_count)
+{
+    std::vector<ExecutableStats> ret;
+    {
+        OSMutexLock h(&lock_);
+        ret.reserve(executables_.size());
+        for (const auto &kv : executables_)
+        {
+            ret.push_back(kv.second);
+        }
+    }
+    std::sort(ret.begin(), ret.end(),
+        [](const ExecutableStats &a, const ExecutableStats &b) {
+            return a.totalNsec > b.totalNsec;
+        });
+    if (ret.size() > max_count)
+    {
+        ret.resize(max_count);
+    }
+    return ret;
+}
+
+ExecutorProfiler::DelayStats ExecutorProfiler::queue_wait(unsigned band)
+{
+    HASSERT(band < MAX_BANDS);
+    OSMutexLock h(&lock_);
+    return queueWait_[band];
+}
+
+ExecutorProfiler::DelayStats ExecutorProfiler::timer_lateness()
+{
+    OSMutexLock h(&lock_);
+    return timerLateness_;
+}
+
+uint32_t ExecutorProfiler::total_runs()
+{
+    OSMutexLock h(&lock_);
+    return totalRuns_;
+}
+
+long long ExecutorProfiler::total_busy_nsec()
+{
+    OSMutexLock h(&lock_);
+    return totalBusyNsec_;
+}
+
+/// Appends a human readable name of an executable type to a string.
+/// @param type_name mangled type name.
+/// @param out where to append.
+static void append_type_name(const char *type_name, std::string *out)
+{
+#ifdef PROFILER_DEMANGLE
+    int status = -1;
+    char *demangled = abi::__cxa_demangle(type_name, nullptr, nullptr, &status);
+    if (status == 0 && demangled)
+    {
+        out->append(demangled);
+        free(demangled);
+        return;
+    }
+    free(demangled);
+#endif
+    out->append(type_name);
+}
+
+std::string ExecutorProfiler::report(unsigned max_count)
+{
+    std::string ret;
+    long long elapsed = elapsed_nsec();
+    long long busy = total_busy_nsec();
+    ret += StringPrintf("%" PRIu32 " runs in %lld msec, busy %lld msec "
+                        "(%d%%)\n",
+        total_runs(), elapsed / 1000000, busy / 1000000,
+        elapsed ? (int)(busy * 100 / elapsed) : 0);
+    for (unsigned i = 0; i < MAX_BANDS; ++i)
+    {
+        DelayStats s = queue_wait(i);
+        if (!s.count)
+        {
+            continue;
+        }
+        ret += StringPrintf("band %u: %" PRIu32 " waits, avg %lld usec, "
+                            "max %lld usec\n",
+            i, s.count, s.avg_nsec() / 1000, s.maxNsec / 1000);
+    }
+    DelayStats t = timer_lateness();
+    if (t.count)
+    {
+        ret += StringPrintf("timers: %" PRIu32 " fired, avg late %lld usec, "
+                            "max late %lld usec\n",
+            t.count, t.avg_nsec() / 1000, t.maxNsec / 1000);
+    }
+    for (const auto &s : top_executables(max_count))
+    {
+        ret += StringPrintf("%8" PRIu32 " runs %8lld usec total %6lld usec "
+                            "max ",
+            s.runCount, s.totalNsec / 1000, s.maxNsec / 1000);
+        if (s.typeName)
+        {
+            append_type_name(s.typeName, &ret);
+        }
+        else
+        {
+            ret += StringPrintf("type %p", s.type);
+        }
+        ret.push_back('\n');
+    }
+    return ret;
+}
+
+void ExecutorProfiler::print(FILE *fp, unsigned max_count)
+{
+    std::string r = report(max_count);
+    fwrite(r.data(), 1, r.size(), fp);
+}
@@ -0,0 +1,247 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ExecutorProfiler.hxx
+ *
+ * Opt-in run time statistics collection for an Executor.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _EXECUTOR_EXECUTORPROFILER_HXX_
+#define _EXECUTOR_EXECUTORPROFILER_HXX_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "os/OS.hxx"
+#include "utils/macros.h"
+
+class Executable;
+
+/// Collects statistics about the executables running on an executor: how
+/// many times each Executable (typically a StateFlow) ran, how much CPU time
+/// it took, how long executables waited in the queue per priority band and
+/// how late timers were running compared to their scheduled expiry.
+///
+/// The profiler is owned by the ExecutorBase and is created upon the first
+/// call to ExecutorBase::enable_profiling(true). When profiling is not
+/// enabled, the executor only pays for a single pointer check per run.
+///
+/// Statistics are kept per dynamic type of the Executable, so all instances
+/// of the same StateFlow class are accounted together, and an Executable that
+/// is deleted does not leave its statistics to a later unrelated object
+/// allocated at the same address.
+class ExecutorProfiler
+{
+public:
+    /// Maximum number of priority bands for which statistics are
+    /// kept. Executables in higher bands are accounted in the last band.
+    static constexpr unsigned MAX_BANDS = 8;
+
+    /// Statistics about a single executable type.
+    struct ExecutableStats
+    {
+        /// Identifies the type these stats are about (see type_key()).
+        const void *type;
+        /// Mangled type name of the executable (or nullptr if RTTI is not
+        /// available).
+        const char *typeName;
+        /// How many times executables of this type ran.
+        uint32_t runCount;
+        /// Total time spent in run(), nanoseconds.
+        long long totalNsec;
+        /// Longest single call to run(), nanoseconds.
+        long long maxNsec;
+    };
+
+    /// Statistics about a set of durations, e.g. queue waiting time or timer
+    /// lateness.
+    struct DelayStats
+    {
+        /// Number of samples.
+        uint32_t count;
+        /// Sum of all samples, nanoseconds.
+        long long totalNsec;
+        /// Largest sample, nanoseconds.
+        long long maxNsec;
+
+        /// @return average of the samples in nanoseconds or zero if there
+        /// were no samples.
+        long long avg_nsec() const
+        {
+            return count ? totalNsec / count : 0;
+        }
+    };
+
+    ExecutorProfiler();
+
+    /// Clears all collected statistics.
+    void clear();
+
+    /// Forgets about the enqueue times of all executables. Called when
+    /// profiling is re-enabled.
+    void clear_pending();
+
+    /// Forgets about the enqueue times of all executables if the executor's
+    /// queue is empty. The check happens under the same lock as enqueued(),
+    /// so no timestamp of a concurrently added executable is lost.
+    /// @param empty callable returning true if the queue is empty.
+    template <class F> void clear_pending_if(F empty)
+    {
+        OSMutexLock h(&lock_);
+        if (empty())
+        {
+            clear_pending_locked();
+        }
+    }
+
+    /// Called by the executor when an executable is added to the queue. The
+    /// timestamp is recorded and the executable is inserted into the queue
+    /// under the same lock, so the timestamps of each band are in the same
+    /// order as the queue.
+    /// @param band the priority band (after clamping)
+    /// @param insert callable which inserts the executable into the queue.
+    template <class F> void enqueued(unsigned band, F insert)
+    {
+        long long now = OSTime::get_monotonic();
+        OSMutexLock h(&lock_);
+        enqueueTime_[band < MAX_BANDS ? band : MAX_BANDS - 1].push_back(now);
+        insert();
+    }
+
+    /// Called by the executor after an executable returned from
+    /// run(). The executable might have been deleted already, so it is
+    /// identified by its type only.
+    /// @param type result of type_key(e) before running it
+    /// @param type_name result of type_name(e) before running it
+    /// @param band the priority band it was dequeued from
+    /// @param start timestamp when the executable was dequeued
+    /// @param end timestamp when run() returned
+    void record_run(const void *type, const char *type_name, unsigned band,
+                    long long start, long long end);
+
+    /// @return a key identifying the dynamic type of an executable.
+    /// @param e the executable, which must be alive.
+    static const void *type_key(const Executable *e);
+
+    /// @return the mangled type name of an executable or nullptr if RTTI is
+    /// not available.
+    /// @param e the executable, which must be alive.
+    static const char *type_name(const Executable *e);
+
+    /// Called when a timer callback starts.
+    /// @param lateness_nsec how many nanoseconds after the scheduled expiry
+    /// time the timer callback was invoked.
+    void timer_fired(long long lateness_nsec);
+
+    /// @return a snapshot of the per-executable statistics, ordered by total
+    /// run time descending.
+    /// @param max_count how many entries to return at most.
+    std::vector<ExecutableStats> top_executables(unsigned max_count);
+
+    /// @return queue waiting statistics for a given priority band.
+    /// @param band priority band, 0 to MAX_BANDS - 1.
+    DelayStats queue_wait(unsigned band);
+
+    /// @return statistics about the lateness of timer callbacks.
+    DelayStats timer_lateness();
+
+    /// @return total number of executable runs since the last clear.
+    uint32_t total_runs();
+
+    /// @return total time spent in executables since the last clear,
+    /// nanoseconds.
+    long long total_busy_nsec();
+
+    /// @return nanoseconds elapsed since the last clear().
+    long long elapsed_nsec()
+    {
+        return OSTime::get_monotonic() - startTime_;
+    }
+
+    /// Prints a human-readable report.
+    /// @param fp where to print
+    /// @param max_count how many executables to print at most.
+    void print(FILE *fp, unsigned max_count = 10);
+
+    /// Renders the human-readable report into a string.
+    /// @param max_count how many executables to print at most.
+    /// @return the report.
+    std::string report(unsigned max_count = 10);
+
+private:
+    /// Forgets about the enqueue times. Must be called with lock_ held.
+    void clear_pending_locked()
+    {
+        for (auto &q : enqueueTime_)
+        {
+            q.clear();
+        }
+    }
+
+    /// Adds a sample to a delay statistics struct.
+    /// @param s statistics to update
+    /// @param nsec the sample.
+    static void add_sample(DelayStats *s, long long nsec)
+    {
+        ++s->count;
+        s->totalNsec += nsec;
+        if (nsec > s->maxNsec)
+        {
+            s->maxNsec = nsec;
+        }
+    }
+
+    /// Protects all the statistics. The executable map is updated from the
+    /// executor thread, enqueue times are written by arbitrary threads.
+    OSMutex lock_;
+    /// Per-type statistics, keyed by type_key().
+    std::unordered_map<const void *, ExecutableStats> executables_;
+    /// Enqueue timestamps of the executables currently in the queue, per
+    /// band. Since every band is a FIFO, the timestamps are matched to the
+    /// executables in order instead of being looked up by address.
+    std::deque<long long> enqueueTime_[MAX_BANDS];
+    /// Queue waiting time per priority band.
+    DelayStats queueWait_[MAX_BANDS];
+    /// Lateness of timer callbacks.
+    DelayStats timerLateness_;
+    /// Total number of runs.
+    uint32_t totalRuns_;
+    /// Total time spent in run().
+    long long totalBusyNsec_;
+    /// When the stats were last cleared.
+    long long startTime_;
+
+    DISALLOW_COPY_AND_ASSIGN(ExecutorProfiler);
+};
+
+#endif // _EXECUTOR_EXECUTORPROFILER_HXX_
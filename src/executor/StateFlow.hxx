@@ -960,6 +960,13 @@ public:
         return isWaiting_;
     }
 
+    /// @return how many messages are waiting in the queue of this flow (not
+    /// counting the one being processed).
+    unsigned queue_size()
+    {
+        return queueSize_;
+    }
+
 protected:
     /// Constructor. @param service specifies which thread to execute this
     /// state flow on.
@@ -34,6 +34,7 @@
 
 #include "executor/Timer.hxx"
 #include "executor/Executor.hxx"
+#include "executor/ExecutorProfiler.hxx"
 #include "os/os.h"
 
 Timer::~Timer()
@@ -44,6 +45,11 @@ Timer::~Timer()
 
 void Timer::run()
 {
+    ExecutorProfiler *p = activeTimers_->executor()->active_profiler();
+    if (p)
+    {
+        p->timer_fired(OSTime::get_monotonic() - when_);
+    }
     isExpired_ = 0;
     long long new_period = timeout();
     if (new_period == RESTART)
@@ -171,10 +171,11 @@ private:
  *  device driver.
  *
  *  Write calls work by sending the packet in the format of dcc::Packet.  The
- *  payload should include the X-OR linkage byte.  Only one DCC packet may be
- *  written per call to the write method.  If there is no space currently
- *  available in the write queue, the write method will return -1 with errno
- *  set to ENOSPC.
+ *  payload should include the X-OR linkage byte.  A write call may carry
+ *  any whole number of packets; as many of them as fit into the queue are
+ *  taken, and the number of bytes accepted is returned.  If there is no space
+ *  currently available in the write queue, the write method will return -1
+ *  with errno set to ENOSPC.
  *
  *  Handling of write throttling:
  *
@@ -1024,7 +1025,7 @@ template<class HW>
 __attribute__((optimize("-O3")))
 ssize_t TivaDCC<HW>::write(File *file, const void *buf, size_t count)
 {
-    if (count != sizeof(dcc::Packet))
+    if (count == 0 || count % sizeof(dcc::Packet) != 0)
     {
         return -EINVAL;
     }
@@ -1041,31 +1042,41 @@ ssize_t TivaDCC<HW>::write(File *file, const void *buf, size_t count)
         return -ENOSPC;
     }
 
-    dcc::Packet* packet = &packetQueue_.back();
-    memcpy(packet, buf, count);
+    const dcc::Packet *src = static_cast<const dcc::Packet *>(buf);
+    size_t written = 0;
+    while (written < count && !packetQueue_.full())
+    {
+        dcc::Packet *packet = &packetQueue_.back();
+        memcpy(packet, src++, sizeof(dcc::Packet));
 
-    // Duplicates the marklin packet if it came single.
-    if (packet->packet_header.is_marklin) {
-        if (packet->dlc == 3) {
-            packet->dlc = 6;
-            packet->payload[3] = packet->payload[0];
-            packet->payload[4] = packet->payload[1];
-            packet->payload[5] = packet->payload[2];
-        } else {
-            HASSERT(packet->dlc == 6);
+        // Duplicates the marklin packet if it came single.
+        if (packet->packet_header.is_marklin)
+        {
+            if (packet->dlc == 3)
+            {
+                packet->dlc = 6;
+                packet->payload[3] = packet->payload[0];
+                packet->payload[4] = packet->payload[1];
+                packet->payload[5] = packet->payload[2];
+            }
+            else
+            {
+                HASSERT(packet->dlc == 6);
+            }
         }
-    }
 
-    packetQueue_.increment_back();
-    static uint8_t flip = 0;
-    if (++flip >= 4)
-    {
-        flip = 0;
-        HW::flip_led();
+        packetQueue_.increment_back();
+        written += sizeof(dcc::Packet);
+        static uint8_t flip = 0;
+        if (++flip >= 4)
+        {
+            flip = 0;
+            HW::flip_led();
+        }
     }
 
     MAP_TimerIntEnable(HW::INTERVAL_BASE, TIMER_TIMA_TIMEOUT);
-    return count;
+    return written;
 }
 
 /** Request an ioctl transaction
@@ -91,6 +91,7 @@ void AliasCache::add(NodeID id, NodeAlias alias)
         HASSERT(oldest != NULL && newest != NULL);
 
         /* kick out the oldest mapping and re-link the oldest endpoint */
+        evictions_.inc();
         insert = oldest;
         if (oldest->newer)
         {
@@ -178,6 +179,26 @@ void AliasCache::remove(NodeAlias alias)
     
 }
 
+template <> void AliasCache::add_metrics<false>(const char *)
+{
+}
+
+template <bool ENABLED> void AliasCache::add_metrics(const char *prefix)
+{
+    MetricsRegistry *r = MetricsRegistry::instance();
+    std::string p(prefix);
+    r->add(this, p + ".hits", &hits_);
+    r->add(this, p + ".misses", &misses_);
+    r->add(this, p + ".evictions", &evictions_);
+    r->add_gauge(this, p + ".used", [this]() { return aliasMap.size(); });
+    r->add_gauge(this, p + ".size", [this]() { return entries; });
+}
+
+void AliasCache::register_metrics(const char *prefix)
+{
+    add_metrics<METRICS_ENABLED>(prefix);
+}
+
 bool AliasCache::retrieve(unsigned entry, NodeID* node, NodeAlias* alias)
 {
     HASSERT(entry < size());
@@ -204,10 +225,12 @@ NodeAlias AliasCache::lookup(NodeID id)
         
         /* update timestamp */
         touch(metadata);
+        hits_.inc();
         return metadata->alias;
     }
 
     /* no match found */
+    misses_.inc();
     return 0;
 }
 
@@ -227,10 +250,12 @@ NodeID AliasCache::lookup(NodeAlias alias)
         
         /* update timestamp */
         touch(metadata);
+        hits_.inc();
         return metadata->id;
     }
     
     /* no match found */
+    misses_.inc();
     return 0;
 }
 
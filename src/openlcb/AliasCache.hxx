@@ -37,6 +37,7 @@
 #include "openlcb/Defs.hxx"
 #include "utils/macros.h"
 #include "utils/Map.hxx"
+#include "utils/Metrics.hxx"
 #include "utils/RBTree.hxx"
 
 namespace openlcb
@@ -136,9 +137,20 @@ public:
      */
     NodeAlias generate();
 
+    /** Exports the hit/miss/eviction counters and the occupancy of this
+     * cache into the MetricsRegistry. Compiles to nothing when
+     * METRICS_ENABLED is false.
+     * @param prefix is prepended to the metric names, e.g. "if.alias.remote".
+     */
+    void register_metrics(const char *prefix);
+
     /** Default destructor */
     ~AliasCache()
     {
+        if (METRICS_ENABLED)
+        {
+            MetricsRegistry::instance()->remove(this);
+        }
         delete [] pool;
     }
     
@@ -197,6 +209,20 @@ private:
     /** How many metadata entries have we allocated. */
     size_t entries;
 
+    /** Number of lookups that found an entry. */
+    CounterMetric hits_;
+    /** Number of lookups that did not find an entry. */
+    CounterMetric misses_;
+    /** Number of entries kicked out to make room for a new one. */
+    CounterMetric evictions_;
+
+    /** Implementation of register_metrics(). The instance for false is
+     * empty, so the names and gauges are not compiled in when the metrics
+     * are off.
+     * @param prefix is prepended to the metric names.
+     */
+    template <bool ENABLED> void add_metrics(const char *prefix);
+
     /** callback function to be used when we remove an entry from the cache */
     void (*removeCallback)(NodeID id, NodeAlias alias, void *);
     
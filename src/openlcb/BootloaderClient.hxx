@@ -35,6 +35,9 @@
 
 #include <time.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "openlcb/DatagramDefs.hxx"
 #include "openlcb/StreamDefs.hxx"
 #include "openlcb/PIPClient.hxx"
@@ -74,9 +77,56 @@ struct BootloaderRequest
     uint32_t offset{0};
     /// Payload to write.
     string data;
+    /// If not null, the payload is taken from here instead of data. Allows
+    /// multiple requests to share a single copy of the firmware image. Must
+    /// stay alive until the request is done.
+    const string *shared_data{nullptr};
     /// This structure will be filled with the returning error code, or zero if
     /// the bootloading was successful.
     BootloaderResponse *response{nullptr};
+
+    /// @return the payload to write.
+    const string &payload()
+    {
+        return shared_data ? *shared_data : data;
+    }
+};
+
+class BootloaderClient;
+
+/// Datagram handler that listens to the incoming memoryconfig datagrams for
+/// the write stream response message, and forwards them to the bootloader
+/// client talking to the originating node. The datagram registry can hold
+/// only one handler per local node and datagram type, so all the
+/// BootloaderClients running from the same local node have to share one of
+/// these.
+class BootloaderResponseHandler : public DefaultDatagramHandler
+{
+public:
+    /// Constructor.
+    /// @param service is the datagram service to register with.
+    BootloaderResponseHandler(DatagramService *service)
+        : DefaultDatagramHandler(service)
+    {
+    }
+
+    /// Starts forwarding response datagrams to a client.
+    /// @param client is the client waiting for a write stream response.
+    void add_client(BootloaderClient *client);
+
+    /// Stops forwarding response datagrams to a client.
+    /// @param client is a client previously added.
+    void remove_client(BootloaderClient *client);
+
+private:
+    Action entry() override;
+
+    Action ok_response_sent() override;
+
+    /// Clients that are waiting for a response datagram.
+    std::vector<BootloaderClient *> clients_;
+    /// The client that will get the current datagram.
+    BootloaderClient *target_{nullptr};
 };
 
 /// How long to wait for a write datagram's response in the bootloader client.
@@ -97,17 +147,33 @@ int g_bootloader_timeout_sec = 3;
 class BootloaderClient : public StateFlow<Buffer<BootloaderRequest>, QList<1>>
 {
 public:
-    BootloaderClient(
-        Node *node, DatagramService *if_datagram_service, IfCan *if_can)
+    /// Constructor.
+    ///
+    /// @param node is the local node to send the traffic from.
+    /// @param if_datagram_service is the datagram service of the node's
+    /// interface.
+    /// @param if_can is the CAN interface (used for sending stream frames).
+    /// @param local_stream_id is the source stream ID to use. Clients running
+    /// in parallel from the same node need to have different stream IDs.
+    /// @param response_handler if not null, this handler is used for the
+    /// write stream response datagrams instead of a private one. Clients
+    /// running in parallel from the same node need to share one handler.
+    BootloaderClient(Node *node, DatagramService *if_datagram_service,
+        IfCan *if_can, uint8_t local_stream_id = 0x55,
+        BootloaderResponseHandler *response_handler = nullptr)
         : StateFlow<Buffer<BootloaderRequest>, QList<1>>(node->iface())
         , node_(node)
         , datagramService_(if_datagram_service)
         , ifCan_(if_can)
+        , localStreamIdConfig_(local_stream_id)
+        , responseHandler_(
+              response_handler ? response_handler : &ownResponseHandler_)
     {
     }
 
     Action entry() override
     {
+        bufferOffset_ = 0;
         return allocate_and_call(
             STATE(got_dg_client), datagramService_->client_allocator());
     }
@@ -127,6 +193,13 @@ public:
         return message()->data()->dst;
     }
 
+    /// @return how many bytes of the current request's payload were sent
+    /// out. Must be called on the executor of this flow.
+    size_t bytes_sent()
+    {
+        return bufferOffset_;
+    }
+
     void response_datagram_arrived(Buffer<IncomingDatagram> *datagram)
     {
         if (responseDatagram_)
@@ -226,45 +299,6 @@ private:
         return wait_and_call(STATE(write_request_sent));
     }
 
-    /// Datagram handler that listens to the incoming memoryconfig datagram for
-    /// the write stream response message.
-    class WriteResponseHandler : public DefaultDatagramHandler
-    {
-    public:
-        WriteResponseHandler(BootloaderClient *parent)
-            : DefaultDatagramHandler(parent->datagram_service())
-            , parent_(parent)
-        {
-        }
-
-        Action entry() override
-        {
-            IncomingDatagram *datagram = message()->data();
-
-            if (datagram->dst != parent_->node() ||
-                !parent_->node()->iface()->matching_node(
-                    parent_->dst(), datagram->src) ||
-                datagram->payload.size() < 6 ||
-                datagram->payload[0] != DatagramDefs::CONFIGURATION ||
-                ((datagram->payload[1] & 0xF4) !=
-                    MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY))
-            {
-                // Uninteresting datagram.
-                return respond_reject(DatagramDefs::PERMANENT_ERROR);
-            }
-            return respond_ok(DatagramDefs::FLAGS_NONE);
-        }
-
-        Action ok_response_sent() override
-        {
-            parent_->response_datagram_arrived(transfer_message());
-            return exit();
-        }
-
-    private:
-        BootloaderClient *parent_;
-    };
-
     Action write_request_sent()
     {
         uint32_t dg_result = dgClient_->result();
@@ -355,7 +389,7 @@ private:
 
     uint8_t allocate_local_stream_id()
     {
-        return 0x55;
+        return localStreamIdConfig_;
     }
 
     Action return_error(uint16_t error_code, const string &error_details)
@@ -373,8 +407,7 @@ private:
 
     void register_write_response_handler()
     {
-        datagramService_->registry()->insert(
-            node_, DatagramDefs::CONFIGURATION, &writeResponseHandler_);
+        responseHandler_->add_client(this);
         writeResponseRegistered_ = true;
     }
 
@@ -383,8 +416,7 @@ private:
         if (writeResponseRegistered_)
         {
             writeResponseRegistered_ = false;
-            datagramService_->registry()->erase(
-                node_, DatagramDefs::CONFIGURATION, &writeResponseHandler_);
+            responseHandler_->remove_client(this);
         }
     }
 
@@ -478,7 +510,7 @@ private:
 
     Action send_stream_data()
     {
-        if (bufferOffset_ >= message()->data()->data.size())
+        if (bufferOffset_ >= message()->data()->payload().size())
         {
             return call_immediately(STATE(close_stream));
         }
@@ -497,15 +529,16 @@ private:
             &can_id, local_alias, remote_alias, CanDefs::STREAM_DATA);
         auto *frame = b->data()->mutable_frame();
         SET_CAN_FRAME_ID_EFF(*frame, can_id);
-        size_t len =
-            std::min(size_t(7), message()->data()->data.size() - bufferOffset_);
+        size_t len = std::min(
+            size_t(7), message()->data()->payload().size() - bufferOffset_);
         if (availableBufferSize_ < len)
         {
             len = availableBufferSize_;
         }
         frame->can_dlc = len + 1;
         frame->data[0] = remoteStreamId_;
-        memcpy(&frame->data[1], &message()->data()->data[bufferOffset_], len);
+        memcpy(&frame->data[1], &message()->data()->payload()[bufferOffset_],
+            len);
         bufferOffset_ += len;
         availableBufferSize_ -= len;
         // LOG(INFO, "available buffer: %d", availableBufferSize_);
@@ -638,9 +671,9 @@ private:
         Buffer<GenMessage> *b;
         mainBufferPool->alloc(&b);
         DatagramPayload payload = MemoryConfigDefs::write_datagram(message()->data()->memory_space, message()->data()->offset + bufferOffset_);
-        unsigned len = message()->data()->data.size() - bufferOffset_;
+        unsigned len = message()->data()->payload().size() - bufferOffset_;
         if (len > 64) len = 64;
-        payload.append(&message()->data()->data[bufferOffset_], len);
+        payload.append(&message()->data()->payload()[bufferOffset_], len);
         b->set_done(n_.reset(this));
         b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(),
             message()->data()->dst, payload);
@@ -666,7 +699,7 @@ private:
                 "bootloader yet.");
         }
 
-        unsigned len = message()->data()->data.size() - bufferOffset_;
+        unsigned len = message()->data()->payload().size() - bufferOffset_;
         if (len > 64) len = 64;
         bufferOffset_ += len;
 
@@ -676,7 +709,7 @@ private:
                 bufferOffset_, speedAvg_.avg());
         }
 
-        if (bufferOffset_ < message()->data()->data.size()) {
+        if (bufferOffset_ < message()->data()->payload().size()) {
             return call_immediately(STATE(next_dg_write_datagram));
         }
         if (message()->data()->request_reboot_after) {
@@ -718,6 +751,8 @@ private:
     Node *node_;
     DatagramService *datagramService_;
     IfCan *ifCan_;
+    /// Source stream ID to use.
+    uint8_t localStreamIdConfig_;
     DatagramClient *dgClient_ = nullptr;
     Buffer<IncomingDatagram> *responseDatagram_ = nullptr;
     uint8_t localStreamId_;
@@ -733,7 +768,7 @@ private:
     // proceed message.
     uint32_t availableBufferSize_;
     // The next byte we need to send from the input data.
-    size_t bufferOffset_;
+    size_t bufferOffset_ = 0;
 
     Ewma speedAvg_;
     // The Average speed (ewma) in bytes/second.
@@ -746,7 +781,10 @@ private:
     // proceed flag.
     long long sleepStartTimeNsec_;
 
-    WriteResponseHandler writeResponseHandler_{this};
+    /// Used when no shared response handler was supplied.
+    BootloaderResponseHandler ownResponseHandler_{datagramService_};
+    /// Receives the write stream response datagrams for us.
+    BootloaderResponseHandler *responseHandler_;
     bool writeResponseRegistered_ = false;
     MessageHandler::GenericHandler streamInitiateReplyHandler_{
         this, &BootloaderClient::stream_initiate_replied};
@@ -760,4 +798,66 @@ private:
     PIPClient pipClient_{ifCan_};
 };
 
+inline void BootloaderResponseHandler::add_client(BootloaderClient *client)
+{
+    if (clients_.empty())
+    {
+        dg_service()->registry()->insert(
+            client->node(), DatagramDefs::CONFIGURATION, this);
+    }
+    else
+    {
+        HASSERT(clients_[0]->node() == client->node());
+    }
+    clients_.push_back(client);
+}
+
+inline void BootloaderResponseHandler::remove_client(BootloaderClient *client)
+{
+    auto it = std::find(clients_.begin(), clients_.end(), client);
+    if (it == clients_.end())
+    {
+        return;
+    }
+    clients_.erase(it);
+    if (clients_.empty())
+    {
+        dg_service()->registry()->erase(
+            client->node(), DatagramDefs::CONFIGURATION, this);
+    }
+}
+
+inline StateFlowBase::Action BootloaderResponseHandler::entry()
+{
+    IncomingDatagram *datagram = message()->data();
+    target_ = nullptr;
+    if (datagram->payload.size() >= 6 &&
+        datagram->payload[0] == DatagramDefs::CONFIGURATION &&
+        ((datagram->payload[1] & 0xF4) ==
+            MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY))
+    {
+        for (BootloaderClient *c : clients_)
+        {
+            if (datagram->dst == c->node() &&
+                c->node()->iface()->matching_node(c->dst(), datagram->src))
+            {
+                target_ = c;
+                break;
+            }
+        }
+    }
+    if (!target_)
+    {
+        // Uninteresting datagram.
+        return respond_reject(DatagramDefs::PERMANENT_ERROR);
+    }
+    return respond_ok(DatagramDefs::FLAGS_NONE);
+}
+
+inline StateFlowBase::Action BootloaderResponseHandler::ok_response_sent()
+{
+    target_->response_datagram_arrived(transfer_message());
+    return exit();
+}
+
 } // namespace openlcb
@@ -0,0 +1,296 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file BootloaderFleet.hxx
+ *
+ * Uploads the same firmware image to many nodes in parallel, using several
+ * BootloaderClient instances.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _OPENLCB_BOOTLOADERFLEET_HXX_
+#define _OPENLCB_BOOTLOADERFLEET_HXX_
+
+#include <memory>
+#include <vector>
+
+#include "openlcb/BootloaderClient.hxx"
+
+namespace openlcb
+{
+
+/// Status of the upload to a single node in a fleet upload.
+struct BootloaderFleetTarget
+{
+    enum State
+    {
+        /// Not started yet.
+        PENDING,
+        /// Upload is in progress.
+        RUNNING,
+        /// Upload is finished (see response for the result).
+        DONE
+    };
+
+    /// Node to upload to.
+    NodeHandle dst;
+    /// Where the upload is at.
+    State state{PENDING};
+    /// How many bytes of the image were sent to this node.
+    size_t bytes_sent{0};
+    /// Result of the upload. Valid when state is DONE.
+    BootloaderResponse response;
+};
+
+/// Send a structure of this type to the BootloaderFleet state flow to write
+/// the same image into a set of target nodes.
+struct BootloaderFleetRequest
+{
+    /// Nodes to upload to. Owned by the caller; the progress and the results
+    /// are filled in here. Must stay alive until the request is done.
+    std::vector<BootloaderFleetTarget> *targets{nullptr};
+    /// Memory space ID to write into.
+    uint8_t memory_space{MemoryConfigDefs::SPACE_FIRMWARE};
+    /// Nonzero: request the targets to reboot into bootloader mode before
+    /// flashing.
+    uint8_t request_reboot{1};
+    /// Nonzero: request the targets to reboot after flashing.
+    uint8_t request_reboot_after{1};
+    /// Nonzero: skip the PIP request to the bootloader. Use streams.
+    uint8_t skip_pip{0};
+    /// Offset at which to start writing.
+    uint32_t offset{0};
+    /// Firmware image to write. One copy is shared by all targets.
+    string data;
+};
+
+/// StateFlow that performs the bootloading process on many target nodes at
+/// the same time. Owns a number of BootloaderClient instances, each with its
+/// own stream ID and stream window, and keeps them busy until every target
+/// is done. Progress is logged whenever a target finishes.
+class BootloaderFleet
+    : public StateFlow<Buffer<BootloaderFleetRequest>, QList<1>>
+{
+public:
+    /// Constructor.
+    ///
+    /// @param node is the local node to send the traffic from.
+    /// @param if_datagram_service is the datagram service of the node's
+    /// interface. For datagram-based targets, the number of datagram clients
+    /// of this service limits the parallelism.
+    /// @param if_can is the CAN interface.
+    /// @param parallelism is how many targets to upload to at the same time.
+    BootloaderFleet(Node *node, DatagramService *if_datagram_service,
+        IfCan *if_can, unsigned parallelism)
+        : StateFlow<Buffer<BootloaderFleetRequest>, QList<1>>(node->iface())
+        , responseHandler_(if_datagram_service)
+    {
+        HASSERT(parallelism > 0 && parallelism <= MAX_PARALLELISM);
+        for (unsigned i = 0; i < parallelism; ++i)
+        {
+            slots_.emplace_back(new Slot);
+            slots_.back()->parent_ = this;
+            slots_.back()->client_.reset(new BootloaderClient(node,
+                if_datagram_service, if_can, FIRST_STREAM_ID + i,
+                &responseHandler_));
+        }
+    }
+
+    /// @return the total number of payload bytes sent to all targets in the
+    /// current (or last) request. Must be called on the executor of this
+    /// flow.
+    size_t total_bytes()
+    {
+        size_t ret = finishedBytes_;
+        for (auto &s : slots_)
+        {
+            if (s->target_ >= 0)
+            {
+                ret += s->client_->bytes_sent();
+            }
+        }
+        return ret;
+    }
+
+    /// @return the aggregate upload speed of the current (or last) request in
+    /// bytes per second. Must be called on the executor of this flow.
+    float bytes_per_sec()
+    {
+        long long end = endTimeNsec_ ? endTimeNsec_ : os_get_time_monotonic();
+        if (end <= startTimeNsec_)
+        {
+            return 0;
+        }
+        return float(total_bytes()) * 1e9 / (end - startTimeNsec_);
+    }
+
+    /// Updates the bytes_sent field of the running targets. Must be called on
+    /// the executor of this flow.
+    void update_progress()
+    {
+        for (auto &s : slots_)
+        {
+            if (s->target_ >= 0)
+            {
+                targets()[s->target_].bytes_sent = s->client_->bytes_sent();
+            }
+        }
+    }
+
+    /// Max number of parallel uploads.
+    static constexpr unsigned MAX_PARALLELISM = 64;
+    /// Stream ID of the first client. Each client uses the next one.
+    static constexpr uint8_t FIRST_STREAM_ID = 0x55;
+
+private:
+    /// One concurrently running upload.
+    struct Slot : public Notifiable
+    {
+        /// Called when the client is done with the request.
+        void notify() override
+        {
+            parent_->slot_done(this);
+        }
+
+        /// Owning flow.
+        BootloaderFleet *parent_{nullptr};
+        /// Performs the upload.
+        std::unique_ptr<BootloaderClient> client_;
+        /// Index of the target being uploaded, or -1 if idle.
+        int target_{-1};
+        /// Notified when the request buffer is released.
+        BarrierNotifiable bn_;
+    };
+
+    std::vector<BootloaderFleetTarget> &targets()
+    {
+        return *message()->data()->targets;
+    }
+
+    Action entry() override
+    {
+        HASSERT(message()->data()->targets);
+        nextTarget_ = 0;
+        numRunning_ = 0;
+        finishedBytes_ = 0;
+        startTimeNsec_ = os_get_time_monotonic();
+        endTimeNsec_ = 0;
+        return call_immediately(STATE(start_targets));
+    }
+
+    /// Hands out pending targets to the idle clients.
+    Action start_targets()
+    {
+        for (auto &sp : slots_)
+        {
+            Slot &s = *sp;
+            if (nextTarget_ >= targets().size())
+            {
+                break;
+            }
+            if (s.target_ >= 0)
+            {
+                continue;
+            }
+            s.target_ = nextTarget_++;
+            BootloaderFleetTarget &t = targets()[s.target_];
+            t.state = BootloaderFleetTarget::RUNNING;
+            t.bytes_sent = 0;
+            const BootloaderFleetRequest &r = *message()->data();
+            Buffer<BootloaderRequest> *b;
+            mainBufferPool->alloc(&b);
+            b->data()->dst = t.dst;
+            b->data()->memory_space = r.memory_space;
+            b->data()->request_reboot = r.request_reboot;
+            b->data()->request_reboot_after = r.request_reboot_after;
+            b->data()->skip_pip = r.skip_pip;
+            b->data()->offset = r.offset;
+            b->data()->shared_data = &r.data;
+            b->data()->response = &t.response;
+            b->set_done(s.bn_.reset(&s));
+            ++numRunning_;
+            s.client_->send(b);
+        }
+        if (!numRunning_)
+        {
+            endTimeNsec_ = os_get_time_monotonic();
+            LOG(INFO,
+                "Fleet upload done: %u nodes, %" PRIdPTR
+                " bytes, %.0f bytes/sec",
+                (unsigned)targets().size(), total_bytes(), bytes_per_sec());
+            return release_and_exit();
+        }
+        waiting_ = true;
+        return wait_and_call(STATE(start_targets));
+    }
+
+    /// Called when a slot's client has finished a target.
+    /// @param s is the slot that finished.
+    void slot_done(Slot *s)
+    {
+        BootloaderFleetTarget &t = targets()[s->target_];
+        t.state = BootloaderFleetTarget::DONE;
+        t.bytes_sent = s->client_->bytes_sent();
+        finishedBytes_ += t.bytes_sent;
+        s->target_ = -1;
+        --numRunning_;
+        LOG(INFO,
+            "Fleet upload: node %012" PRIx64 " alias %03x done (%u/%u), "
+            "result %04x %s; %.0f bytes/sec",
+            t.dst.id, t.dst.alias, nextTarget_ - numRunning_,
+            (unsigned)targets().size(), t.response.error_code,
+            t.response.error_details.c_str(), bytes_per_sec());
+        if (waiting_)
+        {
+            waiting_ = false;
+            notify();
+        }
+    }
+
+    /// Shared by all clients, because the datagram registry has only one
+    /// entry for the local node.
+    BootloaderResponseHandler responseHandler_;
+    /// Concurrently running uploads.
+    std::vector<std::unique_ptr<Slot>> slots_;
+    /// Index of the next target to start.
+    unsigned nextTarget_{0};
+    /// Number of slots with a running upload.
+    unsigned numRunning_{0};
+    /// Bytes sent to targets that are already finished.
+    size_t finishedBytes_{0};
+    /// When the current request started.
+    long long startTimeNsec_{0};
+    /// When the current request finished, or 0 if it is still running.
+    long long endTimeNsec_{0};
+    /// True if the flow is waiting for a slot to finish.
+    bool waiting_{false};
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_BOOTLOADERFLEET_HXX_
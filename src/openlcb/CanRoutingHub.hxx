@@ -36,10 +36,13 @@
 #ifndef _NMRANET_CANROUTNGHUB_HXX_
 #define _NMRANET_CANROUTNGHUB_HXX_
 
+#include <memory>
+
 #include "openlcb/RoutingLogic.hxx"
 #include "openlcb/CanDefs.hxx"
 #include "openlcb/Defs.hxx"
 #include "openlcb/If.hxx"
+#include "openlcb/SimpleInfoCache.hxx"
 #include "utils/Hub.hxx"
 #include "utils/GcStreamParser.hxx"
 #include "utils/gc_format.h"
@@ -129,6 +132,29 @@ public:
         pendingRemove_.push_back(port);
     }
 
+    /// Turns on answering SNIP and PIP requests from a cache of earlier
+    /// replies, instead of forwarding every request to the target node.
+    /// @param max_nodes is the maximum number of nodes to cache data for.
+    void enable_info_cache(unsigned max_nodes = 256)
+    {
+        OSMutexLock l(&lock_);
+        infoCache_.reset(new SimpleInfoCache(max_nodes));
+    }
+
+    /// Reads the counters of the SNIP/PIP cache.
+    /// @param stats will be filled in with a snapshot of the counters.
+    /// @return false if enable_info_cache was not called.
+    bool get_info_cache_stats(SimpleInfoCache::Stats *stats)
+    {
+        OSMutexLock l(&lock_);
+        if (!infoCache_)
+        {
+            return false;
+        }
+        *stats = infoCache_->stats();
+        return true;
+    }
+
 private:
     class PortParser;
     typedef std::map<void *, PortParser> PortsMap;
@@ -185,6 +211,16 @@ private:
                     message()->data()->skipMember_, srcAddress_);
             }
 
+            if (parent_->infoCache_)
+            {
+                cachedReplies_.clear();
+                if (parent_->infoCache_->process_frame(frame, &cachedReplies_))
+                {
+                    send_cached_replies();
+                    return release_and_exit();
+                }
+            }
+
             gcBuf_ = nullptr;
 
             if (forwardType_ == ADDRESSED && dstAddress_ != 0)
@@ -379,6 +415,38 @@ private:
             }
         }
 
+        /// Sends the frames in cachedReplies_ back to the port the current
+        /// message came from.
+        void send_cached_replies()
+        {
+            auto it = parent_->ports_.find(message()->data()->skipMember_);
+            if (it == parent_->ports_.end() || it->second.inactive_)
+            {
+                return;
+            }
+            for (const struct can_frame &f : cachedReplies_)
+            {
+                if (it->second.canPort_)
+                {
+                    auto *b = parent_->deliveryFlow_.alloc();
+                    *b->data()->mutable_frame() = f;
+                    b->data()->skipMember_ = nullptr;
+                    it->second.canPort_->send(b, priority());
+                }
+                else
+                {
+                    HASSERT(it->second.hubPort_);
+                    Buffer<HubData> *b;
+                    mainBufferPool->alloc(&b);
+                    char buf[29];
+                    char *end = gc_format_generate(&f, buf, 0);
+                    b->data()->assign(buf, end - buf);
+                    b->data()->skipMember_ = nullptr;
+                    it->second.hubPort_->send(b);
+                }
+            }
+        }
+
         void ensure_gc_buf_available()
         {
             if (gcBuf_ != nullptr)
@@ -410,6 +478,8 @@ private:
         GcCanRoutingHub *parent_;
         /// Gridconnect-rendered frame.
         Buffer<HubData> *gcBuf_;
+        /// Reply frames generated by the SNIP/PIP cache.
+        std::vector<struct can_frame> cachedReplies_;
     };
 
     DeliveryFlow deliveryFlow_;
@@ -435,6 +505,9 @@ private:
     std::vector<void *> pendingRemove_;
 
     RoutingLogic<CanHubPortInterface, NodeAlias> routingTable_;
+    /// Answers SNIP and PIP requests on behalf of remote nodes. Null if
+    /// disabled.
+    std::unique_ptr<SimpleInfoCache> infoCache_;
 };
 
 } // namespace openlcb
@@ -6,9 +6,11 @@ using std::string;
 #include "config.hxx"
 
 #include "utils/StringPrintf.cxx"
+#include "utils/PairCompress.cxx"
 #include "utils/FileUtils.hxx"
 
 bool raw_render = false;
+bool compress_cdi = false;
 
 // openlcb::ConfigDef def(0);
 
@@ -32,6 +34,30 @@ void render_cdi_helper(const CdiType &t, string ns, string name)
             filename.c_str());
         write_string_to_file(filename, payload);
     }
+    else if (compress_cdi && name == "CDI")
+    {
+        // The terminating null is part of the served CDI.
+        string packed;
+        pair_compress(string(payload.c_str(), payload.size() + 1), &packed);
+        printf("namespace %s {\n\n", ns.c_str());
+        printf("// The CDI is stored compressed. Uncompressed %u bytes, "
+               "compressed %u bytes.\n",
+            (unsigned)payload.size(), (unsigned)packed.size());
+        printf("extern const char %s_DATA[];\n", name.c_str());
+        printf("const char %s_DATA[] = \"\";\n", name.c_str());
+        printf("extern const uint8_t %s_COMPRESSED_DATA[];\n", name.c_str());
+        printf("const uint8_t %s_COMPRESSED_DATA[] = {", name.c_str());
+        for (unsigned i = 0; i < packed.size(); ++i)
+        {
+            printf("%s0x%02x,", (i % 16) ? " " : "\n  ",
+                (unsigned)(uint8_t)packed[i]);
+        }
+        printf("\n};\n");
+        printf("extern const size_t %s_COMPRESSED_SIZE;\n", name.c_str());
+        printf("const size_t %s_COMPRESSED_SIZE = sizeof(%s_COMPRESSED_DATA);\n",
+            name.c_str(), name.c_str());
+        printf("\n}  // namespace %s\n\n", ns.c_str());
+    }
     else
     {
         printf("namespace %s {\n\nextern const char %s_DATA[];\n", ns.c_str(),
@@ -54,6 +80,10 @@ int main(int argc, char *argv[])
     }
     else
     {
+        if (argc > 1 && string(argv[1]) == "-c")
+        {
+            compress_cdi = true;
+        }
         printf(R"(
 /* Generated code based off of config.hxx */
 
@@ -57,8 +57,8 @@ int ConfigUpdateFlow::open_file(const char *path)
 
 void ConfigUpdateFlow::init_flow()
 {
-    trigger_update();
-    isInitialLoad_ = 1;
+    AtomicHolder h(this);
+    start_update(true, false);
 }
 
 void ConfigUpdateFlow::factory_reset()
@@ -42,6 +42,9 @@
 #include "openlcb/NodeInitializeFlow.hxx"
 #include "executor/StateFlow.hxx"
 
+#include <algorithm>
+#include <limits.h>
+
 #if !defined (__MACH__)
 extern "C" {
 /// Called when the node needs to be rebooted.
@@ -64,6 +67,10 @@ public:
     ConfigUpdateFlow(If *iface)
         : StateFlowBase(iface)
         , nextRefresh_(listeners_.begin())
+        , dirtyBegin_(UINT_MAX)
+        , dirtyEnd_(0)
+        , updateBegin_(0)
+        , updateEnd_(UINT_MAX)
         , fd_(-1)
     {
     }
@@ -84,14 +91,29 @@ public:
     void trigger_update() override
     {
         AtomicHolder h(this);
-        nextRefresh_ = listeners_.begin();
-        isInitialLoad_ = 0;
-        needsReboot_ = 0;
-        needsReInit_ = 0;
-        if (is_state(exit().next_state()))
+        start_update(false, false);
+    }
+
+    void trigger_dirty_update() override
+    {
+        AtomicHolder h(this);
+        start_update(false, true);
+    }
+
+    void mark_dirty(unsigned offset, unsigned len) override
+    {
+        if (!len)
         {
-            start_flow(STATE(call_next_listener));
+            return;
         }
+        AtomicHolder h(this);
+        dirtyBegin_ = std::min(dirtyBegin_, offset);
+        unsigned end = offset + len;
+        if (end < offset)
+        {
+            end = UINT_MAX;
+        }
+        dirtyEnd_ = std::max(dirtyEnd_, end);
     }
 
     void register_update_listener(ConfigUpdateListener *listener) OVERRIDE
@@ -117,11 +139,55 @@ public:
     }
 
 private:
+    /// Starts (or restarts) calling the listeners. Must be called with the
+    /// Atomic lock held.
+    /// @param initial_load true if this is the initial load of the
+    /// configuration. In this case every listener is called, regardless of
+    /// the modified range.
+    /// @param use_dirty true if only the listeners overlapping the range
+    /// recorded by mark_dirty need to be called. The recorded range is reset
+    /// either way.
+    void start_update(bool initial_load, bool use_dirty)
+    {
+        unsigned begin = 0;
+        unsigned end = UINT_MAX;
+        if (!initial_load && use_dirty && dirtyBegin_ < dirtyEnd_)
+        {
+            begin = dirtyBegin_;
+            end = dirtyEnd_;
+        }
+        dirtyBegin_ = UINT_MAX;
+        dirtyEnd_ = 0;
+        nextRefresh_ = listeners_.begin();
+        isInitialLoad_ = initial_load ? 1 : 0;
+        needsReboot_ = 0;
+        needsReInit_ = 0;
+        if (is_state(exit().next_state()))
+        {
+            updateBegin_ = begin;
+            updateEnd_ = end;
+            start_flow(STATE(call_next_listener));
+        }
+        else
+        {
+            // We are restarting an update that is in progress. The listeners
+            // that the previous update would have called must still be
+            // called.
+            updateBegin_ = std::min(updateBegin_, begin);
+            updateEnd_ = std::max(updateEnd_, end);
+        }
+    }
+
     Action call_next_listener()
     {
         ConfigUpdateListener *l = nullptr;
         {
             AtomicHolder h(this);
+            while (nextRefresh_ != listeners_.end() && !isInitialLoad_ &&
+                !needs_update(nextRefresh_.operator->()))
+            {
+                ++nextRefresh_;
+            }
             if (nextRefresh_ == listeners_.end())
             {
                 /// TODO(balazs.racz) apply the changes reported.
@@ -171,6 +237,16 @@ private:
         return wait();
     }
 
+    /// @return true if the config range of a listener overlaps with the
+    /// range of the config file modified in the current update.
+    /// @param l is the listener to check.
+    bool needs_update(ConfigUpdateListener *l)
+    {
+        unsigned begin, end;
+        l->get_config_range(&begin, &end);
+        return begin < updateEnd_ && updateBegin_ < end;
+    }
+
     typedef TypedQueue<ConfigUpdateListener> queue_type;
     /// All registered update listeners. Protected by Atomic *this.
     queue_type listeners_;
@@ -180,6 +256,15 @@ private:
     unsigned isInitialLoad_ : 1;
     unsigned needsReboot_ : 1;
     unsigned needsReInit_ : 1;
+    /// First byte of the config file modified since the last update.
+    unsigned dirtyBegin_;
+    /// One past the last byte of the config file modified since the last
+    /// update. If <= dirtyBegin_, no modifications were recorded.
+    unsigned dirtyEnd_;
+    /// Beginning of the modified range for the update in progress.
+    unsigned updateBegin_;
+    /// End of the modified range for the update in progress.
+    unsigned updateEnd_;
     int fd_;
     BarrierNotifiable n_;
 };
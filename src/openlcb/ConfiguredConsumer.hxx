@@ -129,6 +129,13 @@ public:
         return UPDATED;
     }
 
+    void get_config_range(unsigned *begin, unsigned *end) OVERRIDE
+    {
+        // The description is not used by the consumer.
+        *begin = cfg_.event_on().offset();
+        *end = cfg_.event_off().end_offset();
+    }
+
     /// @todo(balazs.racz): implement
     void factory_reset(int fd) OVERRIDE
     {
@@ -191,6 +198,13 @@ public:
         return REINIT_NEEDED; // Causes events identify.
     }
 
+    void get_config_range(unsigned *begin, unsigned *end) OVERRIDE
+    {
+        // The description is not used by the consumer.
+        *begin = cfg_.event().offset();
+        *end = cfg_.duration().end_offset();
+    }
+
     /// @todo(balazs.racz): implement
     void factory_reset(int fd) OVERRIDE
     {
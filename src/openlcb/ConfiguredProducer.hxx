@@ -135,6 +135,13 @@ public:
         return UPDATED;
     }
 
+    void get_config_range(unsigned *begin, unsigned *end) OVERRIDE
+    {
+        // The description is not used by the producer.
+        *begin = cfg_.debounce().offset();
+        *end = cfg_.event_off().end_offset();
+    }
+
     /// @todo(balazs.racz): implement
     void factory_reset(int fd) OVERRIDE
     {
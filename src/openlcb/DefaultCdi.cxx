@@ -41,6 +41,12 @@ namespace openlcb {
 
 extern const uint16_t __attribute__((weak)) CDI_EVENT_OFFSETS[] = {0};
 
+/// Compressed CDI; used only when CDI_DATA is empty. Generated by
+/// compile_cdi -c.
+extern const uint8_t __attribute__((weak)) CDI_COMPRESSED_DATA[] = {0};
+/// Length of CDI_COMPRESSED_DATA. Zero if the CDI is not compressed.
+extern const size_t __attribute__((weak)) CDI_COMPRESSED_SIZE = 0;
+
 extern const char __attribute__((weak)) CDI_DATA[] =
 R"cdi(<?xml version="1.0"?>
 <cdi xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xsi:noNamespaceSchemaLocation="http://openlcb.org/schema/cdi/1/1/cdi.xsd">
@@ -13,6 +13,8 @@
 #include "openlcb/EventHandlerContainer.hxx"
 #include "openlcb/Defs.hxx"
 #include "openlcb/EndianHelper.hxx"
+#include "utils/BufferLatency.hxx"
+#include "utils/Trace.hxx"
 
 namespace openlcb
 {
@@ -21,6 +23,16 @@ namespace openlcb
 EventService *EventService::instance = nullptr;
 static AsyncMutex event_caller_mutex;
 
+/// Time from the arrival of an event protocol message until the event service
+/// starts iterating the handlers for it.
+static LatencyStage event_iterate_latency("event.iterate");
+/// Time from the arrival of an event protocol message until a handler is
+/// called with it; one sample per handler call.
+static LatencyStage event_handler_latency("event.handler");
+/// Time from the arrival of an event protocol message until all its handlers
+/// have been called.
+static LatencyStage event_done_latency("event.done");
+
 EventService::EventService(ExecutorBase *e) : Service(e)
 {
     HASSERT(instance == nullptr);
@@ -62,10 +74,19 @@ EventService::Impl::Impl(EventService *service) : callerFlow_(service)
 #else
     registry.reset(new TreeEventHandlers());
 #endif
+    MetricsRegistry *r = MetricsRegistry::instance();
+    r->add(this, "event.messages", &numEvents_);
+    r->add(this, "event.handler_calls", &numHandlerCalls_);
+    r->add_gauge(
+        this, "event.caller_queue", [this]() { return callerFlow_.queue_size(); });
 }
 
 EventService::Impl::~Impl()
 {
+    if (METRICS_ENABLED)
+    {
+        MetricsRegistry::instance()->remove(this);
+    }
 }
 
 StateFlowBase::Action EventCallerFlow::entry()
@@ -76,6 +97,7 @@ StateFlowBase::Action EventCallerFlow::entry()
 StateFlowBase::Action EventCallerFlow::perform_call()
 {
     n_.reset(this);
+    event_handler_latency.record(message());
     EventHandlerCall *c = message()->data();
     (c->registry_entry->handler->*(c->fn))(*c->registry_entry, c->rep, &n_);
     return wait_and_call(STATE(call_done));
@@ -92,9 +114,6 @@ EventIteratorFlow::EventIteratorFlow(If *async_if, EventService *event_service,
     : IncomingMessageStateFlow(async_if)
     , eventService_(event_service)
     , iterator_(event_service->impl()->registry->create_iterator())
-#ifdef DEBUG_EVENT_PERFORMANCE
-    , mtiValue_(mti_value)
-#endif
 {
     iface()->dispatcher()->register_handler(this, mti_value, mti_mask);
 }
@@ -133,10 +152,10 @@ void DecodeRange(EventReport *r)
 StateFlowBase::Action EventIteratorFlow::entry()
 {
     // at this point: we have the mutex.
-    LOG(VERBOSE, "GlobalFlow::HandleEvent");
-#ifdef DEBUG_EVENT_PERFORMANCE
-    currentProcessStart_ = os_get_time_monotonic();
-#endif
+    TRACE("GlobalFlow::HandleEvent mti %04x", nmsg()->mti);
+    event_iterate_latency.record(message());
+    timestamp_ = message()->timestamp();
+    eventService_->impl()->numEvents_.inc();
     EventReport *rep = &eventReport_;
     rep->src_node = nmsg()->src;
     rep->dst_node = nmsg()->dstNode;
@@ -258,23 +277,11 @@ StateFlowBase::Action EventIteratorFlow::iterate_next()
             incomingDone_ = nullptr;
         }
 
-#ifdef DEBUG_EVENT_PERFORMANCE
-        long long len = os_get_time_monotonic() - currentProcessStart_;
-        numProcessNsec_ += len;
-        countEvents_++;
-        if (countEvents_ >= REPORT_COUNT)
-        {
-            //long msec = numProcessNsec_ / 1000000;
-            //printf("event perf for mti %04x: %ld msec for %d events\n",
-            //       mtiValue_, msec, REPORT_COUNT);
-            countEvents_ = 0;
-            numProcessNsec_ = 0;
-        }
-
-#endif
+        event_done_latency.record(timestamp_);
 
         return exit();
     }
+    eventService_->impl()->numHandlerCalls_.inc();
     return dispatch_event(entry);
 }
 
@@ -286,6 +293,7 @@ StateFlowBase::Action EventIteratorFlow::dispatch_event(const EventRegistryEntry
     eventService_->impl()->callerFlow_.pool()->alloc(&b, nullptr);
     HASSERT(b);
     b->data()->reset(entry, &eventReport_, fn_);
+    b->set_timestamp(timestamp_);
     n_.reset(this);
     b->set_done(&n_);
     eventService_->impl()->callerFlow_.send(b, priority());
@@ -321,6 +329,7 @@ StateFlowBase::Action InlineEventIteratorFlow::perform_call()
     n_.reset(this);
     // It is required to hold on to a child to call abort_if_almost_done.
     auto *c = n_.new_child();
+    event_handler_latency.record(timestamp_);
     (currentEntry_->handler->*(fn_))(*currentEntry_, &eventReport_, &n_);
     if (n_.abort_if_almost_done())
     {
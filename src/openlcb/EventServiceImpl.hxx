@@ -42,6 +42,7 @@
 
 #include "openlcb/EventService.hxx"
 #include "openlcb/EventHandler.hxx"
+#include "utils/Metrics.hxx"
 
 namespace openlcb
 {
@@ -106,6 +107,11 @@ public:
     /// calls need to be sent to this flow.
     EventCallerFlow callerFlow_;
 
+    /// Number of incoming event protocol messages processed.
+    CounterMetric numEvents_;
+    /// Number of event handler calls made.
+    CounterMetric numHandlerCalls_;
+
     enum
     {
         // These address/mask should match all the messages carrying an event
@@ -143,6 +149,10 @@ private:
 protected:
     EventService *eventService_;
 
+    /// Timestamp of the message being processed (see BufferLatency). Kept
+    /// because the message is released before the handlers are called.
+    uint32_t timestamp_ {0};
+
     /// Statically allocated structure for calling the event handlers from the
     /// main event queue.
     EventReport eventReport_;
@@ -159,17 +169,6 @@ protected:
 
     BarrierNotifiable n_;
     EventHandlerFunction fn_;
-
-#ifdef DEBUG_EVENT_PERFORMANCE
-    static const int REPORT_COUNT = 100;
-    /// How many events' cost are accumulated so far.
-    uint8_t countEvents_{0};
-    uint16_t mtiValue_;
-    /// Accumulator of how many msec processingthe events took.
-    long long numProcessNsec_{0};
-    /// When the processing of the current event started.
-    long long currentProcessStart_{0};
-#endif
 };
 
 /** Flow to receive incoming messages of event protocol, and dispatch them to
@@ -40,6 +40,7 @@
 #include "openlcb/IfCanImpl.hxx"
 #include "openlcb/CanDefs.hxx"
 #include "can_frame.h"
+#include "utils/Trace.hxx"
 
 namespace openlcb
 {
@@ -56,6 +57,13 @@ size_t g_alias_use_conflicts = 0;
 extern long long ADDRESSED_MESSAGE_LOOKUP_TIMEOUT_NSEC;
 long long ADDRESSED_MESSAGE_LOOKUP_TIMEOUT_NSEC = SEC_TO_NSEC(1);
 
+LatencyStage can_message_write_latency("if.write_flow");
+
+/// Time from the arrival of a CAN frame until the message parsed from it is
+/// sent to the interface's dispatcher. For multi-frame messages the arrival
+/// of the last frame counts.
+static LatencyStage can_frame_parse_latency("if.parse");
+
 /** This write flow inherits all the business logic from the parent, just
  * maintains a separate allocation queue. This allows global messages to go out
  * even if addressed messages are waiting for destination address
@@ -476,6 +484,7 @@ public:
         {
             buf_.clear();
         }
+        timestamp_ = message()->timestamp();
         release();
         // Get the dispatch flow.
         return allocate_and_call(if_can()->dispatcher(), STATE(send_to_if));
@@ -498,6 +507,8 @@ public:
         {
             m->src.id = if_can()->local_aliases()->lookup(m->src.alias);
         }
+        b->set_timestamp(timestamp_);
+        can_frame_parse_latency.record(b);
         if_can()->dispatcher()->send(b, b->data()->priority());
         return exit();
     }
@@ -505,6 +516,8 @@ public:
 private:
     /// CAN frame ID, saved from the incoming frame.
     uint32_t id_;
+    /// Timestamp of the incoming frame.
+    uint32_t timestamp_;
     /// Payload for the MTI message.
     string buf_;
 };
@@ -561,8 +574,8 @@ public:
         dstHandle_.id = if_can()->local_aliases()->lookup(dstHandle_.alias);
         if (!dstHandle_.id) // Not destined for us.
         {
-            LOG(VERBOSE, "Dropping addressed message not for local destination."
-                         "id %08x Alias %03x",
+            TRACE("Dropping addressed message not for local destination. "
+                  "id %08x Alias %03x",
                 (unsigned)id_, dstHandle_.alias);
             // Drop the frame.
             return release_and_exit();
@@ -619,6 +632,7 @@ public:
                 buf_.clear();
             }
         }
+        timestamp_ = message()->timestamp();
         /** Frame not needed anymore. If we want to save the reserved bits from
          *  the first octet, we need to revise this. */
         release();
@@ -643,12 +657,16 @@ public:
         {
             m->src.id = if_can()->local_aliases()->lookup(m->src.alias);
         }
+        b->set_timestamp(timestamp_);
+        can_frame_parse_latency.record(b);
         if_can()->dispatcher()->send(b, b->data()->priority());
         return exit();
     }
 
 private:
     uint32_t id_;
+    /// Timestamp of the incoming frame.
+    uint32_t timestamp_;
     string buf_;
     NodeHandle dstHandle_;
     /// Reassembly buffers for multi-frame messages.
@@ -692,6 +710,22 @@ IfCan::~IfCan()
 {
 }
 
+template <> void IfCan::add_metrics<false>(const char *)
+{
+}
+
+template <bool ENABLED> void IfCan::add_metrics(const char *prefix)
+{
+    std::string p(prefix);
+    localAliases_.register_metrics((p + ".alias.local").c_str());
+    remoteAliases_.register_metrics((p + ".alias.remote").c_str());
+}
+
+void IfCan::register_metrics(const char *prefix)
+{
+    add_metrics<METRICS_ENABLED>(prefix);
+}
+
 void IfCan::add_owned_flow(Executable *e)
 {
     ownedFlows_.push_back(std::unique_ptr<Executable>(e));
@@ -113,6 +113,12 @@ public:
     /// Sets the alias allocator for this If. Takes ownership of pointer.
     void set_alias_allocator(AliasAllocator *a);
 
+    /// Exports the metrics of the alias caches into the MetricsRegistry as
+    /// "<prefix>.alias.local.*" and "<prefix>.alias.remote.*". Compiles to
+    /// nothing when METRICS_ENABLED is false. @param prefix tells this
+    /// interface apart from the other ones in the process, e.g. "if".
+    void register_metrics(const char *prefix);
+
     void add_owned_flow(Executable *e) OVERRIDE;
 
     bool matching_node(NodeHandle expected, NodeHandle actual) OVERRIDE;
@@ -122,6 +128,10 @@ public:
 private:
     void canonicalize_handle(NodeHandle* h);
 
+    /// Implementation of register_metrics(). The instance for false is empty.
+    /// @param prefix is prepended to the metric names.
+    template <bool ENABLED> void add_metrics(const char *prefix);
+
     friend class CanFrameWriteFlow; // accesses the device and the hubport.
 
     /** Aliases we know are owned by local (virtual or proxied) nodes.
@@ -45,6 +45,11 @@ namespace openlcb
 
 extern long long ADDRESSED_MESSAGE_LOOKUP_TIMEOUT_NSEC;
 
+/// Time the message spent in an IfCan write flow: from the write flow's
+/// send() until its last CAN frame is sent to the hub. Does not include the
+/// time before the producer called send().
+extern LatencyStage can_message_write_latency;
+
 /** Implements the write-side conversion logic from generic messages to CAN
  * frames. */
 class CanMessageWriteFlow : public WriteFlowBase
@@ -184,6 +189,7 @@ private:
     {
         auto *b = get_allocation_result(if_can()->frame_write_flow());
         b->set_done(message()->new_child());
+        b->set_timestamp(message()->timestamp());
         struct can_frame *f = b->data()->mutable_frame();
         if (nmsg()->mti & (Defs::MTI_DATAGRAM_MASK | Defs::MTI_SPECIAL_MASK |
                            Defs::MTI_RESERVED_MASK))
@@ -250,6 +256,7 @@ private:
         }
         else
         {
+            can_message_write_latency.record(message());
             return call_immediately(STATE(send_finished));
         }
     }
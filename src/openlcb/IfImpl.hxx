@@ -37,6 +37,7 @@
 #define _NMRANET_IFIMPL_HXX_
 
 #include "openlcb/If.hxx"
+#include "utils/BufferLatency.hxx"
 
 namespace openlcb
 {
@@ -50,6 +51,15 @@ public:
     {
     }
 
+    /// Stamps the outgoing message with the time it was handed to this write
+    /// flow (see BufferLatency), then queues it. The stamp does not include
+    /// the time the producer spent before calling send().
+    void send(Buffer<GenMessage> *msg, unsigned priority = UINT_MAX) override
+    {
+        BufferLatency::stamp(msg);
+        StateFlow<Buffer<GenMessage>, QList<4>>::send(msg, priority);
+    }
+
 protected:
     /** This function will be called (on the main executor) to initiate sending
      * this message to the hardware. The flow will then execute the returned
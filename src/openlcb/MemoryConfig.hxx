@@ -40,6 +40,8 @@
 #include "openlcb/MemoryConfig.hxx"
 #include "utils/Destructable.hxx"
 #include "utils/ConfigUpdateService.hxx"
+#include "utils/Metrics.hxx"
+#include "utils/PairCompress.hxx"
 
 class Notifiable;
 
@@ -321,6 +323,96 @@ private:
     const address_t len_; //< Length of block to serve.
 };
 
+/// Memory space implementation that exports a read-only block of data that is
+/// stored compressed with @ref pair_compress (for example the CDI as generated
+/// by compile_cdi -c). The data is decompressed on the fly for every read;
+/// reads at increasing offsets continue decoding where the previous read
+/// stopped.
+class CompressedMemoryBlock : public MemorySpace
+{
+public:
+    /** Initializes a memory block with a compressed blob. The address range
+     * [data, data+len) must be dereferenceable for read so long as this
+     * object is alive. It may point into read-only memory. */
+    CompressedMemoryBlock(const void *data, size_t len)
+        : decompressor_(reinterpret_cast<const uint8_t *>(data), len)
+    {
+        HASSERT(decompressor_.valid());
+    }
+
+    address_t max_address() OVERRIDE
+    {
+        return decompressor_.size() - 1;
+    }
+
+    size_t read(address_t source, uint8_t *dst, size_t len, errorcode_t *error,
+                Notifiable *again) OVERRIDE
+    {
+        if (source >= decompressor_.size())
+        {
+            *error = MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
+            return 0;
+        }
+        return decompressor_.read(source, dst, len);
+    }
+
+private:
+    PairDecompressor decompressor_; //< Decodes the data to serve.
+};
+
+/// Read-only memory space that exports the text rendering of the
+/// MetricsRegistry (one "name type value" line per metric). A read at address
+/// zero takes a fresh snapshot; reads at higher addresses are served from the
+/// same snapshot, so a client reading the space sequentially gets a
+/// consistent dump.
+class MetricsMemoryBlock : public MemorySpace
+{
+public:
+    /** @param prefix if not null, only metrics whose name starts with this
+     * string are exported. Must stay alive as long as *this. */
+    MetricsMemoryBlock(const char *prefix = nullptr)
+        : prefix_(prefix)
+    {
+    }
+
+    address_t max_address() OVERRIDE
+    {
+        if (snapshot_.empty())
+        {
+            refresh();
+        }
+        return snapshot_.empty() ? 0 : snapshot_.size() - 1;
+    }
+
+    size_t read(address_t source, uint8_t *dst, size_t len, errorcode_t *error,
+                Notifiable *again) OVERRIDE
+    {
+        if (source == 0)
+        {
+            refresh();
+        }
+        if (source >= snapshot_.size())
+        {
+            *error = MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
+            return 0;
+        }
+        size_t count = std::min<size_t>(len, snapshot_.size() - source);
+        memcpy(dst, snapshot_.data() + source, count);
+        return count;
+    }
+
+private:
+    /// Re-renders the metrics into the snapshot.
+    void refresh()
+    {
+        snapshot_.clear();
+        MetricsRegistry::instance()->render(&snapshot_, prefix_);
+    }
+
+    const char *prefix_; //< Filter for the exported metric names.
+    std::string snapshot_; //< Rendered metrics being served.
+};
+
 /// Memory space implementation that exports a some memory-mapped data as a
 /// read-write memory space. The data must be given as a void* pointer pointing
 /// to RAM (or other memory-mapped structures).
@@ -577,7 +669,8 @@ private:
             }
             case MemoryConfigDefs::COMMAND_UPDATE_COMPLETE:
             {
-                Singleton<ConfigUpdateService>::instance()->trigger_update();
+                Singleton<ConfigUpdateService>::instance()
+                    ->trigger_dirty_update();
                 return respond_ok(0);
             }
             case MemoryConfigDefs::COMMAND_RESET:
@@ -910,6 +1003,7 @@ private:
             response_len++;
         if (error == 0)
         {
+            mark_config_dirty();
             response_.assign(response_len, c);
             out_bytes()[1] = MemoryConfigDefs::COMMAND_WRITE_REPLY;
         }
@@ -925,6 +1019,31 @@ private:
         return respond_ok(DatagramClient::REPLY_PENDING);
     }
 
+    /// Tells the config update service which bytes of the config file were
+    /// modified by the current write command. Only for the config space is
+    /// the memory space address known to be the config file offset. The ACDI
+    /// user space may be stored anywhere (or in a different file), so a write
+    /// to it marks the entire config as dirty.
+    void mark_config_dirty()
+    {
+        if (!Singleton<ConfigUpdateService>::exists())
+        {
+            return;
+        }
+        int space_number = get_space_number();
+        if (space_number == MemoryConfigDefs::SPACE_CONFIG)
+        {
+            Singleton<ConfigUpdateService>::instance()->mark_dirty(
+                get_address(), currentOffset_);
+        }
+        else if (space_number == MemoryConfigDefs::SPACE_ACDI_USR &&
+            currentOffset_)
+        {
+            Singleton<ConfigUpdateService>::instance()->mark_dirty(
+                0, UINT_MAX);
+        }
+    }
+
     /// @return true iff we have a custom space
     bool has_custom_space()
     {
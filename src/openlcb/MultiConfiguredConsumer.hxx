@@ -99,6 +99,12 @@ public:
         return REINIT_NEEDED; // Causes events identify.
     }
 
+    void get_config_range(unsigned *begin, unsigned *end) OVERRIDE
+    {
+        *begin = offset_.offset();
+        *end = *begin + size_ * config_entry_type::size();
+    }
+
     /// @todo(balazs.racz): implement
     void factory_reset(int fd) OVERRIDE
     {
@@ -0,0 +1,332 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file SimpleInfoCache.cxx
+ *
+ * Caches Simple Node Ident Info and Protocol Identification replies in a
+ * gateway so that repeated queries for the same node are answered without
+ * crossing the bus to the node.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "openlcb/SimpleInfoCache.hxx"
+
+#include <algorithm>
+
+#include "openlcb/CanDefs.hxx"
+#include "openlcb/If.hxx"
+
+namespace openlcb
+{
+
+namespace
+{
+/// A complete SNIP reply has this many null-terminated strings (4 from the
+/// manufacturer section and 2 from the user section).
+static const unsigned SNIP_NUM_STRINGS = 6;
+/// Maximum length of a SNIP reply we accept.
+static const unsigned SNIP_MAX_LENGTH = 253;
+
+/// @return true if payload is a complete SNIP reply.
+/// @param payload is the assembled payload.
+bool is_complete_snip(const string &payload)
+{
+    return payload.size() <= SNIP_MAX_LENGTH &&
+        (unsigned)std::count(payload.begin(), payload.end(), 0) >=
+        SNIP_NUM_STRINGS;
+}
+} // namespace
+
+bool SimpleInfoCache::process_frame(
+    const struct can_frame &frame, std::vector<struct can_frame> *responses)
+{
+    if (!IS_CAN_FRAME_EFF(frame) || IS_CAN_FRAME_RTR(frame) ||
+        IS_CAN_FRAME_ERR(frame))
+    {
+        return false;
+    }
+    uint32_t can_id = GET_CAN_FRAME_ID_EFF(frame);
+    if (CanDefs::get_frame_type(can_id) == CanDefs::CONTROL_MSG)
+    {
+        process_control_frame(frame);
+        return false;
+    }
+    if (CanDefs::get_can_frame_type(can_id) != CanDefs::GLOBAL_ADDRESSED)
+    {
+        return false;
+    }
+    NodeAlias src = CanDefs::get_src(can_id);
+    Defs::MTI mti = static_cast<Defs::MTI>(CanDefs::get_mti(can_id));
+    // The low bit distinguishes the simple node variants of these MTIs.
+    switch (mti & ~1)
+    {
+        case Defs::MTI_INITIALIZATION_COMPLETE:
+            if (frame.can_dlc == 6)
+            {
+                NodeID id = data_to_node_id(frame.data);
+                learn_alias(src, id);
+                invalidate(id);
+            }
+            return false;
+        case Defs::MTI_VERIFIED_NODE_ID_NUMBER:
+            if (frame.can_dlc == 6)
+            {
+                learn_alias(src, data_to_node_id(frame.data));
+            }
+            return false;
+        default:
+            break;
+    }
+    if (!Defs::get_mti_address(mti) || frame.can_dlc < 2)
+    {
+        return false;
+    }
+    NodeAlias dst = ((frame.data[0] & 0xf) << 8) | frame.data[1];
+    uint8_t flags = frame.data[0] & 0xf0;
+    const char *payload = reinterpret_cast<const char *>(frame.data + 2);
+    unsigned len = frame.can_dlc - 2;
+    switch (mti)
+    {
+        case Defs::MTI_IDENT_INFO_REPLY:
+        {
+            uint32_t key = (src << 12) | dst;
+            if (!(flags & CanDefs::NOT_FIRST_FRAME))
+            {
+                pendingSnip_[key].clear();
+            }
+            auto it = pendingSnip_.find(key);
+            if (it == pendingSnip_.end())
+            {
+                // Middle of a reply we did not see the start of.
+                return false;
+            }
+            it->second.append(payload, len);
+            if (flags & CanDefs::NOT_LAST_FRAME)
+            {
+                if (it->second.size() > SNIP_MAX_LENGTH)
+                {
+                    pendingSnip_.erase(it);
+                }
+                return false;
+            }
+            if (is_complete_snip(it->second))
+            {
+                Entry *e = lookup_or_create(src);
+                if (e)
+                {
+                    e->snip.swap(it->second);
+                    ++stats_.stores;
+                }
+            }
+            pendingSnip_.erase(it);
+            return false;
+        }
+        case Defs::MTI_PROTOCOL_SUPPORT_REPLY:
+        {
+            if (flags || len == 0)
+            {
+                // Multi-frame PIP replies are not cached.
+                return false;
+            }
+            Entry *e = lookup_or_create(src);
+            if (e)
+            {
+                e->pip.assign(payload, len);
+                ++stats_.stores;
+            }
+            return false;
+        }
+        case Defs::MTI_IDENT_INFO_REQUEST:
+        {
+            Entry *e = lookup(dst);
+            if (!e || e->snip.empty())
+            {
+                ++stats_.misses;
+                return false;
+            }
+            ++stats_.hits;
+            touch(e);
+            render_reply(Defs::MTI_IDENT_INFO_REPLY, dst, src, e->snip, responses);
+            return true;
+        }
+        case Defs::MTI_PROTOCOL_SUPPORT_INQUIRY:
+        {
+            Entry *e = lookup(dst);
+            if (!e || e->pip.empty())
+            {
+                ++stats_.misses;
+                return false;
+            }
+            ++stats_.hits;
+            touch(e);
+            render_reply(
+                Defs::MTI_PROTOCOL_SUPPORT_REPLY, dst, src, e->pip, responses);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void SimpleInfoCache::process_control_frame(const struct can_frame &frame)
+{
+    uint32_t can_id = GET_CAN_FRAME_ID_EFF(frame);
+    if (CanDefs::is_cid_frame(can_id))
+    {
+        return;
+    }
+    NodeAlias src = CanDefs::get_src(can_id);
+    switch (CanDefs::get_control_field(can_id))
+    {
+        case CanDefs::AMD_FRAME:
+            if (frame.can_dlc == 6)
+            {
+                learn_alias(src, data_to_node_id(frame.data));
+            }
+            break;
+        case CanDefs::AMR_FRAME:
+        {
+            aliasMap_.erase(src);
+            // Drops partial replies from or to the released alias.
+            for (auto it = pendingSnip_.begin(); it != pendingSnip_.end();)
+            {
+                if ((it->first >> 12) == src || (it->first & 0xfff) == src)
+                {
+                    it = pendingSnip_.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void SimpleInfoCache::learn_alias(NodeAlias alias, NodeID id)
+{
+    aliasMap_[alias] = id;
+}
+
+void SimpleInfoCache::invalidate(NodeID id)
+{
+    if (cache_.erase(id))
+    {
+        ++stats_.invalidations;
+    }
+}
+
+SimpleInfoCache::Entry *SimpleInfoCache::lookup(NodeAlias alias)
+{
+    auto ait = aliasMap_.find(alias);
+    if (ait == aliasMap_.end())
+    {
+        return nullptr;
+    }
+    auto it = cache_.find(ait->second);
+    if (it == cache_.end())
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+SimpleInfoCache::Entry *SimpleInfoCache::lookup_or_create(NodeAlias alias)
+{
+    auto ait = aliasMap_.find(alias);
+    if (ait == aliasMap_.end())
+    {
+        return nullptr;
+    }
+    if (cache_.size() >= maxNodes_ && cache_.find(ait->second) == cache_.end())
+    {
+        if (!maxNodes_)
+        {
+            return nullptr;
+        }
+        evict_oldest();
+    }
+    Entry *e = &cache_[ait->second];
+    touch(e);
+    return e;
+}
+
+void SimpleInfoCache::evict_oldest()
+{
+    auto oldest = cache_.begin();
+    for (auto it = cache_.begin(); it != cache_.end(); ++it)
+    {
+        // Differences are wraparound-safe as long as fewer than 2^32 uses
+        // happen during the lifetime of an entry.
+        if (useCounter_ - it->second.lastUse >
+            useCounter_ - oldest->second.lastUse)
+        {
+            oldest = it;
+        }
+    }
+    cache_.erase(oldest);
+    ++stats_.evictions;
+}
+
+void SimpleInfoCache::render_reply(Defs::MTI mti, NodeAlias src, NodeAlias dst,
+    const string &payload, std::vector<struct can_frame> *responses)
+{
+    uint32_t can_id;
+    CanDefs::set_fields(&can_id, src, mti, CanDefs::GLOBAL_ADDRESSED,
+        CanDefs::NMRANET_MSG, CanDefs::NORMAL_PRIORITY);
+    size_t ofs = 0;
+    do
+    {
+        responses->emplace_back();
+        struct can_frame &f = responses->back();
+        CLR_CAN_FRAME_ERR(f);
+        CLR_CAN_FRAME_RTR(f);
+        SET_CAN_FRAME_EFF(f);
+        SET_CAN_FRAME_ID_EFF(f, can_id);
+        size_t len = std::min(payload.size() - ofs, (size_t)6);
+        uint8_t flags = 0;
+        if (ofs)
+        {
+            flags |= CanDefs::NOT_FIRST_FRAME;
+        }
+        if (ofs + len < payload.size())
+        {
+            flags |= CanDefs::NOT_LAST_FRAME;
+        }
+        f.data[0] = flags | (dst >> 8);
+        f.data[1] = dst & 0xff;
+        memcpy(f.data + 2, payload.data() + ofs, len);
+        f.can_dlc = len + 2;
+        ofs += len;
+    } while (ofs < payload.size());
+}
+
+} // namespace openlcb
@@ -0,0 +1,197 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file SimpleInfoCache.hxx
+ *
+ * Caches Simple Node Ident Info and Protocol Identification replies in a
+ * gateway so that repeated queries for the same node are answered without
+ * crossing the bus to the node.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _OPENLCB_SIMPLEINFOCACHE_HXX_
+#define _OPENLCB_SIMPLEINFOCACHE_HXX_
+
+#include <map>
+#include <vector>
+
+#include "can_frame.h"
+#include "openlcb/Defs.hxx"
+#include "utils/macros.h"
+
+namespace openlcb
+{
+
+/** Caching proxy for SNIP and PIP replies, operating on CAN frames passing
+ * through a gateway or routing hub.
+ *
+ * The cache observes every frame (process_frame). It learns the alias to Node
+ * ID mapping from AMD, Initialization Complete and Verified Node ID frames,
+ * reassembles SNIP replies and records PIP replies, keyed by the Node ID of
+ * the replying node. When a SNIP or PIP request arrives for a node whose reply
+ * is cached, the reply frames are generated locally (with the remote node's
+ * alias as source) and the request is not forwarded. An Initialization
+ * Complete message from a node drops its cached entries, because the node
+ * might have changed its name or protocol set while it was restarting. When
+ * the cache is full, the least recently used entry is evicted.
+ *
+ * This class is not thread-safe; the caller needs to serialize all calls,
+ * including stats() and size() (the routing hub does this with its own
+ * lock).
+ */
+class SimpleInfoCache
+{
+public:
+    /// Counters exported for monitoring.
+    struct Stats
+    {
+        /// Number of requests answered from the cache.
+        unsigned hits{0};
+        /// Number of requests that had to be forwarded to the node.
+        unsigned misses{0};
+        /// Number of replies stored in the cache.
+        unsigned stores{0};
+        /// Number of entries dropped due to a node re-initializing.
+        unsigned invalidations{0};
+        /// Number of entries dropped because the cache was full.
+        unsigned evictions{0};
+    };
+
+    /// Constructor.
+    /// @param max_nodes is the maximum number of nodes to keep cached
+    /// information for.
+    SimpleInfoCache(unsigned max_nodes = 256)
+        : maxNodes_(max_nodes)
+    {
+    }
+
+    /** Processes a frame passing through the gateway.
+     *
+     * @param frame is the incoming frame.
+     * @param responses if the frame was answered from the cache, the reply
+     * frames will be appended here. These need to be sent only to the port
+     * where frame came from.
+     * @return true if the frame was answered from the cache and should not be
+     * forwarded; false if the frame should be routed as usual.
+     */
+    bool process_frame(
+        const struct can_frame &frame, std::vector<struct can_frame> *responses);
+
+    /// @return monitoring counters.
+    const Stats &stats()
+    {
+        return stats_;
+    }
+
+    /// @return the number of nodes with cached information.
+    size_t size()
+    {
+        return cache_.size();
+    }
+
+    /// Drops all cached data.
+    void clear()
+    {
+        cache_.clear();
+        pendingSnip_.clear();
+    }
+
+private:
+    /// Cached information about a single node.
+    struct Entry
+    {
+        /// Assembled SNIP reply payload. Empty if not known.
+        string snip;
+        /// PIP reply payload. Empty if not known.
+        string pip;
+        /// Value of useCounter_ when this entry was last stored or hit.
+        uint32_t lastUse{0};
+    };
+
+    /// Handles a CAN control frame (alias map definition and reset).
+    void process_control_frame(const struct can_frame &frame);
+
+    /// Records an alias to Node ID mapping.
+    /// @param alias is the alias.
+    /// @param id is the Node ID from the frame payload.
+    void learn_alias(NodeAlias alias, NodeID id);
+
+    /// Drops the cached information about a node.
+    /// @param id is the node that re-initialized.
+    void invalidate(NodeID id);
+
+    /// @return the cache entry for a given alias, or nullptr if the Node ID of
+    /// the alias is unknown or no data is cached.
+    /// @param alias is the alias of the node.
+    Entry *lookup(NodeAlias alias);
+
+    /// @return a new or existing cache entry for an alias, or nullptr if the
+    /// Node ID is not known.
+    /// @param alias is the alias of the node.
+    Entry *lookup_or_create(NodeAlias alias);
+
+    /// Removes the least recently used entry from cache_.
+    void evict_oldest();
+
+    /// Marks an entry as most recently used.
+    /// @param e is the entry.
+    void touch(Entry *e)
+    {
+        e->lastUse = ++useCounter_;
+    }
+
+    /// Appends frames to responses that carry an addressed message from the
+    /// cache.
+    /// @param mti is the reply MTI.
+    /// @param src is the alias of the node whose reply we are proxying.
+    /// @param dst is the alias of the requesting node.
+    /// @param payload is the message payload.
+    /// @param responses is where to append the frames.
+    void render_reply(Defs::MTI mti, NodeAlias src, NodeAlias dst,
+        const string &payload, std::vector<struct can_frame> *responses);
+
+    /// Max number of entries in cache_.
+    unsigned maxNodes_;
+    /// Node ID of the aliases we have seen on the bus.
+    std::map<NodeAlias, NodeID> aliasMap_;
+    /// Cached data, keyed by Node ID.
+    std::map<NodeID, Entry> cache_;
+    /// Partially received SNIP replies. Key is (src alias << 12) | dst alias.
+    std::map<uint32_t, string> pendingSnip_;
+    /// Incremented at every use of a cache entry; orders the entries by
+    /// recency.
+    uint32_t useCounter_{0};
+    /// Monitoring counters.
+    Stats stats_;
+
+    DISALLOW_COPY_AND_ASSIGN(SimpleInfoCache);
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_SIMPLEINFOCACHE_HXX_
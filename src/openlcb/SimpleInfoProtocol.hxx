@@ -38,8 +38,12 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "openlcb/If.hxx"
 #include "executor/StateFlow.hxx"
+#include "utils/ConfigUpdateListener.hxx"
 
 namespace openlcb
 {
@@ -124,6 +128,14 @@ typedef StateFlow<Buffer<SimpleInfoResponse>, QList<1>> SimpleInfoFlowBase;
 /// pointer. The SimpleInfoFlow will assemble, fragment and send the response
 /// message.
 ///
+/// By default the response is streamed from the descriptor table while the
+/// messages are being filled. With set_cache_responses(true) the payload is
+/// instead rendered in full once, kept (keyed by the descriptor array) and
+/// reused for later requests, thus the files are not read again. Since the rendered data only depends on the descriptor, nodes
+/// that share a descriptor share the cached response. The cache has to be
+/// dropped when the referenced data changes; registering cache_invalidator()
+/// with the ConfigUpdateService does this on every config update.
+///
 /// Example: see @SNIPHandler.
 class SimpleInfoFlow : public SimpleInfoFlowBase
 {
@@ -146,28 +158,173 @@ public:
         , maxBytesPerMessage_(
               max_bytes_per_message > 255 ? 255 : max_bytes_per_message)
         , useContinueBits_(use_continue_bits ? 1 : 0)
+        , cacheResponses_(0)
     {
     }
 
     ~SimpleInfoFlow()
     {
-        if (fd_ >= 0) {
-            ::close(fd_);
-            fd_ = -1;
-            fileName_ = nullptr;
+        close_file();
+    }
+
+    /// Enables or disables keeping the rendered responses. Disabling also
+    /// drops the cached responses. Must be called on the executor of this
+    /// flow. Off by default.
+    ///
+    /// Only enable this if every change to the source data is followed by a
+    /// config update (or invalidate_cache()). Otherwise the responses stay
+    /// stale, for example after a remote write without Update Complete, or
+    /// after the application writes the config file without calling
+    /// trigger_update().
+    /// @param enabled true to keep the rendered responses between requests.
+    void set_cache_responses(bool enabled)
+    {
+        cacheResponses_ = enabled ? 1 : 0;
+        if (!enabled)
+        {
+            invalidate_cache();
         }
     }
 
+    /// Drops all cached responses; the next request for each descriptor will
+    /// be rendered from the source data again. Must be called on the executor
+    /// of this flow.
+    void invalidate_cache()
+    {
+        // The entries are not freed here, because the flow might be in the
+        // middle of sending one of them.
+        for (auto &e : cache_)
+        {
+            e.valid = false;
+        }
+    }
+
+    /// @return a config update listener that invalidates the cached responses
+    /// when the configuration file changes. The caller has to register this
+    /// with the ConfigUpdateService.
+    ConfigUpdateListener *cache_invalidator()
+    {
+        return &invalidator_;
+    }
+
 private:
+    /// Config listener that drops the cached responses of the parent flow.
+    class CacheInvalidator : public ConfigUpdateListener
+    {
+    public:
+        /// Constructor. @param parent is the owning flow.
+        CacheInvalidator(SimpleInfoFlow *parent)
+            : parent_(parent)
+        {
+        }
+
+        UpdateAction apply_configuration(
+            int fd, bool initial_load, BarrierNotifiable *done) OVERRIDE
+        {
+            AutoNotify n(done);
+            parent_->invalidate_cache();
+            return UPDATED;
+        }
+
+        void factory_reset(int fd) OVERRIDE
+        {
+            parent_->invalidate_cache();
+        }
+
+        void get_config_range(unsigned *begin, unsigned *end) OVERRIDE
+        {
+            *begin = parent_->fileBegin_;
+            *end = parent_->fileEnd_;
+        }
+
+    private:
+        SimpleInfoFlow *parent_;
+    };
+
+    /// A rendered response.
+    struct CacheEntry
+    {
+        /// Which response this is.
+        const SimpleInfoDescriptor *descriptor;
+        /// False if the payload needs to be rendered again.
+        bool valid;
+        /// Rendered payload.
+        string payload;
+    };
+
     Action entry() OVERRIDE
     {
         HASSERT(message()->data()->src);
         HASSERT(message()->data()->descriptor);
+        isFirstMessage_ = 1;
+        if (cacheResponses_)
+        {
+            CacheEntry *e = find_cache_entry(message()->data()->descriptor);
+            if (!e->valid)
+            {
+                render_payload(&e->payload);
+                e->valid = true;
+            }
+            payload_ = &e->payload;
+            payloadOffset_ = 0;
+        }
+        else
+        {
+            payload_ = nullptr;
+            entryOffset_ = 0;
+            byteOffset_ = 0;
+            update_for_next_entry();
+        }
+        return call_immediately(STATE(continue_send));
+    }
+
+    /// @return the cache entry to use for a given descriptor.
+    /// @param descriptor is the descriptor array of the response.
+    CacheEntry *find_cache_entry(const SimpleInfoDescriptor *descriptor)
+    {
+        for (auto &e : cache_)
+        {
+            if (e.descriptor == descriptor)
+            {
+                return &e;
+            }
+        }
+        cache_.push_back({descriptor, false, string()});
+        return &cache_.back();
+    }
+
+    /// Assembles the entire response payload from the descriptor of the
+    /// current message.
+    /// @param payload will be overwritten with the response data.
+    void render_payload(string *payload)
+    {
+        payload->clear();
         entryOffset_ = 0;
         byteOffset_ = 0;
-        isFirstMessage_ = 1;
         update_for_next_entry();
-        return call_immediately(STATE(continue_send));
+        while (!is_eof())
+        {
+            payload->push_back(current_byte());
+            step_byte();
+        }
+        // We will not need the file again until the cache is invalidated.
+        close_file();
+    }
+
+    /// @return true if all bytes of the current response were sent.
+    bool is_send_done()
+    {
+        return payload_ ? payloadOffset_ >= payload_->size() : is_eof();
+    }
+
+    /// Closes the last opened file, if any.
+    void close_file()
+    {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+            fileName_ = nullptr;
+        }
     }
 
     const SimpleInfoDescriptor &current_descriptor()
@@ -199,6 +356,11 @@ private:
         }
         int ret = lseek(fd_, d.arg2, SEEK_SET);
         HASSERT(ret != -1);
+        // Records which bytes of the file we depend on.
+        unsigned len =
+            d.cmd == SimpleInfoDescriptor::FILE_LITERAL_BYTE ? 1 : d.arg;
+        fileBegin_ = std::min(fileBegin_, (unsigned)d.arg2);
+        fileEnd_ = std::max(fileEnd_, (unsigned)d.arg2 + len);
     }
 
     /** Call this function after updating entryOffset_. */
@@ -344,7 +506,7 @@ private:
 
     Action continue_send()
     {
-        if (is_eof())
+        if (is_send_done())
         {
             return release_and_exit();
         }
@@ -360,16 +522,27 @@ private:
                                             ->src->iface()
                                             ->addressed_message_write_flow());
         const SimpleInfoResponse &r = *message()->data();
-        b->data()->reset(r.mti, r.src->node_id(), r.dst, EMPTY_PAYLOAD);
-        for (uint8_t offset = 0; offset < maxBytesPerMessage_ && !is_eof();
-             ++offset, step_byte())
+        if (payload_)
         {
-            b->data()->payload.push_back(current_byte());
+            size_t len = std::min(payload_->size() - payloadOffset_,
+                (size_t)maxBytesPerMessage_);
+            b->data()->reset(r.mti, r.src->node_id(), r.dst,
+                payload_->substr(payloadOffset_, len));
+            payloadOffset_ += len;
+        }
+        else
+        {
+            b->data()->reset(r.mti, r.src->node_id(), r.dst, EMPTY_PAYLOAD);
+            for (uint8_t offset = 0; offset < maxBytesPerMessage_ && !is_eof();
+                 ++offset, step_byte())
+            {
+                b->data()->payload.push_back(current_byte());
+            }
         }
         b->data()->set_flag_dst(GenMessage::WAIT_FOR_LOCAL_LOOPBACK);
         if (useContinueBits_)
         {
-            if (!is_eof())
+            if (!is_send_done())
             {
                 b->data()->set_flag_dst(
                     GenMessage::DSTFLAG_NOT_LAST_MESSAGE);
@@ -399,10 +572,10 @@ private:
     /** Whether this is the first reply message we are sending out. Used with
      * the continuation feature. */
     unsigned isFirstMessage_ : 1;
+    /** Configuration option. See set_cache_responses(). */
+    unsigned cacheResponses_ : 1;
     /** Tells which descriptor entry we are processing. */
     unsigned entryOffset_ : 5;
-#pragma clang diagnostic ignored "-Wunused-private-field"
-    unsigned reserved_ : 1; // for alignment
 
     /** Byte offset within a descriptor entry. */
     unsigned byteOffset_ : 8;
@@ -414,6 +587,20 @@ private:
     const char* fileName_{nullptr};
     /// fd of the last file we opened.
     int fd_{-1};
+    /// Lowest file offset any descriptor read from.
+    unsigned fileBegin_{UINT_MAX};
+    /// One past the highest file offset any descriptor read from.
+    unsigned fileEnd_{0};
+
+    /// Rendered responses. Empty when caching was never enabled.
+    std::vector<CacheEntry> cache_;
+    /// Cached payload of the response being sent, or nullptr if the
+    /// response is streamed from the descriptor table.
+    const string *payload_{nullptr};
+    /// Offset in payload_ of the next byte to send.
+    size_t payloadOffset_{0};
+    /// Config listener that calls invalidate_cache().
+    CacheInvalidator invalidator_{this};
 
     BarrierNotifiable n_;
 };
@@ -60,6 +60,10 @@ namespace openlcb
 SimpleCanStackBase::SimpleCanStackBase(const openlcb::NodeID node_id)
 {
     AddAliasAllocator(node_id, &ifCan_);
+    // Applications can turn on SNIP response caching with
+    // info_flow()->set_cache_responses(true); this drops the cache when the
+    // config file (which holds the user name and description) is updated.
+    configUpdateFlow_.register_update_listener(infoFlow_.cache_invalidator());
 }
 
 SimpleCanStack::SimpleCanStack(const openlcb::NodeID node_id)
@@ -119,6 +123,14 @@ void SimpleCanStackBase::default_start_node()
             node(), MemoryConfigDefs::SPACE_CDI, space);
         additionalComponents_.emplace_back(space);
     }
+    else if (CDI_COMPRESSED_SIZE > 0)
+    {
+        auto *space = new CompressedMemoryBlock(
+            CDI_COMPRESSED_DATA, CDI_COMPRESSED_SIZE);
+        memoryConfigHandler_.registry()->insert(
+            node(), MemoryConfigDefs::SPACE_CDI, space);
+        additionalComponents_.emplace_back(space);
+    }
     if (CONFIG_FILENAME != nullptr)
     {
         auto *space = new FileMemorySpace(CONFIG_FILENAME, CONFIG_FILE_SIZE);
@@ -64,6 +64,11 @@ namespace openlcb
 
 /// This symbol contains the embedded text of the CDI xml file.
 extern const char CDI_DATA[];
+/// This symbol contains the CDI xml file compressed with pair_compress. Used
+/// only if CDI_DATA is empty.
+extern const uint8_t CDI_COMPRESSED_DATA[];
+/// Length of the compressed CDI in bytes, or zero if there is none.
+extern const size_t CDI_COMPRESSED_SIZE;
 
 /// This symbol must be defined by the application to tell which file to open
 /// for the configuration listener.
@@ -35,9 +35,13 @@
 
 #include "openlcb/TractionProxy.hxx"
 
+#include <map>
+
 #include "openlcb/EventHandlerTemplates.hxx"
 #include "dcc/Loco.hxx"
+#include "openlcb/AliasAllocator.hxx"
 #include "openlcb/If.hxx"
+#include "openlcb/IfCan.hxx"
 
 namespace openlcb
 {
@@ -102,6 +106,31 @@ public:
         return proxyNode_;
     }
 
+    /// Looks up the train node for a given legacy address, creating it if
+    /// this is the first request for that address.
+    /// @param system is the PROXYTYPE_* of the request.
+    /// @param addr_hi is the high byte of the address.
+    /// @param addr_lo is the low byte of the address.
+    /// @return the train node or nullptr if it could not be created.
+    Node *find_or_create_train(uint8_t system, uint8_t addr_hi,
+                               uint8_t addr_lo)
+    {
+        uint32_t key = (static_cast<uint32_t>(system) << 16) |
+            (static_cast<uint32_t>(addr_hi) << 8) | addr_lo;
+        auto it = trains_.find(key);
+        if (it != trains_.end())
+        {
+            return it->second;
+        }
+        Node *train_node = allocate_train_node(
+            system, addr_hi, addr_lo, traction_service());
+        if (train_node)
+        {
+            trains_[key] = train_node;
+        }
+        return train_node;
+    }
+
     /// State flow handling incoming OpenLCB messages of MTI == Traction proxy
     /// Request.
     class ProxyRequestFlow : public IncomingMessageStateFlow
@@ -111,6 +140,7 @@ public:
             : IncomingMessageStateFlow(impl->iface())
             , impl_(impl)
             , response_(nullptr)
+            , reserved_(0)
         {
             iface()->dispatcher()->register_handler(
                 this, Defs::MTI_TRACTION_PROXY_COMMAND, 0xffff);
@@ -236,7 +266,7 @@ public:
             uint8_t addr_hi = payload()[2];
             uint8_t addr_lo = payload()[3];
             Node *train_node =
-                allocate_train_node(system, addr_hi, addr_lo, impl_->traction_service());
+                impl_->find_or_create_train(system, addr_hi, addr_lo);
 
             if (!train_node)
             {
@@ -295,6 +325,9 @@ public:
 
     TrainService *trainService_;
     Node *proxyNode_;
+    /// Train nodes created so far. The key is system << 16 | address. The
+    /// nodes are not owned (they come from allocate_train_node).
+    std::map<uint32_t, Node *> trains_;
     FixedEventProducer<TractionDefs::IS_PROXY_EVENT> proxyEventProducer_;
     ProxyRequestFlow handlerFlow_;
 };
@@ -311,4 +344,18 @@ TractionProxyService::~TractionProxyService()
     delete impl_;
 }
 
+void TractionProxyService::reserve_aliases(IfCan *if_can, unsigned count)
+{
+    HASSERT(if_can->alias_allocator());
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if_can->alias_allocator()->send(if_can->alias_allocator()->alloc());
+    }
+}
+
+size_t TractionProxyService::train_count()
+{
+    return impl_->trains_.size();
+}
+
 } // namespace openlcb
@@ -40,14 +40,32 @@
 namespace openlcb
 {
 
+class IfCan;
+
 /// Implements the unapproved Traction Proxy Protocol for dynamic allocation of
 /// train nodes.
+///
+/// Train nodes are created on the first allocate request for a given address
+/// and are reused for every later request for the same address, so any number
+/// of throttles can allocate the same locomotive.
 class TractionProxyService : public Service
 {
 public:
     TractionProxyService(TrainService *train_service, Node* proxy_node);
     ~TractionProxyService();
 
+    /// Asks the alias allocator to keep more aliases reserved. Each newly
+    /// created train node takes one reserved alias; when the pool runs dry,
+    /// every new train has to wait for a full alias reservation (200 msec).
+    /// Call this at startup with the number of trains expected to be
+    /// allocated in a burst (e.g. at the beginning of an operating session).
+    /// @param if_can is the interface of the train service.
+    /// @param count is the number of additional aliases to reserve.
+    void reserve_aliases(IfCan *if_can, unsigned count);
+
+    /// @return the number of train nodes created by this service.
+    size_t train_count();
+
 private:
     struct Impl;
     Impl *impl_;
@@ -39,6 +39,8 @@
 #include "openlcb/TractionDefs.hxx"
 #include "openlcb/TrainInterface.hxx"
 #include "executor/CallableFlow.hxx"
+#include "os/os.h"
+#include "utils/Atomic.hxx"
 
 namespace openlcb
 {
@@ -188,9 +190,35 @@ public:
         ERROR_UNASSIGNED = 0x4000000,
     };
 
+    /// Enables coalescing of the speed and function commands. While earlier
+    /// commands are still waiting to be sent on the bus, set_speed() and
+    /// set_fn() only update a pending value; the latest value wins for the
+    /// speed and for each function. The pending values are sent as soon as
+    /// the earlier commands are out. Functions above MAX_FN_QUERY are not
+    /// coalesced; they are sent right away.
+    ///
+    /// This is meant for knob-based throttles that produce many speed
+    /// updates per second, which would otherwise pile up behind each other
+    /// on a slow bus.
+    ///
+    /// @param max_latency_nsec upper bound on how long a command may stay
+    /// pending. After this time it is sent even if the earlier commands are
+    /// still queued. Zero disables coalescing (this is the default).
+    void set_coalescing(long long max_latency_nsec)
+    {
+        coalescer_.set_max_latency(max_latency_nsec);
+    }
+
     void set_speed(SpeedType speed) override
     {
-        send_traction_message(TractionDefs::speed_set_payload(speed));
+        if (coalescer_.enabled())
+        {
+            coalescer_.set_speed(speed);
+        }
+        else
+        {
+            send_traction_message(TractionDefs::speed_set_payload(speed));
+        }
         lastSetSpeed_ = speed;
     }
 
@@ -203,13 +231,19 @@ public:
 
     void set_emergencystop() override
     {
+        // A pending speed command would undo the emergency stop.
+        coalescer_.drop_speed();
         send_traction_message(TractionDefs::estop_set_payload());
         lastSetSpeed_.set_mph(0);
     }
 
     void set_fn(uint32_t address, uint16_t value) override
     {
-        send_traction_message(TractionDefs::fn_set_payload(address, value));
+        if (!coalescer_.enabled() || !coalescer_.set_fn(address, value))
+        {
+            send_traction_message(
+                TractionDefs::fn_set_payload(address, value));
+        }
         lastKnownFn_[address] = value;
     }
 
@@ -340,6 +374,7 @@ private:
 
     Action release_train()
     {
+        coalescer_.clear();
         send_traction_message(TractionDefs::release_controller_payload(node_));
         clear_assigned();
         clear_cache();
@@ -577,16 +612,281 @@ private:
 
     /** Allocates (synchronously) an outgoing openlcb buffer with traction
      * request MTI and the given payload and sends off the message to the bus
-     * for dst_. */
-    void send_traction_message(const Payload &payload)
+     * for dst_. @param done if not null, will be notified when the message
+     * is sent. */
+    void send_traction_message(
+        const Payload &payload, BarrierNotifiable *done = nullptr)
     {
         HASSERT(dst_ != 0);
         auto *b = iface()->addressed_message_write_flow()->alloc();
         b->data()->reset(Defs::MTI_TRACTION_CONTROL_COMMAND, node_->node_id(),
             NodeHandle(dst_), payload);
+        if (done)
+        {
+            b->set_done(done);
+        }
         iface()->addressed_message_write_flow()->send(b);
     }
 
+    /// Holds the speed and function commands that were not sent yet in
+    /// coalescing mode, and sends them when the previous batch is out.
+    ///
+    /// The set_...() calls may come from any thread; everything else runs on
+    /// the interface's executor.
+    class Coalescer : public StateFlowBase
+    {
+    public:
+        /// @param parent is the owning throttle.
+        Coalescer(TractionThrottle *parent)
+            : StateFlowBase(parent->service())
+            , parent_(parent)
+        {
+            start_flow(STATE(check));
+        }
+
+        /// @return true if coalescing is enabled.
+        bool enabled()
+        {
+            return maxLatencyNsec_ != 0;
+        }
+
+        /// @param nsec is the latency bound, 0 to disable coalescing.
+        void set_max_latency(long long nsec)
+        {
+            maxLatencyNsec_ = nsec;
+        }
+
+        /// Sets the pending speed. @param speed is the new speed.
+        void set_speed(SpeedType speed)
+        {
+            bool wake;
+            {
+                AtomicHolder h(&lock_);
+                hasSpeed_ = true;
+                speed_ = speed;
+                wake = mark_pending();
+            }
+            if (wake)
+            {
+                notify();
+            }
+        }
+
+        /// Sets a pending function value. @param address is the function
+        /// number. @param value is the new value. @return false if the
+        /// function number is too high to be coalesced; then nothing was
+        /// recorded and the caller has to send the command.
+        bool set_fn(uint32_t address, uint16_t value)
+        {
+            if (address >= NUM_FN)
+            {
+                return false;
+            }
+            bool wake;
+            {
+                AtomicHolder h(&lock_);
+                fnPending_ |= 1u << address;
+                fnValues_[address] = value;
+                wake = mark_pending();
+            }
+            if (wake)
+            {
+                notify();
+            }
+            return true;
+        }
+
+        /// Forgets the pending speed.
+        void drop_speed()
+        {
+            AtomicHolder h(&lock_);
+            hasSpeed_ = false;
+        }
+
+        /// Forgets all pending commands.
+        void clear()
+        {
+            AtomicHolder h(&lock_);
+            hasSpeed_ = false;
+            fnPending_ = 0;
+            hasPending_ = false;
+        }
+
+    private:
+        /// Number of functions that can be pending; the same as the number
+        /// of functions the throttle queries on load.
+        static constexpr unsigned NUM_FN = MAX_FN_QUERY + 1;
+        static_assert(NUM_FN <= 32, "fnPending_ is too small");
+
+        /// Records that there is something to send. Must be called with the
+        /// lock held. @return true if the flow is waiting; then the caller
+        /// has to notify() it after releasing the lock.
+        bool mark_pending()
+        {
+            if (!hasPending_)
+            {
+                hasPending_ = true;
+                pendingSinceNsec_ = os_get_time_monotonic();
+            }
+            if (waiting_)
+            {
+                waiting_ = false;
+                return true;
+            }
+            return false;
+        }
+
+        /// Decides whether the pending commands can be sent. @return next
+        /// action.
+        Action check()
+        {
+            long long sleep_nsec = 0;
+            {
+                AtomicHolder h(&lock_);
+                if (!hasPending_)
+                {
+                    waiting_ = true;
+                    return wait();
+                }
+                long long age = os_get_time_monotonic() - pendingSinceNsec_;
+                if (inFlight_ && age < maxLatencyNsec_)
+                {
+                    sleep_nsec = maxLatencyNsec_ - age;
+                }
+            }
+            if (sleep_nsec)
+            {
+                // sent() runs on this executor too, so it cannot slip in
+                // before the timer is started.
+                sleeping_ = true;
+                return sleep_and_call(&timer_, sleep_nsec, STATE(timer_done));
+            }
+            flush();
+            return again();
+        }
+
+        /// Called when the previous batch is out or the latency bound
+        /// expired. @return next action.
+        Action timer_done()
+        {
+            sleeping_ = false;
+            return call_immediately(STATE(check));
+        }
+
+        /// Sends all pending commands.
+        void flush()
+        {
+            bool has_speed;
+            SpeedType speed;
+            uint32_t fn_pending;
+            uint16_t fn_values[NUM_FN];
+            {
+                AtomicHolder h(&lock_);
+                has_speed = hasSpeed_;
+                speed = speed_;
+                hasSpeed_ = false;
+                fn_pending = fnPending_;
+                fnPending_ = 0;
+                memcpy(fn_values, fnValues_, sizeof(fn_values));
+                hasPending_ = false;
+            }
+            // If the previous batch is still out (the latency bound
+            // expired), this batch is sent without tracking.
+            BarrierNotifiable *done = nullptr;
+            if (!inFlight_)
+            {
+                inFlight_ = true;
+                done = barrier_.reset(&sent_);
+            }
+            if (has_speed)
+            {
+                parent_->send_traction_message(
+                    TractionDefs::speed_set_payload(speed),
+                    done ? done->new_child() : nullptr);
+            }
+            for (unsigned fn = 0; fn < NUM_FN; ++fn)
+            {
+                if (fn_pending & (1u << fn))
+                {
+                    parent_->send_traction_message(
+                        TractionDefs::fn_set_payload(fn, fn_values[fn]),
+                        done ? done->new_child() : nullptr);
+                }
+            }
+            if (done)
+            {
+                done->maybe_done();
+            }
+        }
+
+        /// Called on the executor when the tracked batch was sent.
+        void sent()
+        {
+            inFlight_ = false;
+            if (sleeping_)
+            {
+                timer_.ensure_triggered();
+            }
+        }
+
+        /// Owning throttle.
+        TractionThrottle *parent_;
+        /// Protects the pending values and the flags set from the caller's
+        /// thread.
+        Atomic lock_;
+        /// Latency bound, 0 if coalescing is disabled.
+        long long maxLatencyNsec_{0};
+        /// When the oldest pending command was set.
+        long long pendingSinceNsec_{0};
+        /// Pending speed command.
+        SpeedType speed_;
+        /// Bit N is set if function N is pending.
+        uint32_t fnPending_{0};
+        /// Values of the pending functions, valid where fnPending_ is set.
+        uint16_t fnValues_[NUM_FN];
+        /// True if there is any pending command.
+        bool hasPending_{false};
+        /// True if speed_ is pending.
+        bool hasSpeed_{false};
+        /// True if the flow is waiting for a new command.
+        bool waiting_{false};
+        /// True if the flow is waiting for the previous batch to be sent.
+        /// Executor only.
+        bool sleeping_{false};
+        /// True if a tracked batch is not sent yet. Executor only.
+        bool inFlight_{false};
+        /// Timer for the latency bound.
+        StateFlowTimer timer_{this};
+        /// Notified when the tracked batch is sent.
+        BarrierNotifiable barrier_;
+        /// Calls sent() on the executor. The batch's done notification comes
+        /// from wherever the last message buffer is released, which may be
+        /// another thread.
+        class SentNotifiable : public Executable
+        {
+        public:
+            /// @param parent is the owning coalescer.
+            SentNotifiable(Coalescer *parent)
+                : parent_(parent)
+            {
+            }
+
+            void notify() override
+            {
+                parent_->service()->executor()->add(this);
+            }
+
+            void run() override
+            {
+                parent_->sent();
+            }
+
+        private:
+            /// Owning coalescer.
+            Coalescer *parent_;
+        } sent_{this};
+    };
+
     void set_assigned()
     {
         iface()->dispatcher()->register_handler(&speedReplyHandler_, Defs::MTI_TRACTION_CONTROL_REPLY, Defs::MTI_EXACT);
@@ -637,6 +937,8 @@ private:
     SpeedType lastSetSpeed_;
     /// Cache: all known function values.
     std::map<uint32_t, uint16_t> lastKnownFn_;
+    /// Pending commands in coalescing mode.
+    Coalescer coalescer_{this};
 };
 
 } // namespace openlcb
@@ -52,9 +52,6 @@ TrainNode::TrainNode(TrainService *service, TrainImpl *train)
 
 TrainNode::~TrainNode()
 {
-    while (!consistSlaves_.empty()) {
-        delete consistSlaves_.pop_front();
-    }
 }
 
 TrainNodeForProxy::TrainNodeForProxy(TrainService *service, TrainImpl *train)
@@ -177,8 +174,7 @@ struct TrainService::Impl
                 {
                     SpeedType sp = fp16_to_speed(payload() + 1);
                     train_node()->train()->set_speed(sp);
-                    nextConsistIndex_ = 0;
-                    return call_immediately(STATE(maybe_forward_consist));
+                    return forward_consist();
                 }
                 case TractionDefs::REQ_SET_FN:
                 {
@@ -191,8 +187,7 @@ struct TrainService::Impl
                     value <<= 8;
                     value |= payload()[5];
                     train_node()->train()->set_fn(address, value);
-                    nextConsistIndex_ = 0;
-                    return call_immediately(STATE(maybe_forward_consist));
+                    return forward_consist();
                 }
                 case TractionDefs::REQ_EMERGENCY_STOP:
                 {
@@ -408,88 +403,75 @@ struct TrainService::Impl
             }
         }
 
-        Action maybe_forward_consist()
+        /// @return true if the command should be forwarded to a consist
+        /// member. @param flags are the consist flags of the member.
+        bool should_forward(uint8_t flags)
         {
-            auto* train_node = this->train_node();
-            unsigned count = train_node->query_consist_length();
-            if (count <= nextConsistIndex_)
-                return release_and_exit();
-            uint8_t flags = 0;
-            NodeID dst = train_node->query_consist(nextConsistIndex_, &flags);
-            if (iface()->matching_node(nmsg()->src, NodeHandle(dst)))
-            {
-                ++nextConsistIndex_;
-                return again();
-            }
-            uint8_t cmd = payload()[0];
-            bool flip_speed = false;
-            if (cmd == TractionDefs::REQ_SET_SPEED) {
-                if (flags & TractionDefs::CNSTFLAGS_REVERSE) {
-                    flip_speed = true;
-                }
-            } else if (cmd == TractionDefs::REQ_SET_FN) {
-                uint32_t address = payload()[1];
-                address <<= 8;
-                address |= payload()[2];
-                address <<= 8;
-                address |= payload()[3];
-                if (address == 0) {
-                    if ((flags & TractionDefs::CNSTFLAGS_LINKF0) == 0) {
-                        // skip
-                        ++nextConsistIndex_;
-                        return again();
-                    }
-                } else {
-                    if ((flags & TractionDefs::CNSTFLAGS_LINKFN) == 0) {
-                        // skip
-                        ++nextConsistIndex_;
-                        return again();
-                    }
-                }
-            }
-            if (count == nextConsistIndex_ + 1u)
-            {
-                // last node: we can transfer the message.
-                auto *b = transfer_message();
-                b->data()->src = NodeHandle(train_node->node_id());
-                b->data()->dst = NodeHandle(dst);
-                b->data()->dstNode = nullptr;
-                if (flip_speed) {
-                    b->data()->payload[1] ^= 0x80;
-                }
-                iface()->addressed_message_write_flow()->send(b);
-                return exit();
-            }
-            else
+            if (payload()[0] != TractionDefs::REQ_SET_FN)
             {
-                return allocate_and_call(
-                    iface()->addressed_message_write_flow(),
-                    STATE(forward_consist));
+                return true;
             }
+            bool is_f0 = !payload()[1] && !payload()[2] && !payload()[3];
+            return flags & (is_f0 ? TractionDefs::CNSTFLAGS_LINKF0
+                                  : TractionDefs::CNSTFLAGS_LINKFN);
         }
 
+        /// Sends a copy of the incoming speed or function command to every
+        /// consist member in one pass. The members get separate buffers; the
+        /// last one receives the incoming message itself.
         Action forward_consist()
         {
-            auto *b =
-                get_allocation_result(iface()->addressed_message_write_flow());
-            uint8_t flags;
-            NodeID dst = train_node()->query_consist(nextConsistIndex_, &flags);
-            if (!dst)
+            auto *train_node = this->train_node();
+            const auto &members = train_node->consist_members();
+            auto *flow = iface()->addressed_message_write_flow();
+            bool is_speed = payload()[0] == TractionDefs::REQ_SET_SPEED;
+            // Finds the last member that gets the command; this one can take
+            // over the incoming buffer.
+            int last = -1;
+            for (int i = 0; i < (int)members.size(); ++i)
+            {
+                if (should_forward(members[i].get_flags()) &&
+                    !iface()->matching_node(
+                        nmsg()->src, NodeHandle(members[i].get_slave())))
+                {
+                    last = i;
+                    break;
+                }
+            }
+            if (last < 0)
             {
-                // Strange. The consist destination should exist and never be
-                // zero once we got here.
-                b->unref();
                 return release_and_exit();
             }
-            b->data()->reset(message()->data()->mti, train_node()->node_id(),
-                             NodeHandle(dst), message()->data()->payload);
-            if ((payload()[0] == TractionDefs::REQ_SET_SPEED) &&
-                (flags & TractionDefs::CNSTFLAGS_REVERSE)) {
+            NodeID src = train_node->node_id();
+            for (int i = members.size() - 1; i > last; --i)
+            {
+                const ConsistEntry &e = members[i];
+                if (!should_forward(e.get_flags()) ||
+                    iface()->matching_node(
+                        nmsg()->src, NodeHandle(e.get_slave())))
+                {
+                    continue;
+                }
+                auto *b = flow->alloc();
+                b->data()->reset(message()->data()->mti, src,
+                    NodeHandle(e.get_slave()), message()->data()->payload);
+                if (is_speed && (e.get_flags() & TractionDefs::CNSTFLAGS_REVERSE))
+                {
+                    b->data()->payload[1] ^= 0x80;
+                }
+                flow->send(b);
+            }
+            const ConsistEntry &e = members[last];
+            auto *b = transfer_message();
+            b->data()->src = NodeHandle(src);
+            b->data()->dst = NodeHandle(e.get_slave());
+            b->data()->dstNode = nullptr;
+            if (is_speed && (e.get_flags() & TractionDefs::CNSTFLAGS_REVERSE))
+            {
                 b->data()->payload[1] ^= 0x80;
             }
-            iface()->addressed_message_write_flow()->send(b);
-            ++nextConsistIndex_;
-            return call_immediately(STATE(maybe_forward_consist));
+            flow->send(b);
+            return exit();
         }
 
         Action handle_traction_mgmt()
@@ -589,7 +571,6 @@ struct TrainService::Impl
     private:
         /// error code for reject_permanent().
         unsigned errorCode_ : 16;
-        unsigned nextConsistIndex_ : 8;
         /// 1 if the voluntary lock protocol has set this train to be reserved.
         unsigned reserved_ : 1;
         TrainService *trainService_;
@@ -36,6 +36,7 @@
 #define _NMRANET_TRACTIONTRAIN_HXX_
 
 #include <set>
+#include <vector>
 
 #include "executor/Service.hxx"
 #include "openlcb/Node.hxx"
@@ -48,9 +49,8 @@ namespace openlcb
 
 class TrainService;
 
-/// Linked list entry for all registered consist clients for a given train
-/// node.
-struct ConsistEntry : public QMember {
+/// Entry for all registered consist clients for a given train node.
+struct ConsistEntry {
     ConsistEntry(NodeID s, uint8_t flags) : payload((s << 8) | flags) {}
     NodeID get_slave() const {
         return payload >> 8;
@@ -124,21 +124,27 @@ public:
     // before any consist change requests would reach the front of the queue
     // for the traction flow.
 
+    // The consist members are stored in an array, newest member last. Index
+    // zero of the query API is the newest member, the same order as the
+    // consist members are reported and forwarded to. Adding and removing
+    // members is linear in the consist size; indexing and forwarding the
+    // traction commands are constant time per member.
+
     /** Adds a node ID to the consist targets. @return false if the node was
      * already in the target list, true if it was newly added. */
     bool add_consist(NodeID tgt, uint8_t flags)
     {
         if (!tgt) return false;
         if (tgt == node_id()) return false;
-        for (auto it = consistSlaves_.begin(); it != consistSlaves_.end(); ++it)
+        for (auto &e : consistSlaves_)
         {
-            if (it->get_slave() == tgt)
+            if (e.get_slave() == tgt)
             {
-                it->set_flags(flags);
+                e.set_flags(flags);
                 return true;
             }
         }
-        consistSlaves_.push_front(new ConsistEntry(tgt, flags));
+        consistSlaves_.emplace_back(tgt, flags);
         return true;
     }
 
@@ -150,9 +156,7 @@ public:
         {
             if (it->get_slave() == tgt)
             {
-                auto* p = it.operator->();
                 consistSlaves_.erase(it);
-                delete p;
                 return true;
             }
         }
@@ -163,28 +167,26 @@ public:
      * fewer than id consist targets. id is zero-based. */
     NodeID query_consist(int id, uint8_t* flags)
     {
-        int k = 0;
-        for (auto it = consistSlaves_.begin();
-             it != consistSlaves_.end(); ++it, ++k)
+        if (id < 0 || (unsigned)id >= consistSlaves_.size())
         {
-            if (k == id)
-            {
-                if (flags) *flags = it->get_flags();
-                return it->get_slave();
-            }
+            return 0;
         }
-        return 0;
+        const ConsistEntry &e = consistSlaves_[consistSlaves_.size() - 1 - id];
+        if (flags) *flags = e.get_flags();
+        return e.get_slave();
     }
 
     /** Returns the number of slaves in this consist. */
     int query_consist_length()
     {
-        int ret = 0;
-        for (auto it = consistSlaves_.begin(); it != consistSlaves_.end();
-             ++it, ++ret)
-        {
-        }
-        return ret;
+        return consistSlaves_.size();
+    }
+
+    /** @return all consist members, oldest first (i.e. the reverse of the
+     * query_consist() order). Used for forwarding the traction commands. */
+    const std::vector<ConsistEntry> &consist_members()
+    {
+        return consistSlaves_;
     }
 
 protected:
@@ -196,7 +198,8 @@ private:
 
     /// Controller node that is assigned to run this train. 0 if none.
     NodeHandle controllerNodeId_;
-    TypedQueue<ConsistEntry> consistSlaves_;
+    /// Consist members, oldest first.
+    std::vector<ConsistEntry> consistSlaves_;
 };
 
 
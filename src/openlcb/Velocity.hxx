@@ -37,6 +37,7 @@
 #include <cmath>
 #include <cstdint>
 
+#include "utils/Float16.hxx"
 #include "utils/macros.h"
 
 extern "C" {
@@ -123,7 +124,7 @@ public:
      * @param value starting value for Velocity as IEEE half precision float.
      */
     Velocity(float16_t value)
-        : velocity(halfp2singles(&velocity, &value, 1))
+        : velocity(float16_to_float(value))
     {
     }
 
@@ -283,9 +284,7 @@ public:
      */
     float16_t get_wire() const
     {
-        float16_t result;
-        singles2halfp(&result, &velocity, 1);
-        return result;
+        return float_to_float16(velocity);
     }
     
     /** Set the value based on the wire version of velocity.
@@ -293,7 +292,7 @@ public:
      */
     void set_wire(float16_t value)
     {
-        halfp2singles(&velocity, &value, 1);
+        velocity = float16_to_float(value);
     }
 
     /** Overloaded addition operator. */
@@ -0,0 +1,208 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file BinaryCanStream.cxx
+ *
+ * Compact binary framing of CAN frames on a byte stream.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "utils/BinaryCanStream.hxx"
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(__linux__) || defined(__MACH__)
+#include <sys/select.h>
+#include <unistd.h>
+#endif
+
+#include "os/os.h"
+
+/// Header bit for extended frames.
+static const uint8_t HDR_EFF = 0x80;
+/// Header bit for remote frames.
+static const uint8_t HDR_RTR = 0x40;
+/// Header bit for error frames.
+static const uint8_t HDR_ERR = 0x20;
+/// Reserved header bit.
+static const uint8_t HDR_RESERVED = 0x10;
+/// Header bits holding the data length code.
+static const uint8_t HDR_DLC_MASK = 0x0F;
+
+unsigned binary_can_format_generate(const struct can_frame *frame, uint8_t *buf)
+{
+    uint8_t dlc = frame->can_dlc > 8 ? 8 : frame->can_dlc;
+    uint8_t *p = buf;
+    uint8_t hdr = dlc;
+    if (IS_CAN_FRAME_RTR(*frame))
+    {
+        hdr |= HDR_RTR;
+    }
+    if (IS_CAN_FRAME_ERR(*frame))
+    {
+        hdr |= HDR_ERR;
+    }
+    if (IS_CAN_FRAME_EFF(*frame))
+    {
+        uint32_t id = GET_CAN_FRAME_ID_EFF(*frame);
+        *p++ = hdr | HDR_EFF;
+        *p++ = id >> 24;
+        *p++ = id >> 16;
+        *p++ = id >> 8;
+        *p++ = id;
+    }
+    else
+    {
+        uint32_t id = GET_CAN_FRAME_ID(*frame);
+        *p++ = hdr;
+        *p++ = id >> 8;
+        *p++ = id;
+    }
+    if (!IS_CAN_FRAME_RTR(*frame))
+    {
+        memcpy(p, frame->data, dlc);
+        p += dlc;
+    }
+    return p - buf;
+}
+
+bool BinaryCanStreamParser::consume_byte(uint8_t c)
+{
+    if (!length_)
+    {
+        if ((c & HDR_RESERVED) || (c & HDR_DLC_MASK) > 8)
+        {
+            // Not a valid header. Drop byte to the floor.
+            return false;
+        }
+        length_ = 1 + ((c & HDR_EFF) ? 4 : 2);
+        if (!(c & HDR_RTR))
+        {
+            length_ += c & HDR_DLC_MASK;
+        }
+        offset_ = 0;
+    }
+    buf_[offset_++] = c;
+    if (offset_ < length_)
+    {
+        return false;
+    }
+    length_ = 0;
+    return true;
+}
+
+void BinaryCanStreamParser::parse_frame_to_output(
+    struct can_frame *output_frame)
+{
+    uint8_t hdr = buf_[0];
+    const uint8_t *p = buf_ + 1;
+    memset(output_frame, 0, sizeof(*output_frame));
+    if (hdr & HDR_EFF)
+    {
+        SET_CAN_FRAME_EFF(*output_frame);
+        SET_CAN_FRAME_ID_EFF(*output_frame,
+            ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                ((uint32_t)p[2] << 8) | p[3]);
+        p += 4;
+    }
+    else
+    {
+        SET_CAN_FRAME_ID(*output_frame, ((uint32_t)p[0] << 8) | p[1]);
+        p += 2;
+    }
+    if (hdr & HDR_RTR)
+    {
+        SET_CAN_FRAME_RTR(*output_frame);
+    }
+    if (hdr & HDR_ERR)
+    {
+        SET_CAN_FRAME_ERR(*output_frame);
+    }
+    output_frame->can_dlc = hdr & HDR_DLC_MASK;
+    if (!(hdr & HDR_RTR))
+    {
+        memcpy(output_frame->data, p, output_frame->can_dlc);
+    }
+}
+
+#if defined(__linux__) || defined(__MACH__)
+bool binary_can_client_handshake(int fd, int timeout_msec)
+{
+    const ssize_t len = sizeof(BINARY_CAN_HELLO);
+    if (::write(fd, BINARY_CAN_HELLO, len) != len)
+    {
+        return false;
+    }
+    long long deadline =
+        os_get_time_monotonic() + MSEC_TO_NSEC((long long)timeout_msec);
+    ssize_t matched = 0;
+    while (matched < len)
+    {
+        long long left = deadline - os_get_time_monotonic();
+        if (left <= 0)
+        {
+            return false;
+        }
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+        struct timeval tv;
+        tv.tv_sec = left / 1000000000;
+        tv.tv_usec = (left % 1000000000) / 1000;
+        int ret = ::select(fd + 1, &fds, nullptr, nullptr, &tv);
+        if (ret < 0 && errno != EINTR)
+        {
+            return false;
+        }
+        if (ret <= 0)
+        {
+            continue;
+        }
+        // Reads byte by byte, because the binary data starts right after the
+        // answer, and it must stay in the socket for the caller.
+        char c;
+        if (::read(fd, &c, 1) != 1)
+        {
+            return false;
+        }
+        if (c == BINARY_CAN_HELLO[matched])
+        {
+            ++matched;
+        }
+        else
+        {
+            // GridConnect data that was in flight before the answer. The
+            // hello starts with a NUL, which does not occur in GridConnect,
+            // so we never need to back up.
+            matched = (c == BINARY_CAN_HELLO[0]) ? 1 : 0;
+        }
+    }
+    return true;
+}
+#endif
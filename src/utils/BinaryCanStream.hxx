@@ -0,0 +1,119 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file BinaryCanStream.hxx
+ *
+ * Compact binary framing of CAN frames on a byte stream.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _UTILS_BINARYCANSTREAM_HXX_
+#define _UTILS_BINARYCANSTREAM_HXX_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "can_frame.h"
+
+/** Binary CAN stream format. Every frame is encoded as a header byte,
+ * followed by the identifier and the payload:
+ *
+ *  - header bit 7: extended (29-bit) frame; bit 6: remote frame; bit 5:
+ *    error frame; bit 4: reserved, must be zero; bits 3..0: data length code
+ *    (0..8).
+ *  - identifier, big-endian: 4 bytes for extended frames, 2 bytes for
+ *    standard frames.
+ *  - payload: as many bytes as the data length code says; none for remote
+ *    frames.
+ *
+ * An extended frame with 8 data bytes takes 13 bytes, compared to 28 bytes
+ * (plus newline) in GridConnect.
+ *
+ * A GridConnect connection is switched to this format by the client sending
+ * BINARY_CAN_HELLO as the very first bytes on the connection. The server
+ * answers with the same bytes, and from then on both directions are binary.
+ * The client must not send frames until it has seen the answer. Any
+ * GridConnect data before the answer should be discarded. Since GridConnect
+ * never contains a NUL byte, the hello cannot be mistaken for GridConnect
+ * traffic. */
+static const char BINARY_CAN_HELLO[] = {0, 'B', 'I', 'N', 'C', 'A', 'N', '1'};
+
+/// Maximum length of one encoded frame.
+static const unsigned BINARY_CAN_MAX_FRAME_LENGTH = 13;
+
+/** Encodes a CAN frame in the binary stream format.
+ * @param frame is the frame to encode.
+ * @param buf is the output buffer, must have at least
+ * BINARY_CAN_MAX_FRAME_LENGTH bytes.
+ * @return the number of bytes written. */
+unsigned binary_can_format_generate(const struct can_frame *frame, uint8_t *buf);
+
+/**
+   Parses a byte stream in the binary CAN format and finds the frames in
+   it. Bytes can be fed in arbitrary chunks.
+
+   This class is not thread-safe, but thread-compatible.
+ */
+class BinaryCanStreamParser
+{
+public:
+    BinaryCanStreamParser()
+        : offset_(0)
+        , length_(0)
+    {
+    }
+
+    /** Adds the next byte from the source stream. @return true if the
+     * internal buffer contains a complete frame. @param c next byte. */
+    bool consume_byte(uint8_t c);
+
+    /** Parses the completed frame in the internal buffer. Should be called if
+     * and only if the previous consume_byte call returned true.
+     * @param output_frame will be filled with the frame. */
+    void parse_frame_to_output(struct can_frame *output_frame);
+
+private:
+    /// Collects the bytes of the current frame.
+    uint8_t buf_[BINARY_CAN_MAX_FRAME_LENGTH];
+    /// Number of bytes in buf_.
+    uint8_t offset_;
+    /// Total length of the current frame; 0 if we are waiting for a header.
+    uint8_t length_;
+};
+
+/** Switches a freshly connected GridConnect client socket to the binary CAN
+ * stream format. Sends the hello and reads (and discards) incoming data until
+ * the server's answer arrives. Blocking.
+ *
+ * @param fd is the connected socket.
+ * @param timeout_msec is how long to wait for the answer.
+ * @return true if the connection is now binary; false if the server did not
+ * answer in time or the connection failed. */
+bool binary_can_client_handshake(int fd, int timeout_msec);
+
+#endif // _UTILS_BINARYCANSTREAM_HXX_
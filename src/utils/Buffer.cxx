@@ -33,6 +33,9 @@
 
 #include "utils/Buffer.hxx"
 
+#include "utils/Metrics.hxx"
+#include "utils/StringPrintf.hxx"
+
 DynamicPool *mainBufferPool = nullptr;
 
 Pool* init_main_buffer_pool()
@@ -40,10 +43,40 @@ Pool* init_main_buffer_pool()
     if (!mainBufferPool)
     {
         mainBufferPool = new DynamicPool(Bucket::init(16, 32, 48, 72, 0));
+        mainBufferPool->register_metrics("pool.main");
     }
     return mainBufferPool;
 }
 
+void DynamicPool::register_metrics(const char *prefix)
+{
+    if (!METRICS_ENABLED)
+    {
+        return;
+    }
+    MetricsRegistry *r = MetricsRegistry::instance();
+    std::string p(prefix);
+    r->add_gauge(this, p + ".total_bytes", [this]() { return totalSize; });
+    r->add_gauge(this, p + ".free_items", [this]() { return free_items(); });
+    for (Bucket *current = buckets; current->size() != 0; ++current)
+    {
+        std::string b = StringPrintf("%s.bucket%u", prefix,
+            (unsigned)current->size());
+        r->add_gauge(this, b + ".allocated",
+            [current]() { return current->allocCount_; });
+        r->add_gauge(this, b + ".free",
+            [current]() { return current->pending(); });
+    }
+}
+
+void DynamicPool::unregister_metrics()
+{
+    if (METRICS_ENABLED)
+    {
+        MetricsRegistry::instance()->remove(this);
+    }
+}
+
 /** Expand the buffer by allocating a buffer double the size, copying the
  * contents to the new buffer, and freeing the old buffer.  The "this" pointer
  * of the caller will be used to free the buffer.
@@ -59,6 +92,7 @@ BufferBase *BufferBase::expand()
     memcpy(expanded_buffer + 1, this + 1, size_ - sizeof(BufferBase));
     expanded_buffer->count_ = count_;
     expanded_buffer->done_ = done_;
+    expanded_buffer->set_timestamp(timestamp());
     
     /* free the old buffer */
     pool_->free(this);
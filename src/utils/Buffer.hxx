@@ -37,6 +37,11 @@
 // Enable this to collect the pointer of all buffers live.
 //#define DEBUG_BUFFER_MEMORY
 
+// Define BUFFER_TIMESTAMPS in the build to carry a timestamp in every buffer
+// (see BufferLatency). Off by default, because it adds four bytes to every
+// buffer header on 32-bit targets.
+//#define BUFFER_TIMESTAMPS
+
 #include <memory>
 #include <new>
 #include <cstdint>
@@ -58,6 +63,14 @@ class Pool;
 template <class T> class Buffer;
 class BufferBase;
 
+#ifdef BUFFER_TIMESTAMPS
+/// True if the buffers carry a timestamp.
+static constexpr bool BUFFER_TIMESTAMPS_ENABLED = true;
+#else
+/// True if the buffers carry a timestamp.
+static constexpr bool BUFFER_TIMESTAMPS_ENABLED = false;
+#endif
+
 namespace openlcb
 {
 class AsyncIfTest;
@@ -118,6 +131,30 @@ public:
         return size_;
     }
 
+    /// @return the time the data in this buffer entered the stack, in
+    /// BufferLatency::now() units, or 0 if the buffer is not stamped. Always
+    /// 0 unless the build defines BUFFER_TIMESTAMPS.
+    uint32_t timestamp()
+    {
+#ifdef BUFFER_TIMESTAMPS
+        return timestamp_;
+#else
+        return 0;
+#endif
+    }
+
+    /// Sets the timestamp of the buffer. Used for carrying the timestamp
+    /// over to a buffer derived from this one. @param ts is the new
+    /// timestamp, as returned by timestamp().
+    void set_timestamp(uint32_t ts)
+    {
+#ifdef BUFFER_TIMESTAMPS
+        timestamp_ = ts;
+#else
+        (void)ts;
+#endif
+    }
+
     /** Expand the buffer by allocating a buffer double the size, copying the
      * contents to the new buffer, and freeing the old buffer.  The "this"
      * pointer
@@ -140,6 +177,11 @@ protected:
 
     /** number of references in use */
     uint16_t count_;
+#ifdef BUFFER_TIMESTAMPS
+    /// Time the data entered the stack, see timestamp(). Fits into the
+    /// padding before pool_ on 64-bit hosts only.
+    uint32_t timestamp_;
+#endif
     /** Reference to the pool from whence this buffer came */
     Pool *pool_;
 
@@ -155,6 +197,9 @@ protected:
         : QMember()
         , size_(size)
         , count_(1)
+#ifdef BUFFER_TIMESTAMPS
+        , timestamp_(0)
+#endif
         , pool_(pool)
         , done_(NULL)
     {
@@ -475,9 +520,15 @@ public:
     /** default destructor */
     ~DynamicPool()
     {
+        unregister_metrics();
         Bucket::destroy(buckets);
     }
 
+    /** Exports the memory usage of this pool into the MetricsRegistry.
+     * @param prefix is prepended to the metric names, e.g. "pool.main".
+     */
+    void register_metrics(const char *prefix);
+
     /** Number of free items in the pool.
      * @return number of free items in the pool
      */
@@ -512,6 +563,9 @@ private:
      */
     BufferBase *alloc_untyped(size_t size, Executable *flow) override;
 
+    /** Removes the metrics of this pool from the MetricsRegistry. */
+    void unregister_metrics();
+
     /** Allocates a large memory block directly from the heap. @param size is
      * the block size to allocate from the heap. @return the allocated
      * block. */
@@ -0,0 +1,113 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file BufferLatency.cxx
+ *
+ * Optional timestamps carried in buffers through the stack, and per-stage
+ * latency histograms computed from them.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "utils/BufferLatency.hxx"
+
+#include <string>
+
+#include "utils/macros.h"
+
+bool BufferLatency::enabled_ = false;
+LatencyStage *LatencyStage::head_ = nullptr;
+
+/// Upper bounds of the latency buckets in microseconds.
+static const uint32_t LATENCY_BOUNDS_USEC[] = {10, 20, 50, 100, 200, 500,
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000};
+
+/// @return the lock protecting the list of stages and the enabled flag
+/// transitions. Stages are static objects of other modules, so this must not
+/// depend on the static initialization order.
+static Atomic *stage_list_lock()
+{
+    static Atomic *lock = new Atomic();
+    return lock;
+}
+
+void BufferLatency::set_enabled(bool enabled)
+{
+    AtomicHolder h(stage_list_lock());
+    if (enabled == enabled_)
+    {
+        return;
+    }
+    enabled_ = enabled;
+    for (LatencyStage *s = LatencyStage::head_; s; s = s->next_)
+    {
+        if (enabled)
+        {
+            s->register_metric();
+        }
+        else if (METRICS_ENABLED)
+        {
+            MetricsRegistry::instance()->remove(s);
+        }
+    }
+}
+
+LatencyStage::LatencyStage(const char *name)
+    : name_(name)
+    , hist_(LATENCY_BOUNDS_USEC, ARRAYSIZE(LATENCY_BOUNDS_USEC))
+{
+    AtomicHolder h(stage_list_lock());
+    next_ = head_;
+    head_ = this;
+    if (BufferLatency::enabled())
+    {
+        register_metric();
+    }
+}
+
+LatencyStage::~LatencyStage()
+{
+    AtomicHolder h(stage_list_lock());
+    for (LatencyStage **p = &head_; *p; p = &(*p)->next_)
+    {
+        if (*p == this)
+        {
+            *p = next_;
+            break;
+        }
+    }
+    if (METRICS_ENABLED && BufferLatency::enabled())
+    {
+        MetricsRegistry::instance()->remove(this);
+    }
+}
+
+void LatencyStage::register_metric()
+{
+    MetricsRegistry::instance()->add(
+        this, std::string("latency.") + name_, &hist_);
+}
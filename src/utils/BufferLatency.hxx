@@ -0,0 +1,152 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file BufferLatency.hxx
+ *
+ * Optional timestamps carried in buffers through the stack, and per-stage
+ * latency histograms computed from them.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _UTILS_BUFFERLATENCY_HXX_
+#define _UTILS_BUFFERLATENCY_HXX_
+
+#include <stdint.h>
+
+#include "os/os.h"
+#include "utils/Atomic.hxx"
+#include "utils/Buffer.hxx"
+#include "utils/Metrics.hxx"
+
+/// Switch and clock of the buffer timestamps.
+///
+/// While enabled, buffers are stamped where data enters the stack: frames
+/// read by HubDeviceSelect and messages handed to an interface write flow.
+/// Outgoing messages are stamped in the write flow's send(), so the time a
+/// producer spends before sending is not covered.
+/// The stamp travels along with the data (GridConnect parsing, IfCan frame
+/// parsing, dispatcher clones, event handler calls), and each LatencyStage
+/// records the time elapsed since the stamp when the data reaches it.
+/// Disabled by default; then the only cost is checking the flag. Builds
+/// without BUFFER_TIMESTAMPS (see Buffer.hxx) have no place for the stamp, so
+/// stamping and recording compile to nothing there.
+class BufferLatency
+{
+public:
+    /// Turns stamping on or off. Enabling also registers the histograms of
+    /// all stages in the MetricsRegistry as "latency.<stage>"; disabling
+    /// removes them. @param enabled is the new state.
+    static void set_enabled(bool enabled);
+
+    /// @return true if buffers are being stamped.
+    static bool enabled()
+    {
+        return enabled_;
+    }
+
+    /// @return the current time in microseconds, truncated to 32 bits. Never
+    /// returns 0, which marks buffers without a timestamp.
+    static uint32_t now()
+    {
+        uint32_t t = os_get_time_monotonic() / 1000;
+        return t ? t : 1;
+    }
+
+    /// Stamps a buffer with the current time, unless stamping is disabled or
+    /// the buffer already has a timestamp. @param b is the buffer.
+    static void stamp(BufferBase *b)
+    {
+        if (BUFFER_TIMESTAMPS_ENABLED && METRICS_ENABLED && enabled_ &&
+            !b->timestamp())
+        {
+            b->set_timestamp(now());
+        }
+    }
+
+private:
+    /// True if stamping is on.
+    static bool enabled_;
+};
+
+/// Latency histogram of one processing stage, in microseconds since the
+/// buffer was stamped. Stages are meant to be static objects of the module
+/// they instrument.
+class LatencyStage : private Atomic
+{
+public:
+    /// @param name is the stage name; the histogram is registered as
+    /// "latency.<name>". Must stay alive as long as *this.
+    LatencyStage(const char *name);
+
+    ~LatencyStage();
+
+    /// Records the latency of a buffer that reached this stage. Buffers
+    /// without a timestamp are ignored. @param b is the buffer.
+    void record(BufferBase *b)
+    {
+        record(b->timestamp());
+    }
+
+    /// Records the latency of data stamped at a given time. @param timestamp
+    /// is a value returned by BufferBase::timestamp(); 0 is ignored.
+    void record(uint32_t timestamp)
+    {
+        if (!BUFFER_TIMESTAMPS_ENABLED || !METRICS_ENABLED || !timestamp)
+        {
+            return;
+        }
+        uint32_t latency = BufferLatency::now() - timestamp;
+        AtomicHolder h(this);
+        hist_.add(latency);
+    }
+
+    /// @return the latency histogram.
+    HistogramMetric *histogram()
+    {
+        return &hist_;
+    }
+
+private:
+    friend class BufferLatency;
+
+    /// Adds the histogram to the MetricsRegistry.
+    void register_metric();
+
+    /// Stage name.
+    const char *name_;
+    /// Latency distribution in usec.
+    HistogramMetric hist_;
+    /// Next entry in the list of all stages.
+    LatencyStage *next_;
+    /// Head of the list of all stages.
+    static LatencyStage *head_;
+
+    DISALLOW_COPY_AND_ASSIGN(LatencyStage);
+};
+
+#endif // _UTILS_BUFFERLATENCY_HXX_
@@ -36,6 +36,8 @@
 #ifndef _UTILS_CONFIGUPDATELISTENER_HXX_
 #define _UTILS_CONFIGUPDATELISTENER_HXX_
 
+#include <limits.h>
+
 #include "utils/QMember.hxx"
 #include "executor/Notifiable.hxx"
 
@@ -98,6 +100,23 @@ public:
     /// @param fd is the file descriptor for the EEPROM file. The current
     /// offset in this file is unspecified, callees must do lseek.
     virtual void factory_reset(int fd) = 0;
+
+    /// Reports which bytes of the EEPROM file this component reads in
+    /// apply_configuration. When the config update service knows which bytes
+    /// were modified, components whose range does not overlap any modified
+    /// bytes are not called on a refresh. The initial load calls every
+    /// component regardless.
+    ///
+    /// The default implementation claims the entire file, thus the component
+    /// is called on every update.
+    ///
+    /// @param begin will be set to the offset of the first byte read.
+    /// @param end will be set to the offset one past the last byte read.
+    virtual void get_config_range(unsigned *begin, unsigned *end)
+    {
+        *begin = 0;
+        *end = UINT_MAX;
+    }
 };
 
 
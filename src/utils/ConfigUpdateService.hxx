@@ -60,7 +60,31 @@ public:
     virtual void unregister_update_listener(ConfigUpdateListener *listener) = 0;
 
     /// Executes an update in response to the configuration having changed.
+    /// All listeners are called, and any range recorded by \ref mark_dirty is
+    /// discarded.
     virtual void trigger_update() = 0;
+
+    /// Executes an update after the configuration was modified by writes
+    /// that were all reported to \ref mark_dirty. Only those listeners are
+    /// called whose config range overlaps with the modified bytes. If no
+    /// modifications were recorded, all listeners are called.
+    ///
+    /// The default implementation calls \ref trigger_update.
+    virtual void trigger_dirty_update()
+    {
+        trigger_update();
+    }
+
+    /// Records that a range of the configuration file was modified. The
+    /// range is used by the next \ref trigger_dirty_update.
+    ///
+    /// The default implementation ignores the information.
+    ///
+    /// @param offset is the first modified byte in the config file.
+    /// @param len is the number of modified bytes.
+    virtual void mark_dirty(unsigned offset, unsigned len)
+    {
+    }
 };
 
 #endif // _UTILS_CONFIGUPDATESERVICE_HXX_
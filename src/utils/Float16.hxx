@@ -0,0 +1,140 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Float16.hxx
+ *
+ * Fast conversion between IEEE single precision floats and the half precision
+ * (float16) format used on the wire for speeds.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _UTILS_FLOAT16_HXX_
+#define _UTILS_FLOAT16_HXX_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/// Converts a half precision value to a float.
+///
+/// The result is bit-exact with halfp2singles() from ieeehalfprecision.c,
+/// including its handling of NaN payloads (the half bits are shifted into
+/// the top of the float).
+///
+/// @param h is the half precision bit pattern.
+/// @return the float value.
+inline float float16_to_float(uint16_t h)
+{
+    uint32_t x;
+    uint32_t habs = h & 0x7FFFu;
+    if (habs >= 0x0400u && habs < 0x7C00u)
+    {
+        // Normalized number: rebias the exponent from 15 to 127.
+        x = ((uint32_t)(h & 0x8000u) << 16) | ((habs << 13) + 0x38000000u);
+    }
+    else if (habs == 0x7C00u)
+    {
+        // Infinity.
+        x = ((uint32_t)(h & 0x8000u) << 16) | 0x7F800000u;
+    }
+    else if (habs >= 0x0400u || habs == 0)
+    {
+        // NaN or signed zero.
+        x = (uint32_t)h << 16;
+    }
+    else
+    {
+        // Denormal: the value is exactly habs * 2^-24.
+        float f = habs * (1.0f / 16777216.0f);
+        memcpy(&x, &f, 4);
+        x |= (uint32_t)(h & 0x8000u) << 16;
+    }
+    float f;
+    memcpy(&f, &x, 4);
+    return f;
+}
+
+/// Converts a float to half precision.
+///
+/// The result is bit-exact with singles2halfp() from ieeehalfprecision.c:
+/// ties are rounded away from zero (not to even), float denormals become
+/// signed zero and NaNs keep the top 16 bits of the float.
+///
+/// @param f is the value to convert.
+/// @return the half precision bit pattern.
+inline uint16_t float_to_float16(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t xabs = x & 0x7FFFFFFFu;
+    uint16_t hs = (uint16_t)((x >> 16) & 0x8000u);
+    if (xabs >= 0x38800000u && xabs < 0x47800000u)
+    {
+        // Result is a normalized half: rebias the exponent from 127 to 15,
+        // round on the highest dropped mantissa bit.
+        return hs | (uint16_t)(((xabs - 0x38000000u) >> 13) +
+                       ((xabs >> 12) & 1));
+    }
+    if (xabs < 0x00800000u)
+    {
+        // Zero or float denormal.
+        return hs;
+    }
+    if (xabs >= 0x7F800000u)
+    {
+        // Infinity or NaN.
+        return xabs == 0x7F800000u ? (hs | 0x7C00u) : (uint16_t)(x >> 16);
+    }
+    if (xabs >= 0x47800000u)
+    {
+        // Overflow.
+        return hs | 0x7C00u;
+    }
+    // Underflow to a half denormal.
+    int hes = (int)(xabs >> 23) - 127 + 15;
+    if (14 - hes > 24)
+    {
+        return hs;
+    }
+    uint32_t xm = (xabs & 0x007FFFFFu) | 0x00800000u;
+    return hs | (uint16_t)((xm >> (14 - hes)) + ((xm >> (13 - hes)) & 1));
+}
+
+/// Converts an array of half precision values to floats.
+/// @param dst is where to write the floats.
+/// @param src is the array of half precision bit patterns.
+/// @param count is the number of values to convert.
+void float16_to_float_array(float *dst, const uint16_t *src, size_t count);
+
+/// Converts an array of floats to half precision.
+/// @param dst is where to write the half precision bit patterns.
+/// @param src is the array of floats.
+/// @param count is the number of values to convert.
+void float_to_float16_array(uint16_t *dst, const float *src, size_t count);
+
+#endif // _UTILS_FLOAT16_HXX_
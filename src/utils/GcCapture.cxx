@@ -0,0 +1,148 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file GcCapture.cxx
+ *
+ * Reads GridConnect packet captures back into CAN frames.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "utils/GcCapture.hxx"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/gc_format.h"
+
+/// Longest packet we accept between the ':' and ';' characters.
+static const unsigned MAX_PACKET_LENGTH = 32;
+
+/// Converts a calendar date to the number of days since 1970-01-01. Does not
+/// depend on the local timezone.
+/// @param y year @param m month (1..12) @param d day of month (1..31)
+/// @return days since the epoch.
+static long long days_from_civil(int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const long long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long long)doe - 719468;
+}
+
+/// Parses a GcPacketPrinter timestamp at the beginning of a line.
+/// @param line input text.
+/// @param nsec will be filled with the timestamp on success.
+/// @return true if the line started with a timestamp.
+static bool parse_timestamp(const char *line, long long *nsec)
+{
+    int year, mon, day, hour, min, sec;
+    long usec;
+    if (sscanf(line, "%d-%d-%d %d:%d:%d:%ld", &year, &mon, &day, &hour, &min,
+            &sec, &usec) != 7)
+    {
+        return false;
+    }
+    long long s = days_from_civil(year, mon, day) * 86400LL + hour * 3600LL +
+        min * 60LL + sec;
+    *nsec = s * 1000000000LL + usec * 1000LL;
+    return true;
+}
+
+unsigned gc_capture_parse_line(
+    const char *line, std::vector<GcCaptureFrame> *out, unsigned *errors)
+{
+    long long ts = -1;
+    const char *p = line;
+    if (parse_timestamp(line, &ts))
+    {
+        // Skips the date and time fields; the rest of the timestamp does not
+        // contain a ':'.
+        p = strchr(p, ' ');
+        p = p ? strchr(p + 1, ' ') : nullptr;
+        if (!p)
+        {
+            return 0;
+        }
+    }
+    unsigned count = 0;
+    while ((p = strchr(p, ':')) != nullptr)
+    {
+        ++p;
+        const char *end = strchr(p, ';');
+        if (!end)
+        {
+            break;
+        }
+        char buf[MAX_PACKET_LENGTH + 1];
+        unsigned len = end - p;
+        GcCaptureFrame f;
+        f.timeNsec = ts;
+        bool ok = false;
+        if (len <= MAX_PACKET_LENGTH)
+        {
+            memcpy(buf, p, len);
+            buf[len] = 0;
+            ok = gc_format_parse(buf, &f.frame) == 0;
+        }
+        if (ok)
+        {
+            out->push_back(f);
+            ++count;
+        }
+        else if (errors)
+        {
+            ++*errors;
+        }
+        p = end + 1;
+    }
+    return count;
+}
+
+unsigned gc_capture_read(
+    FILE *f, std::vector<GcCaptureFrame> *out, unsigned *errors)
+{
+    char line[1024];
+    unsigned count = 0;
+    long long last_ts = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        size_t first = out->size();
+        count += gc_capture_parse_line(line, out, errors);
+        for (size_t i = first; i < out->size(); ++i)
+        {
+            if ((*out)[i].timeNsec < 0)
+            {
+                (*out)[i].timeNsec = last_ts;
+            }
+            last_ts = (*out)[i].timeNsec;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,82 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file GcCapture.hxx
+ *
+ * Reads GridConnect packet captures, such as the ones written by
+ * GcPacketPrinter, back into CAN frames.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _UTILS_GCCAPTURE_HXX_
+#define _UTILS_GCCAPTURE_HXX_
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "can_frame.h"
+
+/// One frame of a GridConnect capture.
+struct GcCaptureFrame
+{
+    /// Time when the frame was captured, in nanoseconds from an arbitrary
+    /// epoch. Only differences between two frames are meaningful. -1 if the
+    /// capture had no timestamp for this frame.
+    long long timeNsec;
+    /// The captured frame.
+    struct can_frame frame;
+};
+
+/// Parses one line of a GridConnect capture. The line may start with a
+/// timestamp as written by GcPacketPrinter in timestamped mode
+/// ("YYYY-MM-DD HH:MM:SS:uuuuuu [0x...] "), followed by any number of
+/// ":X...N...;" packets. Text that is not a packet is ignored.
+///
+/// @param line is the text to parse (does not need to be newline
+/// terminated).
+/// @param out parsed frames will be appended here. All frames from one line
+/// get the line's timestamp.
+/// @param errors if not null, will be incremented for every packet that
+/// could not be parsed.
+/// @return the number of frames appended.
+unsigned gc_capture_parse_line(
+    const char *line, std::vector<GcCaptureFrame> *out, unsigned *errors);
+
+/// Reads an entire capture file. Frames without a timestamp inherit the
+/// timestamp of the frame before them (or zero at the start of the file).
+///
+/// @param f is the file to read until EOF.
+/// @param out parsed frames will be appended here.
+/// @param errors if not null, will be incremented for every packet that
+/// could not be parsed.
+/// @return the number of frames appended.
+unsigned gc_capture_read(
+    FILE *f, std::vector<GcCaptureFrame> *out, unsigned *errors);
+
+#endif // _UTILS_GCCAPTURE_HXX_
@@ -40,13 +40,41 @@
 
 void GcTcpHub::OnNewConnection(int fd)
 {
-    const bool use_select =
+    bool use_select =
         (config_gridconnect_tcp_use_select() == CONSTANT_TRUE);
-    create_gc_port_for_can_hub(canHub_, fd, nullptr, use_select);
+    Service *service = nullptr;
+    if (!shards_.empty())
+    {
+        service = shards_[nextShard_];
+        nextShard_ = (nextShard_ + 1) % shards_.size();
+        // The shard's executor does the socket IO too.
+        use_select = true;
+    }
+    const CanStreamFormat format = acceptBinary_
+        ? CanStreamFormat::NEGOTIATE
+        : CanStreamFormat::GRIDCONNECT;
+    create_port_for_can_hub(
+        canHub_, fd, format, nullptr, use_select, service, limits_);
 }
 
-GcTcpHub::GcTcpHub(CanHubFlow *can_hub, int port)
+GcTcpHub::GcTcpHub(
+    CanHubFlow *can_hub, int port, const HubPortLimits &limits)
     : canHub_(can_hub)
+    , limits_(limits)
+    , acceptBinary_(
+          config_gridconnect_tcp_accept_binary() == CONSTANT_TRUE)
+    , tcpListener_(port, std::bind(&GcTcpHub::OnNewConnection, this,
+                                   std::placeholders::_1))
+{
+}
+
+GcTcpHub::GcTcpHub(CanHubFlow *can_hub, int port,
+    std::vector<Service *> shards, const HubPortLimits &limits)
+    : canHub_(can_hub)
+    , shards_(std::move(shards))
+    , limits_(limits)
+    , acceptBinary_(
+          config_gridconnect_tcp_accept_binary() == CONSTANT_TRUE)
     , tcpListener_(port, std::bind(&GcTcpHub::OnNewConnection, this,
                                    std::placeholders::_1))
 {
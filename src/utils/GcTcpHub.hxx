@@ -34,8 +34,11 @@
 #ifndef _UTILS_GCTCPHUB_HXX_
 #define _UTILS_GCTCPHUB_HXX_
 
+#include <vector>
+
 #include "utils/socket_listener.hxx"
 #include "utils/Hub.hxx"
+#include "utils/HubPortLimit.hxx"
 
 class ExecutorBase;
 
@@ -51,9 +54,38 @@ public:
     /// @param can_hub Which CAN-hub should we attach the TCP gridconnect hub
     /// onto.
     /// @param port TCp port number to listen on.
-    GcTcpHub(CanHubFlow *can_hub, int port);
+    /// @param limits bounds the queue of the data waiting to be sent to each
+    /// client.
+    GcTcpHub(CanHubFlow *can_hub, int port,
+        const HubPortLimits &limits = HubPortLimits());
+
+    /// Constructor for a sharded hub. Incoming connections are assigned to
+    /// the shards round-robin; the socket IO (using select) and the
+    /// gridconnect parsing and formatting of each connection run on its
+    /// shard's executor, and only binary frames are exchanged with can_hub.
+    ///
+    /// @param can_hub Which CAN-hub should we attach the TCP gridconnect hub
+    /// onto.
+    /// @param port TCp port number to listen on.
+    /// @param shards services to run the connections on. Must outlive *this
+    /// and all connections.
+    /// @param limits bounds the queue of the data waiting to be sent to each
+    /// client.
+    GcTcpHub(CanHubFlow *can_hub, int port, std::vector<Service *> shards,
+        const HubPortLimits &limits = HubPortLimits());
+
     ~GcTcpHub();
 
+    /// Enables or disables the binary CAN stream format for the connections
+    /// accepted from now on. When enabled, clients that start the connection
+    /// with BINARY_CAN_HELLO are switched to binary. The default comes from
+    /// the gridconnect_tcp_accept_binary constant. @param accept true to
+    /// enable.
+    void set_accept_binary(bool accept)
+    {
+        acceptBinary_ = accept;
+    }
+
     /// @return true of the listener is ready to accept incoming connections.
     bool is_started()
     {
@@ -70,6 +102,15 @@ private:
     /// @param can_hub Which CAN-hub should we attach the TCP gridconnect hub
     /// onto.
     CanHubFlow *canHub_;
+    /// Services to distribute the connections to. Empty if all connections
+    /// run on the executor of canHub_.
+    std::vector<Service *> shards_;
+    /// Index of the shard to assign the next connection to.
+    unsigned nextShard_ {0};
+    /// Output queue limits of the connections.
+    HubPortLimits limits_;
+    /// True if the connections may switch to the binary format.
+    bool acceptBinary_;
     /// Helper object representing the listening on the socket.
     SocketListener tcpListener_;
 };
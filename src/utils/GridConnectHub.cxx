@@ -43,9 +43,47 @@
 #include "utils/HubDevice.hxx"
 #include "utils/HubDeviceSelect.hxx"
 #include "utils/Hub.hxx"
+#include "utils/BinaryCanStream.hxx"
 #include "utils/GcStreamParser.hxx"
 #include "utils/gc_format.h"
 
+/// CAN-typed hub port with a bounded input queue. Base of the bridge members
+/// that format CAN frames for a byte stream; their input queue is where the
+/// traffic for a slow device piles up, because the BufferPort only accepts a
+/// new chunk after the device took the previous one.
+class LimitedCanHubPort : public LimitedHubPortFlow<Buffer<CanHubData>>
+{
+public:
+    /// Constructor. @param service which executor to run on.
+    LimitedCanHubPort(Service *service)
+        : LimitedHubPortFlow<Buffer<CanHubData>>(service)
+    {
+    }
+
+    /// Sets the queue limits.
+    /// @param limits is the queue bound and overflow policy.
+    /// @param on_overflow will be notified when the DISCONNECT policy
+    /// triggers; it should close the device.
+    void set_limits(const HubPortLimits &limits, Notifiable *on_overflow)
+    {
+        onOverflow_ = on_overflow;
+        LimitedHubPortFlow<Buffer<CanHubData>>::set_limits(limits);
+    }
+
+protected:
+    void overflow_disconnect() OVERRIDE
+    {
+        if (onOverflow_)
+        {
+            onOverflow_->notify();
+        }
+    }
+
+private:
+    /// Notified when the queue overflows with the DISCONNECT policy.
+    Notifiable *onOverflow_ {nullptr};
+};
+
 /// Actual implementation for the gridconnect bridge between a string-typed Hub
 /// and a CAN-frame-typed Hub.
 class GCAdapter : public GCAdapterBase
@@ -53,13 +91,14 @@ class GCAdapter : public GCAdapterBase
 public:
     /// Constructor.
     ///
-    /// @param gc_side A hub of type string, the gridconnect side.
+    /// @param gc_side A hub of type string, the gridconnect side. The
+    /// conversion runs on the executor of this hub.
     /// @param can_side A hub of type struct can_frame, the binary side.
     /// @param double_bytes if true, upon rendering data each byte will be
     /// doubled. This is an anciant workaround.
     GCAdapter(HubFlow *gc_side, CanHubFlow *can_side, bool double_bytes)
-        : parser_(can_side->service(), can_side, &formatter_)
-        , formatter_(can_side->service(), gc_side, &parser_, double_bytes)
+        : parser_(gc_side->service(), can_side, &formatter_)
+        , formatter_(gc_side->service(), gc_side, &parser_, double_bytes)
     {
         gc_side->register_port(&parser_);
         can_side->register_port(&formatter_);
@@ -108,10 +147,16 @@ public:
         return formatter_.shutdown() && parser_.is_waiting() && formatter_.is_waiting();
     }
 
+    void set_limits(
+        const HubPortLimits &limits, Notifiable *on_overflow) OVERRIDE
+    {
+        formatter_.set_limits(limits, on_overflow);
+    }
+
     /// HubPort (on a CAN-typed hub) that turns a binary CAN packet into a
     /// string-formatted CAN packet, and sends it off to the HubFlow (of type
     /// string).
-    class BinaryToGCMember : public CanHubPort
+    class BinaryToGCMember : public LimitedCanHubPort
     {
     public:
         /// Constructor.
@@ -124,7 +169,7 @@ public:
         /// doubled. This is an anciant workaround.
         BinaryToGCMember(Service *service, HubFlow *destination,
             HubPort *skip_member, int double_bytes)
-            : CanHubPort(service)
+            : LimitedCanHubPort(service)
             , delayPort_(service, destination, config_gridconnect_buffer_size(),
                   USEC_TO_NSEC(config_gridconnect_buffer_delay_usec()))
             , destination_(destination)
@@ -145,6 +190,7 @@ public:
         
         Action entry() override
         {
+            record_queue_latency();
             LOG(VERBOSE, "can packet arrived: %" PRIx32,
                 GET_CAN_FRAME_ID_EFF(*message()->data()));
             char *end =
@@ -260,6 +306,9 @@ public:
             if (streamSegmenter_.parse_frame_to_output(b->data()))
             {
                 b->data()->skipMember_ = skipMember_;
+                // The frame entered the stack with the text it was parsed
+                // from.
+                b->set_timestamp(message()->timestamp());
                 destination_->send(b);
             }
             else
@@ -315,6 +364,207 @@ GCAdapterBase *GCAdapterBase::CreateGridConnectAdapter(HubFlow *gc_side_read,
     return new GCAdapter(gc_side_read, gc_side_write, can_side, double_bytes);
 }
 
+/// Bridge between a byte stream hub and a CAN-frame-typed Hub using the binary
+/// CAN stream format (see BinaryCanStream.hxx). Same structure as GCAdapter.
+class BinaryCanAdapter : public GCAdapterBase
+{
+public:
+    /// Constructor.
+    ///
+    /// @param byte_side A hub of type string, carrying the binary stream. The
+    /// conversion runs on the executor of this hub.
+    /// @param can_side A hub of type struct can_frame.
+    BinaryCanAdapter(HubFlow *byte_side, CanHubFlow *can_side)
+        : parser_(byte_side->service(), can_side, &formatter_)
+        , formatter_(byte_side->service(), byte_side, &parser_)
+    {
+        byte_side->register_port(&parser_);
+        can_side->register_port(&formatter_);
+        isRegistered_ = 1;
+    }
+
+    ~BinaryCanAdapter()
+    {
+        unregister();
+    }
+
+    /// Removes the members from the hubs.
+    void unregister()
+    {
+        if (isRegistered_)
+        {
+            parser_.destination()->unregister_port(&formatter_);
+            formatter_.destination()->unregister_port(&parser_);
+            isRegistered_ = 0;
+        }
+    }
+
+    bool shutdown() OVERRIDE
+    {
+        unregister();
+        return formatter_.shutdown() && parser_.is_waiting() &&
+            formatter_.is_waiting();
+    }
+
+    void set_limits(
+        const HubPortLimits &limits, Notifiable *on_overflow) OVERRIDE
+    {
+        formatter_.set_limits(limits, on_overflow);
+    }
+
+    /// HubPort (on a CAN-typed hub) that encodes CAN frames and sends the
+    /// bytes to the byte stream hub.
+    class CanToStreamMember : public LimitedCanHubPort
+    {
+    public:
+        /// Constructor.
+        ///
+        /// @param service which executor to run on
+        /// @param destination byte hub to write the encoded frames to.
+        /// @param skip_member what to set the skipMember_ field of the
+        /// outgoing data to.
+        CanToStreamMember(
+            Service *service, HubFlow *destination, HubPort *skip_member)
+            : LimitedCanHubPort(service)
+            , delayPort_(service, destination, config_gridconnect_buffer_size(),
+                  USEC_TO_NSEC(config_gridconnect_buffer_delay_usec()))
+            , destination_(destination)
+            , skipMember_(skip_member)
+        {
+        }
+
+        /// @return where to write the data to.
+        HubFlow *destination()
+        {
+            return destination_;
+        }
+
+        /// @return true if all data is flushed.
+        bool shutdown()
+        {
+            return delayPort_.shutdown();
+        }
+
+        Action entry() override
+        {
+            record_queue_latency();
+            uint8_t dbuf[BINARY_CAN_MAX_FRAME_LENGTH];
+            unsigned size = binary_can_format_generate(message()->data(), dbuf);
+            Buffer<HubData> *target_buffer = nullptr;
+            mainBufferPool->alloc(&target_buffer);
+            target_buffer->data()->skipMember_ = skipMember_;
+            target_buffer->data()->assign((const char *)dbuf, size);
+            target_buffer->set_done(bn_.reset(this));
+            delayPort_.send(target_buffer, 0);
+            release();
+            return wait_and_call(STATE(buffer_accepted));
+        }
+
+        /// Called when the delay port took the data. @return next action.
+        Action buffer_accepted()
+        {
+            return exit();
+        }
+
+    private:
+        /// Assembles larger outgoing chunks from the individual frames by
+        /// delaying data a little bit.
+        BufferPort delayPort_;
+        /// Hub to send data to.
+        HubFlow *destination_;
+        /// The hub member that should be sent as "source".
+        HubPort *skipMember_;
+        /// Helper object
+        BarrierNotifiable bn_;
+    };
+
+    /// HubPort (on a byte stream hub) that decodes the incoming bytes and
+    /// sends the frames to the CAN-frame-typed hub.
+    class StreamToCanMember : public HubPort
+    {
+    public:
+        /// Constructor.
+        ///
+        /// @param service defines the executor to run on.
+        /// @param destination Where to write the decoded frames.
+        /// @param skip_member what to set skipMember_ of the outgoing frames
+        /// to.
+        StreamToCanMember(
+            Service *service, CanHubFlow *destination, CanHubPort *skip_member)
+            : HubPort(service)
+            , destination_(destination)
+            , skipMember_(skip_member)
+        {
+        }
+
+        /// @return the destination to write data to.
+        CanHubFlow *destination()
+        {
+            return destination_;
+        }
+
+        /// Takes the incoming bytes. @return next state.
+        Action entry() override
+        {
+            inBuf_ = (const uint8_t *)message()->data()->data();
+            inBufSize_ = message()->data()->size();
+            return call_immediately(STATE(parse_more_data));
+        }
+
+        /// Feeds the bytes to the parser until a frame is complete. @return
+        /// next state.
+        Action parse_more_data()
+        {
+            while (inBufSize_--)
+            {
+                if (streamParser_.consume_byte(*inBuf_++))
+                {
+                    return allocate_and_call(
+                        destination_, STATE(parse_to_output_frame));
+                }
+            }
+            return release_and_exit();
+        }
+
+        /// Sends off the completed frame. @return next state.
+        Action parse_to_output_frame()
+        {
+            auto *b = get_allocation_result(destination_);
+            streamParser_.parse_frame_to_output(b->data());
+            b->data()->skipMember_ = skipMember_;
+            b->set_timestamp(message()->timestamp());
+            destination_->send(b);
+            return call_immediately(STATE(parse_more_data));
+        }
+
+    private:
+        /// Holds the partial frame between chunks.
+        BinaryCanStreamParser streamParser_;
+        /// The incoming bytes.
+        const uint8_t *inBuf_;
+        /// The remaining number of bytes in inBuf_.
+        size_t inBufSize_;
+        /// Hub to send frames to.
+        CanHubFlow *destination_;
+        /// The hub member that should be sent as "source".
+        CanHubPortInterface *skipMember_;
+    };
+
+private:
+    /// Decodes the incoming stream.
+    StreamToCanMember parser_;
+    /// Encodes the outgoing frames.
+    CanToStreamMember formatter_;
+    /// 1 if the flows are registered.
+    unsigned isRegistered_ : 1;
+};
+
+GCAdapterBase *GCAdapterBase::CreateBinaryAdapter(
+    HubFlow *byte_side, CanHubFlow *can_side)
+{
+    return new BinaryCanAdapter(byte_side, can_side);
+}
+
 /// Implementation for the gridconnect bridge. Owns all necessary structures,
 /// and is responsible for the initialization, registering, unregistering and
 /// destruction of these structures.
@@ -380,7 +630,7 @@ GcPacketPrinter::~GcPacketPrinter()
 }
 
 /// Implementation class that adds a device to a CAN hub with dynamic
-/// translation of the packets to/from GridConnect format.
+/// translation of the packets to/from GridConnect (or binary) format.
 ///
 /// Sends a notification to the application level when there is an error on the
 /// device and the connection is closed.
@@ -394,23 +644,170 @@ struct GcHubPort : public Executable
     /// experiences an error (typically upon device closed or connection lost).
     /// @param use_select true if fd can be used with select, false if threads
     /// are needed.
-    GcHubPort(CanHubFlow *can_hub, int fd, Notifiable *on_exit, bool use_select)
-        : gcHub_(can_hub->service())
-        , bridge_(
-              GCAdapterBase::CreateGridConnectAdapter(&gcHub_, can_hub, false))
+    /// @param service executor to run the fd IO and the gridconnect
+    /// conversion on; null to use the executor of can_hub.
+    /// @param format is the byte stream format on fd.
+    /// @param limits bounds the queue of frames waiting to be formatted and
+    /// written to fd.
+    GcHubPort(CanHubFlow *can_hub, int fd, Notifiable *on_exit,
+        bool use_select, Service *service, CanStreamFormat format,
+        const HubPortLimits &limits)
+        : gcHub_(service ? service : can_hub->service())
+        , bridge_(format == CanStreamFormat::BINARY
+                  ? GCAdapterBase::CreateBinaryAdapter(&gcHub_, can_hub)
+                  : GCAdapterBase::CreateGridConnectAdapter(
+                        &gcHub_, can_hub, false))
+        , canHub_(can_hub)
         , onExit_(on_exit)
+        , limits_(limits)
+        , overflow_(this)
     {
         LOG(VERBOSE, "gchub port %p", (Executable *)this);
+        if (format == CanStreamFormat::NEGOTIATE)
+        {
+            // Has to be on the hub before the device starts reading.
+            negotiator_.reset(new Negotiator(this));
+        }
         if (use_select) {
             gcWrite_.reset(new HubDeviceSelect<HubFlow>(&gcHub_, fd, this));
         } else {
             gcWrite_.reset(new FdHubPort<HubFlow>(&gcHub_, fd, this));
         }
+        // The overflow handler needs gcWrite_.
+        bridge_->set_limits(limits_, &overflow_);
     }
     virtual ~GcHubPort()
     {
     }
 
+    /// Watches the traffic of a new connection, and if the device sends the
+    /// BINARY_CAN_HELLO, switches the port from GridConnect to binary. The
+    /// gridconnect side never generates a NUL byte, so the hello can only come
+    /// from the device. The hello may arrive split over several reads; the
+    /// chunk starting with the NUL tells which hub member the device is, and
+    /// the following chunks of that member are collected until they match or
+    /// rule out the hello.
+    class Negotiator : public HubPort
+    {
+    public:
+        /// How long after the connection the client may send the hello.
+        static constexpr long long TIMEOUT_NSEC = SEC_TO_NSEC(5);
+
+        /// Constructor. @param parent is the port to switch.
+        Negotiator(GcHubPort *parent)
+            : HubPort(parent->gcHub_.service())
+            , parent_(parent)
+            , deadline_(os_get_time_monotonic() + TIMEOUT_NSEC)
+            , isRegistered_(true)
+        {
+            parent_->gcHub_.register_port(this);
+        }
+
+        /// Stops watching the traffic. @return true if it is safe to destroy
+        /// *this.
+        bool shutdown()
+        {
+            unregister();
+            return is_waiting();
+        }
+
+        Action entry() override
+        {
+            auto *d = message()->data();
+            if (!isRegistered_)
+            {
+                return release_and_exit();
+            }
+            if (prefix_.empty() && !d->empty() && (*d)[0] == BINARY_CAN_HELLO[0])
+            {
+                device_ = d->skipMember_;
+            }
+            if (device_ && d->skipMember_ == device_ &&
+                prefix_.size() < sizeof(BINARY_CAN_HELLO))
+            {
+                prefix_.append(
+                    *d, 0, sizeof(BINARY_CAN_HELLO) - prefix_.size());
+                if (memcmp(prefix_.data(), BINARY_CAN_HELLO, prefix_.size()))
+                {
+                    // Not a hello; the device talks GridConnect.
+                    unregister();
+                    return release_and_exit();
+                }
+            }
+            if (prefix_.size() < sizeof(BINARY_CAN_HELLO))
+            {
+                if (os_get_time_monotonic() > deadline_)
+                {
+                    unregister();
+                }
+                return release_and_exit();
+            }
+            unregister();
+            release();
+            // parent_->gcWrite_ might not be set yet.
+            LOG(INFO, "GCHubPort: switching port %p to binary.",
+                (Executable *)parent_);
+            return call_immediately(STATE(stop_gridconnect));
+        }
+
+        /// Waits for the gridconnect bridge to flush and stop. @return next
+        /// state.
+        Action stop_gridconnect()
+        {
+            if (!parent_->bridge_->shutdown())
+            {
+                return yield_and_call(STATE(stop_gridconnect));
+            }
+            // The answer goes after any gridconnect data that was already
+            // generated.
+            Buffer<HubData> *b;
+            mainBufferPool->alloc(&b);
+            b->data()->assign(BINARY_CAN_HELLO, sizeof(BINARY_CAN_HELLO));
+            b->data()->skipMember_ = this;
+            b->set_done(bn_.reset(this));
+            parent_->gcHub_.send(b);
+            return wait_and_call(STATE(start_binary));
+        }
+
+        /// Called when the answer is written. Creating the binary bridge
+        /// earlier would make it parse the answer as a frame. @return next
+        /// state.
+        Action start_binary()
+        {
+            parent_->bridge_.reset(GCAdapterBase::CreateBinaryAdapter(
+                &parent_->gcHub_, parent_->canHub_));
+            parent_->bridge_->set_limits(
+                parent_->limits_, &parent_->overflow_);
+            return exit();
+        }
+
+    private:
+        /// Removes *this from the hub.
+        void unregister()
+        {
+            if (isRegistered_)
+            {
+                parent_->gcHub_.unregister_port(this);
+                isRegistered_ = false;
+            }
+        }
+
+        /// Port we are switching.
+        GcHubPort *parent_;
+        /// After this time (os_get_time_monotonic) we stop waiting for the
+        /// hello.
+        long long deadline_;
+        /// True if we are registered on the hub.
+        bool isRegistered_;
+        /// Hub member that sent the first byte of the hello, i.e. the device.
+        /// Null until then.
+        HubPortInterface *device_{nullptr};
+        /// Bytes of the hello received so far.
+        string prefix_;
+        /// Notified when the answer is written.
+        BarrierNotifiable bn_;
+    };
+
     /** This hub sees the character-based representation of the packets. The
      * members of it are: the bridge and the physical device (fd).
      *
@@ -428,9 +825,43 @@ struct GcHubPort : public Executable
      * fd. Similarly, listens to the fd and sends the read charcters to the
      * char-hub. */
     std::unique_ptr<FdHubPortInterface> gcWrite_;
+    /** Parent (binary) hub flow. */
+    CanHubFlow *canHub_;
     /** If not null, this notifiable will be called when the device is
      * closed. */
     Notifiable* onExit_;
+    /** Bounds the queue of frames waiting for the device. */
+    HubPortLimits limits_;
+
+    /// Closes the device when the bridge's queue overflows.
+    class OverflowNotifiable : public Notifiable
+    {
+    public:
+        /// Constructor. @param parent is the port to close.
+        OverflowNotifiable(GcHubPort *parent)
+            : parent_(parent)
+        {
+        }
+
+        void notify() OVERRIDE
+        {
+            parent_->gcWrite_->overflow_disconnect();
+        }
+
+    private:
+        /// Port to close.
+        GcHubPort *parent_;
+    };
+    /** Notified by the bridge when its queue overflows. */
+    OverflowNotifiable overflow_;
+    /** Switches the port to binary on request. Null if the port does not
+     * negotiate. */
+    std::unique_ptr<Negotiator> negotiator_;
+    /** True while run() is scheduled on the executor of canHub_. */
+    bool onCanExecutor_{false};
+    /** True if we have been through the executor of canHub_ since the bridge
+     * was unregistered. */
+    bool canHubFlushed_{false};
 
     /** Callback in case the connection is closed due to error. */
     void notify() OVERRIDE
@@ -444,10 +875,30 @@ struct GcHubPort : public Executable
 
     void run() OVERRIDE
     {
-        if (!bridge_->shutdown() || !gcHub_.is_waiting())
+        ExecutorBase *gc_executor = gcHub_.service()->executor();
+        if (onCanExecutor_)
+        {
+            onCanExecutor_ = false;
+            canHubFlushed_ = true;
+            gc_executor->add(this);
+            return;
+        }
+        if ((negotiator_ && !negotiator_->shutdown()) ||
+            !bridge_->shutdown() || !gcHub_.is_waiting())
         {
             // Yield.
-            gcHub_.service()->executor()->add(this);
+            gc_executor->add(this);
+            return;
+        }
+        ExecutorBase *can_executor = canHub_->service()->executor();
+        if (!canHubFlushed_ && can_executor != gc_executor)
+        {
+            /* The CAN hub runs on a different thread, and might have still
+             * been delivering a frame to the bridge when it got
+             * unregistered. Passing through the CAN hub's executor flushes
+             * that; then we check the bridge once more. */
+            onCanExecutor_ = true;
+            can_executor->add(this);
             return;
         }
         LOG(INFO, "GCHubPort: Shutting down gridconnect port %d. (%p)",
@@ -464,8 +915,16 @@ struct GcHubPort : public Executable
     }
 };
 
-void create_gc_port_for_can_hub(
-    CanHubFlow *can_hub, int fd, Notifiable *on_exit, bool use_select)
+void create_gc_port_for_can_hub(CanHubFlow *can_hub, int fd,
+    Notifiable *on_exit, bool use_select, Service *service)
+{
+    new GcHubPort(can_hub, fd, on_exit, use_select, service,
+        CanStreamFormat::GRIDCONNECT, HubPortLimits());
+}
+
+void create_port_for_can_hub(CanHubFlow *can_hub, int fd,
+    CanStreamFormat format, Notifiable *on_exit, bool use_select,
+    Service *service, const HubPortLimits &limits)
 {
-    new GcHubPort(can_hub, fd, on_exit, use_select);
+    new GcHubPort(can_hub, fd, on_exit, use_select, service, format, limits);
 }
@@ -37,6 +37,7 @@
 #include <memory>
 
 #include "utils/Hub.hxx"
+#include "utils/HubPortLimit.hxx"
 
 class Pipe;
 template <class T> class FlowInterface;
@@ -61,6 +62,14 @@ public:
     /// service. */
     virtual bool shutdown() = 0;
 
+    /// Bounds the queue of CAN frames waiting to be formatted for the byte
+    /// stream side.
+    /// @param limits is the queue bound and overflow policy.
+    /// @param on_overflow will be notified when the DISCONNECT policy
+    /// triggers; it should close the byte stream device.
+    virtual void set_limits(
+        const HubPortLimits &limits, Notifiable *on_overflow) = 0;
+
     /**
        This function connects an ASCII (GridConnect-format) CAN adapter to a
        binary CAN adapter, performing the necessary format conversions
@@ -101,6 +110,18 @@ public:
     ///
     static GCAdapterBase *CreateGridConnectAdapter(HubFlow *gc_side_read,
         HubFlow *gc_side_write, CanHubFlow *can_side, bool double_bytes);
+
+    /// Creates a bridge that uses the binary CAN stream format (see
+    /// BinaryCanStream.hxx) instead of GridConnect on the byte side.
+    ///
+    /// @param byte_side is the Hub that has the binary stream data. The
+    /// conversion runs on the executor of this hub.
+    /// @param can_side is the Hub that has the CAN frames.
+    ///
+    /// @return a pointer to the created object. It can be deleted, which will
+    ///   terminate the link and unregister the link members from both pipes.
+    static GCAdapterBase *CreateBinaryAdapter(
+        HubFlow *byte_side, CanHubFlow *can_side);
 };
 
 /** Create this port for a CAN hub and all packets will be written to stdout in
@@ -134,8 +155,40 @@ private:
  * @param on_exit is a notifiable (may be null) which will be called in case
  * an error is encountered on this port and the port is subsequently closed.
  * @param use_select when true, the FD will be used with select, when false,
- * separate threads will be started with blocking read and write calls. */
+ * separate threads will be started with blocking read and write calls.
+ * @param service if not null, the fd IO and the gridconnect parsing and
+ * formatting of this port run on this service's executor instead of the
+ * executor of can_hub. Only the binary frames cross to can_hub. */
 void create_gc_port_for_can_hub(CanHubFlow *can_hub, int fd,
-    Notifiable *on_exit = nullptr, bool use_select = false);
+    Notifiable *on_exit = nullptr, bool use_select = false,
+    Service *service = nullptr);
+
+/// Byte stream formats of a port created by create_port_for_can_hub.
+enum class CanStreamFormat
+{
+    /// GridConnect (ASCII).
+    GRIDCONNECT,
+    /// Binary CAN stream format (see BinaryCanStream.hxx).
+    BINARY,
+    /// Starts as GridConnect; switches to binary when the client sends
+    /// BINARY_CAN_HELLO in the first few seconds. For servers.
+    NEGOTIATE
+};
+
+/** Same as create_gc_port_for_can_hub, but with a selectable stream format.
+ * @param can_hub the raw CAN packets are coming/going to this object.
+ * @param fd the file descriptor of the port.
+ * @param format is the format of the byte stream on fd.
+ * @param on_exit is a notifiable (may be null) which will be called in case
+ * an error is encountered on this port and the port is subsequently closed.
+ * @param use_select when true, the FD will be used with select, when false,
+ * separate threads will be started with blocking read and write calls.
+ * @param service if not null, the port runs on this service's executor
+ * instead of the executor of can_hub.
+ * @param limits bounds the queue of the data waiting to be written to fd. */
+void create_port_for_can_hub(CanHubFlow *can_hub, int fd,
+    CanStreamFormat format, Notifiable *on_exit = nullptr,
+    bool use_select = false, Service *service = nullptr,
+    const HubPortLimits &limits = HubPortLimits());
 
 #endif //_UTILS_GRIDCONNECTHUB_HXX_
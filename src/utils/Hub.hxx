@@ -39,6 +39,7 @@
 
 #include "executor/Dispatcher.hxx"
 #include "can_frame.h"
+#include "utils/Metrics.hxx"
 
 class PipeBuffer;
 class PipeMember;
@@ -161,6 +162,27 @@ public:
         this->negateMatch_ = true;
     }
 
+    ~GenericHubFlow()
+    {
+        if (METRICS_ENABLED)
+        {
+            MetricsRegistry::instance()->remove(this);
+        }
+    }
+
+    /// Exports the packet count, port count and queue depth of this hub into
+    /// the MetricsRegistry.
+    /// @param prefix is prepended to the metric names, e.g. "hub.can".
+    void register_metrics(const char *prefix)
+    {
+        MetricsRegistry *r = MetricsRegistry::instance();
+        std::string p(prefix);
+        r->add(this, p + ".packets", &packets_);
+        r->add_gauge(this, p + ".ports", [this]() { return this->size(); });
+        r->add_gauge(this, p + ".queue",
+            [this]() { return this->queue_size(); });
+    }
+
     /// Adds a new port. After add return, all messages puslished to the hub
     /// will be sent to 'port'. @param port is the object to add.
     void register_port(port_type *port)
@@ -175,6 +197,19 @@ public:
         this->unregister_handler(port, reinterpret_cast<uintptr_t>(port),
                                  POINTER_MASK);
     }
+
+protected:
+    /// Counts the packets, then forwards them to the ports. @return next
+    /// state.
+    StateFlowBase::Action entry() override
+    {
+        packets_.inc();
+        return DispatchFlow<Buffer<D>, 1>::entry();
+    }
+
+private:
+    /// Number of packets that went through this hub.
+    CounterMetric packets_;
 };
 
 /** A generic hub that proxies packets of untyped (aka string) data. */
@@ -223,6 +258,10 @@ public:
         return fd_;
     }
 
+    /// Closes the device because it does not keep up with the data written to
+    /// it (see HubPortOverflow::DISCONNECT). May be called from any thread.
+    virtual void overflow_disconnect() = 0;
+
 protected:
     FdHubPortInterface() : fd_(-1) {}
 
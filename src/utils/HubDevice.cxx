@@ -34,6 +34,9 @@
 #include "utils/HubDevice.hxx"
 #include "nmranet_config.h"
 #include <stdlib.h>
+#if defined(__linux__) || defined(__MACH__)
+#include <sys/socket.h>
+#endif
 
 template <>
 const int FdHubPort<CanHubFlow>::ReadThread::kUnit = sizeof(struct can_frame);
@@ -118,3 +121,22 @@ void FdHubPortBase::fill_thread_name(char *buf, char mode, int fd)
         ff /= 10;
     } while (ff);
 }
+
+void FdHubPortBase::overflow_disconnect()
+{
+    {
+        AtomicHolder h(this);
+        if (hasError_)
+        {
+            return;
+        }
+    }
+    LOG(INFO, "Closing fd %d: output queue overflow.", fd_);
+#if defined(__linux__) || defined(__MACH__)
+    if (::shutdown(fd_, SHUT_RDWR) == 0)
+    {
+        return;
+    }
+#endif
+    report_error();
+}
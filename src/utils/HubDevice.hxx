@@ -37,6 +37,7 @@
 #include <unistd.h>
 
 #include "utils/Hub.hxx"
+#include "utils/HubPortLimit.hxx"
 #include "executor/SemaphoreNotifiableBlock.hxx"
 
 template <class Data> class FdHubWriteFlow;
@@ -114,6 +115,11 @@ protected:
         unregister_write_port();
     }
 
+    /// Shuts down the socket, which wakes up the threads blocked in read and
+    /// write, and they report the error. Other fds are closed directly, but a
+    /// write blocked on them will not return.
+    void overflow_disconnect() OVERRIDE;
+
     /// Read thread implementation with template-inspecific methods.
     class ReadThreadBase : public OSThread
     {
@@ -204,12 +210,12 @@ protected:
 /// writes, thus must be run on its own executor (and must never be run on the
 /// shared executor used by the stack).
 template <class Data>
-class FdHubWriteFlow : public StateFlow<Buffer<Data>, QList<1>>
+class FdHubWriteFlow : public LimitedHubPortFlow<Buffer<Data>>
 {
 public:
     /// Constructor. @param parent is the owning port.
     FdHubWriteFlow(FdHubPortBase *parent)
-        : StateFlow<Buffer<Data>, QList<1>>(&parent->writeService_)
+        : LimitedHubPortFlow<Buffer<Data>>(&parent->writeService_)
         , port_(parent)
     {
     }
@@ -220,6 +226,7 @@ public:
         const uint8_t *buf =
             reinterpret_cast<const uint8_t *>(this->message()->data()->data());
         size_t size = this->message()->data()->size();
+        this->record_queue_latency();
         while (size > 0)
         {
             {
@@ -262,6 +269,12 @@ public:
 
     /// The owning port.
     FdHubPortBase *port_;
+
+protected:
+    void overflow_disconnect() OVERRIDE
+    {
+        port_->overflow_disconnect();
+    }
 };
 
 /// HubPort that connects a raw device to a strongly typed Hub.
@@ -290,6 +303,9 @@ public:
         , readThread_(this)
     {
         hub_->register_port(&writeFlow_);
+        // Anything sent in response to the incoming data should reach the
+        // device, so we only start reading after the registration.
+        readThread_.start_reading();
     }
 
     ~FdHubPort() OVERRIDE
@@ -297,6 +313,13 @@ public:
         writeThread_.shutdown();
     }
 
+    /// Bounds the queue of the data waiting to be written to the device.
+    /// @param limits is the new configuration.
+    void set_limits(const HubPortLimits &limits)
+    {
+        writeFlow_.set_limits(limits);
+    }
+
     void unregister_write_port() OVERRIDE
     {
         hub_->unregister_port(&writeFlow_);
@@ -305,7 +328,7 @@ public:
          * barrier notifiable, commencing the shutdown. */
         auto *b = writeFlow_.alloc();
         b->set_done(&barrier_);
-        writeFlow_.send(b);
+        writeFlow_.send_final(b);
     }
 
     /// Thread performing the read operations on the device.
@@ -316,10 +339,15 @@ public:
         ReadThread(FdHubPort<HFlow> *port) : ReadThreadBase(port)
         {
             init();
-            start(port->fill_thread_name('R', port->fd_), 0,
-                  port->kReadThreadStackSize);
         }
-        
+
+        /// Starts the thread.
+        void start_reading()
+        {
+            start(port()->fill_thread_name('R', port()->fd_), 0,
+                  port()->kReadThreadStackSize);
+        }
+
         ~ReadThread() {
             delete semaphores_;
         }
@@ -40,7 +40,9 @@
 
 #include "executor/StateFlow.hxx"
 #include "freertos/can_ioctl.h"
+#include "utils/BufferLatency.hxx"
 #include "utils/Hub.hxx"
+#include "utils/HubPortLimit.hxx"
 
 /// Generic template for the buffer traits. HubDeviceSelect will not compile on
 /// this default template because it lacks the necessary definitions. For each
@@ -153,10 +155,12 @@ public:
         , hub_(hub)
         , readFlow_(this)
         , writeFlow_(this)
+        , disconnector_(this)
     {
         HASSERT(fd_ >= 0);
         barrier_.new_child();
         hub_->register_port(write_port());
+        readFlow_.start();
     }
 #endif
 
@@ -174,6 +178,7 @@ public:
         , hub_(hub)
         , readFlow_(this)
         , writeFlow_(this)
+        , disconnector_(this)
     {
         HASSERT(fd_ >= 0);
         barrier_.new_child();
@@ -184,6 +189,8 @@ public:
         ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
 #endif
         hub_->register_port(write_port());
+        // Responses to the incoming data have to find the write port.
+        readFlow_.start();
     }
 
     virtual ~HubDeviceSelect()
@@ -221,6 +228,27 @@ public:
         return &writeFlow_;
     }
 
+    /// Schedules closing the device on its executor.
+    void overflow_disconnect() OVERRIDE
+    {
+        {
+            AtomicHolder h(this);
+            if (disconnectScheduled_)
+            {
+                return;
+            }
+            disconnectScheduled_ = true;
+        }
+        executor()->add(&disconnector_);
+    }
+
+    /// Bounds the queue of the data waiting to be written to the device.
+    /// @param limits is the new configuration.
+    void set_limits(const HubPortLimits &limits)
+    {
+        writeFlow_.set_limits(limits);
+    }
+
     /// Removes the current write port from the registry of the source hub.
     void unregister_write_port()
     {
@@ -230,7 +258,7 @@ public:
          * barrier notifiable, commencing the shutdown. */
         auto *b = writeFlow_.alloc();
         b->set_done(&barrier_);
-        writeFlow_.send(b);
+        writeFlow_.send_final(b);
     }
 
 protected:
@@ -247,6 +275,11 @@ protected:
         ReadFlow(HubDeviceSelect *device)
             : StateFlowBase(device)
             , b_(nullptr)
+        {
+        }
+
+        /// Starts reading the device.
+        void start()
         {
             this->start_flow(STATE(allocate_buffer));
         }
@@ -307,6 +340,7 @@ protected:
             }
             SelectBufferInfo<buffer_type>::check_target_size(
                 b_, selectHelper_.remaining_);
+            BufferLatency::stamp(b_);
             device()->hub()->send(b_, 0);
             b_ = nullptr;
             return this->call_immediately(STATE(allocate_buffer));
@@ -333,7 +367,7 @@ protected:
     };
 
     /// Base stateflow for the WriteFlow.
-    typedef StateFlow<typename HFlow::buffer_type, QList<1>> WriteFlowBase;
+    typedef LimitedHubPortFlow<typename HFlow::buffer_type> WriteFlowBase;
     /// State flow implementing select-aware fd writes.
     class WriteFlow : public WriteFlowBase
     {
@@ -371,6 +405,7 @@ protected:
             if (device()->fd() < 0) {
                 return this->release_and_exit();
             }
+            this->record_queue_latency();
             return this->write_repeated(&selectHelper_, device()->fd(),
                 this->message()->data()->data(),
                 this->message()->data()->size(), STATE(write_done),
@@ -386,13 +421,60 @@ protected:
             return this->release_and_exit();
         }
 
+    protected:
+        void overflow_disconnect() OVERRIDE
+        {
+            device()->overflow_disconnect();
+        }
+
     private:
         /// Helper class for asynchronous writes.
         StateFlowBase::StateFlowSelectHelper selectHelper_{this};
     };
 
+    /// Closes the device when the write queue overflowed under
+    /// HubPortOverflow::DISCONNECT.
+    class Disconnector : public Executable
+    {
+    public:
+        /// Constructor. @param device is the parent object.
+        Disconnector(HubDeviceSelect *device)
+            : device_(device)
+        {
+        }
+
+        void run() OVERRIDE
+        {
+            device_->close_on_overflow();
+        }
+
+    private:
+        /// Parent object.
+        HubDeviceSelect *device_;
+    };
+
 protected:
     friend class ReadFlow;  // for notifying barrier_
+    friend class Disconnector;
+
+    /** Closes the device because a consumer does not keep up with the
+     * data. Same as a write error, except that the write flow may be waiting
+     * for the fd to become writable. */
+    void close_on_overflow()
+    {
+        if (fd_ < 0)
+        {
+            // Closed meanwhile due to an error.
+            return;
+        }
+        LOG(INFO, "Closing fd %d: output queue overflow.", fd_);
+        readFlow_.shutdown();
+        unregister_write_port();
+        int fd = fd_;
+        fd_ = -1;
+        writeFlow_.shutdown();
+        ::close(fd);
+    }
 
     /** The assumption here is that the write flow still has entries in its
      * queue that need to be removed. */
@@ -427,6 +509,11 @@ protected:
     /// StateFlow for writing data to the fd. Woken by data to send or the fd
     /// being writeable.
     WriteFlow writeFlow_;
+    /// Scheduled when the write queue overflows under
+    /// HubPortOverflow::DISCONNECT.
+    Disconnector disconnector_;
+    /// True if disconnector_ was already scheduled.
+    bool disconnectScheduled_ {false};
 };
 
 #endif // _UTILS_HUBDEVICESELECT_HXX_
@@ -0,0 +1,208 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file HubPortLimit.cxx
+ *
+ * Bounded output queues for hub ports.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "utils/HubPortLimit.hxx"
+
+#include <string>
+
+#include "utils/macros.h"
+
+/// Upper bounds of the queue latency buckets in microseconds.
+static const uint32_t QUEUE_LATENCY_BOUNDS_USEC[] = {100, 200, 500, 1000,
+    2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000,
+    2000000, 5000000};
+
+HubPortStats::HubPortStats()
+    : queueLatency_(
+          QUEUE_LATENCY_BOUNDS_USEC, ARRAYSIZE(QUEUE_LATENCY_BOUNDS_USEC))
+{
+}
+
+HubPortStats::~HubPortStats()
+{
+    if (METRICS_ENABLED)
+    {
+        MetricsRegistry::instance()->remove(this);
+    }
+}
+
+void HubPortStats::register_metrics(const char *prefix)
+{
+    MetricsRegistry *r = MetricsRegistry::instance();
+    std::string p(prefix);
+    r->add(this, p + ".dropped", &dropped_);
+    r->add(this, p + ".disconnects", &disconnects_);
+    r->add(this, p + ".queue_usec", &queueLatency_);
+}
+
+/// @return the value of a hex digit, or -1 if c is not one. @param c is the
+/// character.
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+uint32_t hub_data_priority(const HubData &d)
+{
+    uint32_t best = UINT32_MAX;
+    const char *s = d.data();
+    size_t len = d.size();
+    for (size_t i = 0; i + 2 < len; ++i)
+    {
+        // Frames look like :X1234ABCDN...; or :S123N...;
+        if (s[i] != ':' || (s[i + 1] != 'X' && s[i + 1] != 'S'))
+        {
+            continue;
+        }
+        bool eff = s[i + 1] == 'X';
+        unsigned max_digits = eff ? 8 : 3;
+        uint32_t id = 0;
+        unsigned n = 0;
+        for (size_t j = i + 2; j < len && n < max_digits; ++j, ++n)
+        {
+            int v = hex_value(s[j]);
+            if (v < 0)
+            {
+                break;
+            }
+            id = (id << 4) | v;
+        }
+        if (!n)
+        {
+            continue;
+        }
+        id = eff ? (id & 0x1FFFFFFF) : ((id & 0x7FF) << 18);
+        if (id < best)
+        {
+            best = id;
+        }
+    }
+    return best;
+}
+
+void HubPortLimiter::set_limits(const HubPortLimits &limits)
+{
+    HASSERT(limits.policy == HubPortOverflow::UNLIMITED ||
+        (limits.highWatermark > 0 &&
+            limits.lowWatermark < limits.highWatermark));
+    limits_ = limits;
+    congested_ = 0;
+}
+
+HubPortLimiter::Decision HubPortLimiter::admit(unsigned queued)
+{
+    if (closed_)
+    {
+        if (limits_.stats)
+        {
+            limits_.stats->count_dropped(1);
+        }
+        return DROP;
+    }
+    switch (limits_.policy)
+    {
+        case HubPortOverflow::UNLIMITED:
+            return ENQUEUE;
+        case HubPortOverflow::DROP_OLDEST:
+            if (queued < limits_.highWatermark)
+            {
+                return ENQUEUE;
+            }
+            if (limits_.stats)
+            {
+                limits_.stats->count_dropped(evict_count(queued));
+            }
+            return EVICT;
+        case HubPortOverflow::DROP_BY_PRIORITY:
+            if (queued >= limits_.highWatermark)
+            {
+                congested_ = 1;
+            }
+            else if (queued <= limits_.lowWatermark)
+            {
+                congested_ = 0;
+            }
+            if (!congested_)
+            {
+                return ENQUEUE;
+            }
+            if (queued < 2 * limits_.highWatermark)
+            {
+                return CHECK_PRIORITY;
+            }
+            break;
+        case HubPortOverflow::DISCONNECT:
+            if (queued < limits_.highWatermark)
+            {
+                return ENQUEUE;
+            }
+            closed_ = 1;
+            if (limits_.stats)
+            {
+                limits_.stats->count_disconnect();
+                limits_.stats->count_dropped(1);
+            }
+            return DISCONNECT;
+    }
+    if (limits_.stats)
+    {
+        limits_.stats->count_dropped(1);
+    }
+    return DROP;
+}
+
+HubPortLimiter::Decision HubPortLimiter::admit_priority(uint32_t priority)
+{
+    if (priority < limits_.priorityLimit)
+    {
+        return ENQUEUE;
+    }
+    if (limits_.stats)
+    {
+        limits_.stats->count_dropped(1);
+    }
+    return DROP;
+}
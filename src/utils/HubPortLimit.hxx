@@ -0,0 +1,389 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file HubPortLimit.hxx
+ *
+ * Bounded output queues for hub ports.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _UTILS_HUBPORTLIMIT_HXX_
+#define _UTILS_HUBPORTLIMIT_HXX_
+
+#include <stdint.h>
+
+#include "executor/StateFlow.hxx"
+#include "utils/Atomic.hxx"
+#include "utils/BufferLatency.hxx"
+#include "utils/Hub.hxx"
+#include "utils/Metrics.hxx"
+#include "utils/SimpleQueue.hxx"
+
+/// What a hub port does when its output queue reaches the high watermark.
+enum class HubPortOverflow : uint8_t
+{
+    /// The queue is not limited.
+    UNLIMITED,
+    /// Discards the oldest queued messages until the queue is down to the
+    /// low watermark.
+    DROP_OLDEST,
+    /// Discards the incoming messages of low priority (see
+    /// HubPortLimits::priorityLimit) until the queue drains to the low
+    /// watermark. At twice the high watermark all incoming messages are
+    /// discarded.
+    DROP_BY_PRIORITY,
+    /// Closes the port.
+    DISCONNECT,
+};
+
+/// Drop and queue latency counters of limited hub ports. One object may be
+/// shared by any number of ports, e.g. all the clients of a TCP hub.
+class HubPortStats : private Atomic
+{
+public:
+    HubPortStats();
+    ~HubPortStats();
+
+    /// Exports the counters into the MetricsRegistry as "<prefix>.dropped",
+    /// "<prefix>.disconnects" and "<prefix>.queue_usec".
+    /// @param prefix is prepended to the metric names, e.g. "hub.tcp".
+    void register_metrics(const char *prefix);
+
+    /// Counts discarded messages. @param n is how many.
+    void count_dropped(unsigned n)
+    {
+        AtomicHolder h(this);
+        dropped_.inc(n);
+    }
+
+    /// Counts a port closed due to overflow.
+    void count_disconnect()
+    {
+        AtomicHolder h(this);
+        disconnects_.inc();
+    }
+
+    /// Records how long a message was waiting in a port queue. @param usec
+    /// is the time in microseconds.
+    void record_queue_latency(uint32_t usec)
+    {
+        AtomicHolder h(this);
+        queueLatency_.add(usec);
+    }
+
+    /// @return the number of discarded messages. For GridConnect ports a
+    /// message is a batch of frames.
+    int64_t dropped()
+    {
+        return dropped_.value();
+    }
+
+    /// @return the number of ports closed due to overflow.
+    int64_t disconnects()
+    {
+        return disconnects_.value();
+    }
+
+    /// @return the distribution of the time messages spent in the port
+    /// queues, in microseconds. Stays empty in builds without
+    /// BUFFER_TIMESTAMPS.
+    HistogramMetric *queue_latency()
+    {
+        return &queueLatency_;
+    }
+
+private:
+    /// Discarded messages.
+    CounterMetric dropped_;
+    /// Ports closed due to overflow.
+    CounterMetric disconnects_;
+    /// Time spent in the queue, usec.
+    HistogramMetric queueLatency_;
+
+    DISALLOW_COPY_AND_ASSIGN(HubPortStats);
+};
+
+/// Output queue limits of a hub port.
+struct HubPortLimits
+{
+    /// Keeps OpenLCB CAN control frames (alias allocation) and standard
+    /// frames under DROP_BY_PRIORITY.
+    static const uint32_t DEFAULT_PRIORITY_LIMIT = 0x18000000;
+
+    /// Constructor. The default is an unlimited queue.
+    /// @param p is the overflow policy.
+    /// @param high is the high watermark, must be positive for a limited
+    /// queue.
+    /// @param low is the low watermark, must be below high.
+    /// @param s is where to count the drops; may be null.
+    HubPortLimits(HubPortOverflow p = HubPortOverflow::UNLIMITED,
+        unsigned high = 0, unsigned low = 0, HubPortStats *s = nullptr)
+        : policy(p)
+        , highWatermark(high)
+        , lowWatermark(low)
+        , priorityLimit(DEFAULT_PRIORITY_LIMIT)
+        , stats(s)
+    {
+    }
+
+    /// What happens when the queue reaches highWatermark.
+    HubPortOverflow policy;
+    /// Number of queued messages at which the port counts as congested.
+    unsigned highWatermark;
+    /// Number of queued messages at which the port is not congested
+    /// anymore.
+    unsigned lowWatermark;
+    /// Under DROP_BY_PRIORITY, messages with a priority (see
+    /// hub_data_priority) below this value are still queued while
+    /// congested.
+    uint32_t priorityLimit;
+    /// Counters to update. If set, the queue latency is measured too.
+    HubPortStats *stats;
+};
+
+/// @return the priority of a hub message for DROP_BY_PRIORITY; lower values
+/// are more important. Generic version for data without a priority.
+template <class T> uint32_t hub_data_priority(const T &)
+{
+    return UINT32_MAX;
+}
+
+/// @return the priority of a CAN frame: the identifier as it arbitrates on
+/// the bus, standard frames aligned to the top of the extended identifiers.
+/// @param d is the frame.
+inline uint32_t hub_data_priority(const CanHubData &d)
+{
+    const struct can_frame &f = d.frame();
+    if (IS_CAN_FRAME_EFF(f))
+    {
+        return GET_CAN_FRAME_ID_EFF(f);
+    }
+    return GET_CAN_FRAME_ID(f) << 18;
+}
+
+/// @return the highest priority (as for CAN frames) of the GridConnect
+/// frames in a string; UINT32_MAX if there are none, for example in other
+/// stream formats. @param d is the data.
+uint32_t hub_data_priority(const HubData &d);
+
+/// Template-independent part of LimitedHubPortFlow: decides what to do with
+/// an incoming message. All calls must hold the lock of the port flow.
+class HubPortLimiter
+{
+public:
+    /// What to do with an incoming message.
+    enum Decision
+    {
+        /// Queue it.
+        ENQUEUE,
+        /// Call admit_priority to decide.
+        CHECK_PRIORITY,
+        /// Discard it.
+        DROP,
+        /// Discard evict_count() messages from the head of the queue, then
+        /// queue it.
+        EVICT,
+        /// Discard it and close the port.
+        DISCONNECT
+    };
+
+    HubPortLimiter()
+        : congested_(0)
+        , closed_(0)
+    {
+    }
+
+    /// Changes the limits. @param limits is the new configuration.
+    void set_limits(const HubPortLimits &limits);
+
+    /// @return the stats object to update, or null.
+    HubPortStats *stats()
+    {
+        return limits_.stats;
+    }
+
+    /// Decides about an incoming message. @param queued is the current
+    /// queue length. @return what to do.
+    Decision admit(unsigned queued);
+
+    /// Decides about an incoming message on a congested DROP_BY_PRIORITY
+    /// port. @param priority is the priority of the message. @return ENQUEUE
+    /// or DROP.
+    Decision admit_priority(uint32_t priority);
+
+    /// @return how many messages to discard for an EVICT decision. @param
+    /// queued is the current queue length.
+    unsigned evict_count(unsigned queued)
+    {
+        return queued - limits_.lowWatermark;
+    }
+
+    /// Stops accepting new messages.
+    void close()
+    {
+        closed_ = 1;
+    }
+
+    /// @return true if new messages are not accepted anymore.
+    bool closed()
+    {
+        return closed_;
+    }
+
+private:
+    /// Current configuration.
+    HubPortLimits limits_;
+    /// 1 if the queue was above the high watermark and did not yet drain to
+    /// the low watermark.
+    unsigned congested_ : 1;
+    /// 1 if new messages are dropped.
+    unsigned closed_ : 1;
+};
+
+/// Base class for the write flows of hub ports, with an output queue bounded
+/// by HubPortLimits. Without limits it behaves like a plain
+/// StateFlow<MessageType, QList<1>>. Since the hub clones every message for
+/// every port, each port owns the buffers in its queue.
+template <class MessageType>
+class LimitedHubPortFlow : public StateFlow<MessageType, QList<1>>
+{
+public:
+    /// Base class type.
+    typedef StateFlow<MessageType, QList<1>> Base;
+
+    /// Constructor. @param service defines the executor to run on.
+    LimitedHubPortFlow(Service *service)
+        : Base(service)
+    {
+    }
+
+    /// Changes the queue limits. @param limits is the new configuration.
+    void set_limits(const HubPortLimits &limits)
+    {
+        AtomicHolder h(this);
+        limiter_.set_limits(limits);
+    }
+
+    /// Queues a message unless the limits say otherwise. @param msg is the
+    /// message, @param priority is ignored by the queue.
+    void send(MessageType *msg, unsigned priority = UINT_MAX) OVERRIDE
+    {
+        HubPortLimiter::Decision d;
+        // Evicted buffers are released outside of the lock, because unref
+        // may run the buffer's done notifiable.
+        TypedQueue<MessageType> victims;
+        {
+            AtomicHolder h(this);
+            d = limiter_.admit(this->queue_size());
+            if (d == HubPortLimiter::CHECK_PRIORITY)
+            {
+                d = limiter_.admit_priority(hub_data_priority(*msg->data()));
+            }
+            if (d == HubPortLimiter::EVICT)
+            {
+                for (unsigned n = limiter_.evict_count(this->queue_size());
+                     n > 0; --n)
+                {
+                    unsigned p;
+                    auto *b = static_cast<MessageType *>(this->queue_next(&p));
+                    if (!b)
+                    {
+                        break;
+                    }
+                    victims.push_front(b);
+                }
+                d = HubPortLimiter::ENQUEUE;
+            }
+            if (d == HubPortLimiter::ENQUEUE)
+            {
+                if (BUFFER_TIMESTAMPS_ENABLED && METRICS_ENABLED &&
+                    limiter_.stats())
+                {
+                    // The port is the last stage of the message, so we can
+                    // reuse the timestamp.
+                    msg->set_timestamp(BufferLatency::now());
+                }
+                Base::send(msg, priority);
+                msg = nullptr;
+            }
+        }
+        while (!victims.empty())
+        {
+            victims.pop_front()->unref();
+        }
+        if (!msg)
+        {
+            return;
+        }
+        msg->unref();
+        if (d == HubPortLimiter::DISCONNECT)
+        {
+            overflow_disconnect();
+        }
+    }
+
+    /// Queues the last message of the port, bypassing the limits. Incoming
+    /// messages are discarded afterwards. Used for the barrier message at
+    /// unregistration, which must not be dropped. @param msg is the message.
+    void send_final(MessageType *msg)
+    {
+        AtomicHolder h(this);
+        limiter_.close();
+        Base::send(msg);
+    }
+
+    /// @return true if the port stopped accepting messages.
+    bool closed()
+    {
+        AtomicHolder h(this);
+        return limiter_.closed();
+    }
+
+protected:
+    /// Called (without the lock held, on the thread of the sender) when the
+    /// port has to be closed due to the DISCONNECT policy. Called at most
+    /// once.
+    virtual void overflow_disconnect() = 0;
+
+    /// Records the queue latency of the current message. Call from entry().
+    void record_queue_latency()
+    {
+        HubPortStats *s = limiter_.stats();
+        uint32_t ts = this->message()->timestamp();
+        if (BUFFER_TIMESTAMPS_ENABLED && METRICS_ENABLED && s && ts)
+        {
+            s->record_queue_latency(BufferLatency::now() - ts);
+        }
+    }
+
+private:
+    /// Decides what happens to the incoming messages.
+    HubPortLimiter limiter_;
+};
+
+#endif // _UTILS_HUBPORTLIMIT_HXX_
@@ -0,0 +1,206 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Metrics.cxx
+ *
+ * Registry of named counters, gauges and histograms for run-time telemetry.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "utils/Metrics.hxx"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "utils/StringPrintf.hxx"
+
+Metric::~Metric()
+{
+    HASSERT(!registered_);
+}
+
+void Metric::render(std::string *out)
+{
+    *out += StringPrintf("%s %s %" PRId64 "\n", name_.c_str(),
+        type_ == COUNTER ? "counter" : "gauge", value());
+}
+
+template <bool ENABLED>
+void HistogramMetricT<ENABLED>::render(std::string *out)
+{
+    *out += StringPrintf("%s histogram %" PRIu32 " %" PRIu64, name().c_str(),
+        count_, sum_);
+    for (unsigned i = 0; i <= numBounds_; ++i)
+    {
+        if (i < numBounds_)
+        {
+            *out += StringPrintf(" %" PRIu32 ":%" PRIu32, bounds_[i],
+                counts_[i]);
+        }
+        else
+        {
+            *out += StringPrintf(" inf:%" PRIu32, counts_[i]);
+        }
+    }
+    out->push_back('\n');
+}
+
+template <bool ENABLED>
+uint32_t HistogramMetricT<ENABLED>::percentile(unsigned pct)
+{
+    if (!count_)
+    {
+        return 0;
+    }
+    uint64_t rank = ((uint64_t)count_ * pct + 99) / 100;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < numBounds_; ++i)
+    {
+        seen += counts_[i];
+        if (seen >= rank)
+        {
+            return bounds_[i];
+        }
+    }
+    return UINT32_MAX;
+}
+
+template class HistogramMetricT<true>;
+
+MetricsRegistry::MetricsRegistry()
+    : head_(nullptr)
+    , tail_(&head_)
+{
+}
+
+MetricsRegistry *MetricsRegistry::instance()
+{
+    // Intentionally leaked so that static destructors can still unregister.
+    static MetricsRegistry *r = new MetricsRegistry();
+    return r;
+}
+
+void MetricsRegistry::add(const void *owner, const std::string &name,
+    Metric *m)
+{
+    HASSERT(!m->registered_);
+    m->name_ = name;
+    m->owner_ = owner;
+    m->next_ = nullptr;
+    m->registered_ = true;
+    OSMutexLock h(&lock_);
+    *tail_ = m;
+    tail_ = &m->next_;
+}
+
+void MetricsRegistry::add_gauge(const void *owner, const std::string &name,
+    GaugeMetric::Callback cb)
+{
+    if (!METRICS_ENABLED)
+    {
+        return;
+    }
+    GaugeMetric *g = new GaugeMetric(std::move(cb));
+    g->ownedByRegistry_ = true;
+    add(owner, name, g);
+}
+
+void MetricsRegistry::remove(const void *owner)
+{
+    Metric *to_delete = nullptr;
+    {
+        OSMutexLock h(&lock_);
+        Metric **p = &head_;
+        tail_ = &head_;
+        while (*p)
+        {
+            Metric *m = *p;
+            if (m->owner_ != owner)
+            {
+                p = &m->next_;
+                tail_ = p;
+                continue;
+            }
+            *p = m->next_;
+            m->registered_ = false;
+            if (m->ownedByRegistry_)
+            {
+                m->next_ = to_delete;
+                to_delete = m;
+            }
+            else
+            {
+                m->next_ = nullptr;
+            }
+        }
+    }
+    while (to_delete)
+    {
+        Metric *m = to_delete;
+        to_delete = m->next_;
+        delete m;
+    }
+}
+
+void MetricsRegistry::render(std::string *out, const char *prefix)
+{
+    size_t prefix_len = prefix ? strlen(prefix) : 0;
+    OSMutexLock h(&lock_);
+    for (Metric *m = head_; m; m = m->next_)
+    {
+        if (prefix_len && m->name_.compare(0, prefix_len, prefix) != 0)
+        {
+            continue;
+        }
+        m->render(out);
+    }
+}
+
+int64_t MetricsRegistry::get(const std::string &name)
+{
+    OSMutexLock h(&lock_);
+    for (Metric *m = head_; m; m = m->next_)
+    {
+        if (m->name_ == name)
+        {
+            return m->value();
+        }
+    }
+    return -1;
+}
+
+size_t MetricsRegistry::size()
+{
+    OSMutexLock h(&lock_);
+    size_t ret = 0;
+    for (Metric *m = head_; m; m = m->next_)
+    {
+        ++ret;
+    }
+    return ret;
+}
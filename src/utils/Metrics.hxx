@@ -0,0 +1,383 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Metrics.hxx
+ *
+ * Registry of named counters, gauges and histograms for run-time telemetry.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _UTILS_METRICS_HXX_
+#define _UTILS_METRICS_HXX_
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+#include "os/OS.hxx"
+#include "utils/macros.h"
+
+/// Compile-time switch for the metrics. Host builds have them on by default;
+/// define DISABLE_METRICS to turn them off. Embedded targets have to define
+/// ENABLE_METRICS to get them. When off, every counter and histogram update
+/// and all registrations are compiled out, and the metric objects become
+/// empty classes.
+#if defined(DISABLE_METRICS)
+static constexpr bool METRICS_ENABLED = false;
+#elif defined(ENABLE_METRICS) || defined(__linux__) || defined(__MACH__) ||   \
+    defined(__EMSCRIPTEN__) || defined(__WINNT__)
+static constexpr bool METRICS_ENABLED = true;
+#else
+static constexpr bool METRICS_ENABLED = false;
+#endif
+
+class MetricsRegistry;
+
+/// Base class of every registered metric. A metric has a name, a type and an
+/// owner. The owner is an opaque pointer used to unregister all metrics of a
+/// component at once.
+class Metric
+{
+public:
+    /// What kind of value this metric exports.
+    enum Type
+    {
+        /// Monotonically increasing count of events.
+        COUNTER,
+        /// Instantaneous value, such as a queue depth.
+        GAUGE,
+        /// Distribution of values in fixed buckets.
+        HISTOGRAM,
+    };
+
+    virtual ~Metric();
+
+    /// @return the name under which this metric was registered.
+    const std::string &name()
+    {
+        return name_;
+    }
+
+    /// @return the type of this metric.
+    Type type()
+    {
+        return type_;
+    }
+
+    /// @return the current value of a counter or gauge; the number of samples
+    /// of a histogram.
+    virtual int64_t value() = 0;
+
+    /// Appends the textual representation of this metric to a string. The
+    /// format is one line per metric: "name type value".
+    /// @param out where to append.
+    virtual void render(std::string *out);
+
+protected:
+    /// Constructor. @param type is the metric type.
+    Metric(Type type)
+        : type_(type)
+    {
+    }
+
+private:
+    friend class MetricsRegistry;
+
+    /// Registered name.
+    std::string name_;
+    /// Owner component, used for unregistering.
+    const void *owner_ {nullptr};
+    /// Next metric in the registry's list.
+    Metric *next_ {nullptr};
+    /// Metric type.
+    Type type_;
+    /// True if the registry deletes this metric when unregistering.
+    bool ownedByRegistry_ {false};
+    /// True while this metric is in the registry.
+    bool registered_ {false};
+};
+
+/// Empty base class for metrics that were compiled out (see METRICS_ENABLED).
+class DisabledMetric
+{
+};
+
+/// A counter. Increments are not synchronized: a counter should be
+/// incremented from a single thread (typically an executor).
+template <bool ENABLED> class CounterMetricT : public Metric
+{
+public:
+    CounterMetricT()
+        : Metric(COUNTER)
+    {
+    }
+
+    /// Adds to the counter. @param n is the value to add.
+    void inc(uint32_t n = 1)
+    {
+        count_ += n;
+    }
+
+    int64_t value() override
+    {
+        return count_;
+    }
+
+private:
+    /// Current count.
+    uint64_t count_ {0};
+};
+
+/// Compiled-out version of the counter.
+template <> class CounterMetricT<false> : public DisabledMetric
+{
+public:
+    /// Does nothing. @param n ignored.
+    void inc(uint32_t n = 1)
+    {
+    }
+
+    /// @return zero.
+    int64_t value()
+    {
+        return 0;
+    }
+};
+
+/// Counter type used by the components; compiled out when metrics are
+/// disabled.
+typedef CounterMetricT<METRICS_ENABLED> CounterMetric;
+
+/// A histogram with a fixed bucket layout. Sample v falls into the first
+/// bucket i with v <= bounds[i], or into the overflow bucket.
+template <bool ENABLED> class HistogramMetricT : public Metric
+{
+public:
+    /// Constructor.
+    /// @param bounds ascending upper bounds of the buckets. Must stay alive
+    /// as long as *this.
+    /// @param num_bounds number of entries in bounds.
+    HistogramMetricT(const uint32_t *bounds, unsigned num_bounds)
+        : Metric(HISTOGRAM)
+        , bounds_(bounds)
+        , numBounds_(num_bounds)
+        , counts_(new uint32_t[num_bounds + 1]())
+    {
+    }
+
+    ~HistogramMetricT()
+    {
+        delete[] counts_;
+    }
+
+    /// Adds a sample. @param v is the sample value.
+    void add(uint32_t v)
+    {
+        unsigned i = 0;
+        while (i < numBounds_ && v > bounds_[i])
+        {
+            ++i;
+        }
+        ++counts_[i];
+        ++count_;
+        sum_ += v;
+    }
+
+    int64_t value() override
+    {
+        return count_;
+    }
+
+    /// @return sum of all samples.
+    uint64_t sum()
+    {
+        return sum_;
+    }
+
+    /// @return number of buckets, including the overflow bucket.
+    unsigned num_buckets()
+    {
+        return numBounds_ + 1;
+    }
+
+    /// @return the number of samples in a bucket.
+    /// @param i bucket index, 0 <= i < num_buckets().
+    uint32_t bucket(unsigned i)
+    {
+        return counts_[i];
+    }
+
+    /// @return the upper bound of a bucket, UINT32_MAX for the overflow
+    /// bucket. @param i bucket index.
+    uint32_t bucket_bound(unsigned i)
+    {
+        return i < numBounds_ ? bounds_[i] : UINT32_MAX;
+    }
+
+    /// Estimates a percentile of the samples.
+    /// @param pct is the percentile to compute, 0..100.
+    /// @return the upper bound of the bucket holding the requested sample;
+    /// UINT32_MAX if it is in the overflow bucket, 0 if there are no samples.
+    uint32_t percentile(unsigned pct);
+
+    /// Appends "name histogram count sum b0:c0 b1:c1 ... inf:cN".
+    /// @param out where to append.
+    void render(std::string *out) override;
+
+private:
+    /// Upper bounds of the buckets.
+    const uint32_t *bounds_;
+    /// Number of entries in bounds_.
+    unsigned numBounds_;
+    /// Sample counts per bucket; numBounds_ + 1 entries.
+    uint32_t *counts_;
+    /// Total number of samples.
+    uint32_t count_ {0};
+    /// Sum of all samples.
+    uint64_t sum_ {0};
+
+    DISALLOW_COPY_AND_ASSIGN(HistogramMetricT);
+};
+
+/// Compiled-out version of the histogram.
+template <> class HistogramMetricT<false> : public DisabledMetric
+{
+public:
+    /// Constructor. Arguments are ignored.
+    HistogramMetricT(const uint32_t *, unsigned)
+    {
+    }
+
+    /// Does nothing.
+    void add(uint32_t)
+    {
+    }
+
+    /// @return zero.
+    int64_t value()
+    {
+        return 0;
+    }
+
+    /// @return zero.
+    uint32_t percentile(unsigned)
+    {
+        return 0;
+    }
+};
+
+/// Histogram type used by the components; compiled out when metrics are
+/// disabled.
+typedef HistogramMetricT<METRICS_ENABLED> HistogramMetric;
+
+/// A gauge whose value is computed by a callback when the metric is read. The
+/// callback runs on the thread querying the metrics, so it should only read
+/// word-sized values.
+class GaugeMetric : public Metric
+{
+public:
+    /// Callback type computing the value of the gauge.
+    typedef std::function<int64_t()> Callback;
+
+    /// @param cb computes the value of the gauge.
+    GaugeMetric(Callback cb)
+        : Metric(GAUGE)
+        , callback_(std::move(cb))
+    {
+    }
+
+    int64_t value() override
+    {
+        return callback_();
+    }
+
+private:
+    /// Computes the current value.
+    Callback callback_;
+};
+
+/// Global list of metrics. Components register their counters and histograms
+/// (which they own) and gauges (which the registry owns) under an owner
+/// pointer, and unregister them with remove() before they are destroyed.
+class MetricsRegistry
+{
+public:
+    /// @return the singleton registry. It is never destroyed, so components
+    /// may unregister from static destructors.
+    static MetricsRegistry *instance();
+
+    /// Registers a metric owned by the caller.
+    /// @param owner component owning the metric
+    /// @param name name of the metric
+    /// @param m the metric. Must stay alive until remove(owner) is called.
+    void add(const void *owner, const std::string &name, Metric *m);
+
+    /// Compiled-out metrics are not registered.
+    void add(const void *, const std::string &, DisabledMetric *)
+    {
+    }
+
+    /// Creates and registers a gauge.
+    /// @param owner component owning the metric
+    /// @param name name of the metric
+    /// @param cb computes the value of the gauge.
+    void add_gauge(const void *owner, const std::string &name,
+        GaugeMetric::Callback cb);
+
+    /// Unregisters all metrics of an owner. Gauges are deleted.
+    /// @param owner component whose metrics to remove.
+    void remove(const void *owner);
+
+    /// Renders all metrics whose name starts with a given prefix, one line
+    /// per metric, in order of registration.
+    /// @param out where to append the output
+    /// @param prefix filter for the metric names; nullptr for all.
+    void render(std::string *out, const char *prefix = nullptr);
+
+    /// @return the current value of a metric, or -1 if not found.
+    /// @param name exact name of the metric.
+    int64_t get(const std::string &name);
+
+    /// @return the number of registered metrics.
+    size_t size();
+
+private:
+    MetricsRegistry();
+
+    /// Protects the list.
+    OSMutex lock_;
+    /// Head of the list of metrics.
+    Metric *head_;
+    /// Last entry of the list; new metrics are appended here.
+    Metric **tail_;
+};
+
+/// The enabled histogram is instantiated in Metrics.cxx.
+extern template class HistogramMetricT<true>;
+
+#endif // _UTILS_METRICS_HXX_
@@ -0,0 +1,347 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file PairCompress.cxx
+ *
+ * Byte pair compression for read-only text blobs (such as the CDI xml) that
+ * need to be stored in flash and served at arbitrary offsets.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "utils/PairCompress.hxx"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+/// Maximum nesting of pair codes. Bounds the recursion in the decoder.
+static const unsigned MAX_PAIR_DEPTH = 16;
+/// Maximum number of bytes a single pair code may expand to.
+static const unsigned MAX_PAIR_LENGTH = 255;
+/// Token values at or above this are escaped literals in the compressor.
+static const unsigned ESCAPED = 0x100;
+
+/// Appends a 32-bit little endian value to a string.
+void append_le32(std::string *s, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        s->push_back(v & 0xff);
+        v >>= 8;
+    }
+}
+
+/// @return the 32-bit little endian value at p.
+uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+} // namespace
+
+constexpr uint8_t PairDecompressor::ESCAPE;
+constexpr uint8_t PairDecompressor::FIRST_PAIR;
+constexpr unsigned PairDecompressor::MAX_PAIRS;
+constexpr unsigned PairDecompressor::HEADER_SIZE;
+
+void pair_compress(
+    const std::string &input, std::string *output, unsigned index_stride)
+{
+    const unsigned first_pair = PairDecompressor::FIRST_PAIR;
+    // Token stream. Values below ESCAPED are codes that may be paired up,
+    // values at or above are literals that need escaping.
+    std::vector<unsigned> tokens;
+    tokens.reserve(input.size());
+    for (char c : input)
+    {
+        uint8_t b = c;
+        tokens.push_back(b < first_pair ? b : ESCAPED | b);
+    }
+    // Two entries per pair code.
+    std::vector<uint8_t> pairs;
+    std::vector<uint8_t> lengths;
+    std::vector<uint8_t> depths;
+    auto length_of = [&lengths](unsigned t) -> unsigned {
+        return (t >= first_pair && t < ESCAPED) ? lengths[t - first_pair] : 1;
+    };
+    auto depth_of = [&depths](unsigned t) -> unsigned {
+        return (t >= first_pair && t < ESCAPED) ? depths[t - first_pair] : 0;
+    };
+
+    std::vector<unsigned> counts(65536);
+    while (lengths.size() < PairDecompressor::MAX_PAIRS)
+    {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i + 1 < tokens.size(); ++i)
+        {
+            unsigned a = tokens[i];
+            unsigned b = tokens[i + 1];
+            if (a >= ESCAPED || b >= ESCAPED)
+            {
+                continue;
+            }
+            if (length_of(a) + length_of(b) > MAX_PAIR_LENGTH ||
+                std::max(depth_of(a), depth_of(b)) + 1 > MAX_PAIR_DEPTH)
+            {
+                continue;
+            }
+            ++counts[(a << 8) | b];
+            if (a == b && i + 2 < tokens.size() && tokens[i + 2] == a)
+            {
+                // Overlapping occurrences in a run cannot all be replaced.
+                ++i;
+            }
+        }
+        unsigned best = 0;
+        for (unsigned k = 1; k < counts.size(); ++k)
+        {
+            if (counts[k] > counts[best])
+            {
+                best = k;
+            }
+        }
+        // Every pair code costs three bytes in the tables.
+        if (counts[best] <= 3)
+        {
+            break;
+        }
+        unsigned a = best >> 8;
+        unsigned b = best & 0xff;
+        unsigned code = first_pair + lengths.size();
+        pairs.push_back(a);
+        pairs.push_back(b);
+        lengths.push_back(length_of(a) + length_of(b));
+        depths.push_back(std::max(depth_of(a), depth_of(b)) + 1);
+        size_t dst = 0;
+        for (size_t i = 0; i < tokens.size(); ++i)
+        {
+            if (i + 1 < tokens.size() && tokens[i] == a && tokens[i + 1] == b)
+            {
+                tokens[dst++] = code;
+                ++i;
+            }
+            else
+            {
+                tokens[dst++] = tokens[i];
+            }
+        }
+        tokens.resize(dst);
+    }
+
+    std::string body;
+    std::string index;
+    uint32_t num_index = 0;
+    size_t next_mark = 0;
+    uint32_t uofs = 0;
+    for (unsigned t : tokens)
+    {
+        if (body.size() >= next_mark)
+        {
+            append_le32(&index, body.size());
+            append_le32(&index, uofs);
+            ++num_index;
+            next_mark = body.size() + index_stride;
+        }
+        if (t >= ESCAPED)
+        {
+            body.push_back(PairDecompressor::ESCAPE);
+            body.push_back(t & 0xff);
+        }
+        else
+        {
+            body.push_back(t);
+        }
+        uofs += length_of(t);
+    }
+
+    output->clear();
+    output->push_back('P');
+    output->push_back('Z');
+    output->push_back(lengths.size());
+    output->push_back(0);
+    append_le32(output, input.size());
+    append_le32(output, body.size());
+    append_le32(output, num_index);
+    output->append(pairs.begin(), pairs.end());
+    output->append(lengths.begin(), lengths.end());
+    output->append(index);
+    output->append(body);
+}
+
+PairDecompressor::PairDecompressor(const uint8_t *data, size_t len)
+{
+    if (len < HEADER_SIZE || data[0] != 'P' || data[1] != 'Z')
+    {
+        return;
+    }
+    unsigned num_pairs = data[2];
+    size_t usize = get_le32(data + 4);
+    size_t csize = get_le32(data + 8);
+    size_t isize = get_le32(data + 12);
+    if (num_pairs > MAX_PAIRS ||
+        HEADER_SIZE + num_pairs * 3 + isize * 8 + csize != len)
+    {
+        return;
+    }
+    const uint8_t *pairs = data + HEADER_SIZE;
+    // Pairs may only refer to literals or earlier pairs. This bounds the
+    // recursion in expand().
+    for (unsigned i = 0; i < num_pairs * 2; ++i)
+    {
+        if (pairs[i] >= FIRST_PAIR + i / 2)
+        {
+            return;
+        }
+    }
+    pairs_ = pairs;
+    lengths_ = pairs_ + num_pairs * 2;
+    index_ = lengths_ + num_pairs;
+    body_ = index_ + isize * 8;
+    bodySize_ = csize;
+    indexSize_ = isize;
+    uncompressedSize_ = usize;
+}
+
+unsigned PairDecompressor::expand(
+    uint8_t code, unsigned skip, uint8_t *dst, unsigned len)
+{
+    if (!len)
+    {
+        return 0;
+    }
+    if (code < FIRST_PAIR)
+    {
+        *dst = code;
+        return 1;
+    }
+    const uint8_t *p = pairs_ + (code - FIRST_PAIR) * 2;
+    unsigned left_len = code_length(p[0]);
+    unsigned written = 0;
+    if (skip < left_len)
+    {
+        written = expand(p[0], skip, dst, len);
+        skip = 0;
+    }
+    else
+    {
+        skip -= left_len;
+    }
+    if (written < len)
+    {
+        written += expand(p[1], skip, dst + written, len - written);
+    }
+    return written;
+}
+
+void PairDecompressor::seek(size_t offset)
+{
+    // Finds the last index entry at or before offset.
+    size_t lo = 0;
+    size_t hi = indexSize_;
+    while (hi - lo > 1)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (get_le32(index_ + mid * 8 + 4) <= offset)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    size_t cofs = 0;
+    size_t uofs = 0;
+    if (indexSize_)
+    {
+        cofs = get_le32(index_ + lo * 8);
+        uofs = get_le32(index_ + lo * 8 + 4);
+    }
+    if (uOfs_ > offset || uOfs_ < uofs)
+    {
+        // The cursor is not usable, start from the index entry.
+        cOfs_ = cofs;
+        uOfs_ = uofs;
+    }
+    while (cOfs_ < bodySize_)
+    {
+        uint8_t code = body_[cOfs_];
+        unsigned len = code == ESCAPE ? 1 : code_length(code);
+        if (uOfs_ + len > offset)
+        {
+            return;
+        }
+        uOfs_ += len;
+        cOfs_ += code == ESCAPE ? 2 : 1;
+    }
+}
+
+size_t PairDecompressor::read(size_t offset, uint8_t *dst, size_t len)
+{
+    if (!body_ || offset >= uncompressedSize_)
+    {
+        return 0;
+    }
+    if (len > uncompressedSize_ - offset)
+    {
+        len = uncompressedSize_ - offset;
+    }
+    seek(offset);
+    unsigned skip = offset - uOfs_;
+    size_t written = 0;
+    while (written < len && cOfs_ < bodySize_)
+    {
+        uint8_t code = body_[cOfs_];
+        unsigned token_len;
+        unsigned count;
+        if (code == ESCAPE)
+        {
+            token_len = 1;
+            dst[written] = body_[cOfs_ + 1];
+            count = 1;
+        }
+        else
+        {
+            token_len = code_length(code);
+            count = expand(code, skip, dst + written, len - written);
+        }
+        written += count;
+        if (skip + count < token_len)
+        {
+            // Ran out of output space in the middle of the token. The cursor
+            // stays at the token start.
+            break;
+        }
+        skip = 0;
+        uOfs_ += token_len;
+        cOfs_ += code == ESCAPE ? 2 : 1;
+    }
+    return written;
+}
@@ -0,0 +1,157 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file PairCompress.hxx
+ *
+ * Byte pair compression for read-only text blobs (such as the CDI xml) that
+ * need to be stored in flash and served at arbitrary offsets.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _UTILS_PAIRCOMPRESS_HXX_
+#define _UTILS_PAIRCOMPRESS_HXX_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/// Compresses a blob of data using byte pair encoding. This is meant to run
+/// at build time (on the host); the decoder is @ref PairDecompressor.
+///
+/// Compressed format (all integers little endian):
+///
+/// - 2 bytes magic 'P' 'Z'
+/// - 1 byte N: number of pair codes. Pair codes are 0x80 .. 0x80 + N - 1.
+/// - 1 byte reserved (zero)
+/// - 4 bytes: uncompressed length
+/// - 4 bytes C: length of the compressed body
+/// - 4 bytes K: number of seek index entries
+/// - N * 2 bytes: the two codes each pair code expands to
+/// - N bytes: the expanded length of each pair code
+/// - K * 8 bytes: seek index: pairs of (compressed offset, uncompressed
+///   offset) for token boundaries roughly every index_stride compressed
+///   bytes.
+/// - C bytes: compressed body. Codes 0x00..0x7F are literals, pair codes
+///   expand recursively, 0xFF escapes the following byte as a literal.
+///
+/// @param input is the data to compress.
+/// @param output will be overwritten with the compressed blob.
+/// @param index_stride approximate distance (in compressed bytes) between the
+/// seek index entries. Smaller values make random access faster and the blob
+/// larger.
+void pair_compress(
+    const std::string &input, std::string *output, unsigned index_stride = 128);
+
+/// Decoder for a blob created by @ref pair_compress. Supports reading at
+/// arbitrary offsets; sequential reads resume from where the previous read
+/// stopped without having to consult the seek index. Uses no dynamic memory;
+/// the blob can be stored in flash.
+class PairDecompressor
+{
+public:
+    /// Constructor.
+    /// @param data is the compressed blob. Must stay alive so long as *this
+    /// is around.
+    /// @param len is the length of the compressed blob in bytes.
+    PairDecompressor(const uint8_t *data, size_t len);
+
+    /// @return true if the blob passed a header sanity check.
+    bool valid()
+    {
+        return body_ != nullptr;
+    }
+
+    /// @return the number of bytes in the uncompressed data.
+    size_t size()
+    {
+        return uncompressedSize_;
+    }
+
+    /// Decompresses a section of the data.
+    /// @param offset is the first uncompressed byte to return.
+    /// @param dst is where to write the data.
+    /// @param len is the maximum number of bytes to return.
+    /// @return number of bytes written to dst. Fewer than len only when the
+    /// end of the data was reached.
+    size_t read(size_t offset, uint8_t *dst, size_t len);
+
+    /// Code marking that the next byte is a literal.
+    static constexpr uint8_t ESCAPE = 0xFF;
+    /// Lowest code that represents a pair.
+    static constexpr uint8_t FIRST_PAIR = 0x80;
+    /// Maximum number of pair codes.
+    static constexpr unsigned MAX_PAIRS = ESCAPE - FIRST_PAIR;
+    /// Length of the fixed header in bytes.
+    static constexpr unsigned HEADER_SIZE = 16;
+
+private:
+    /// @return number of uncompressed bytes represented by a (non-escape)
+    /// code.
+    /// @param code is the code from the compressed body.
+    unsigned code_length(uint8_t code)
+    {
+        if (code < FIRST_PAIR)
+        {
+            return 1;
+        }
+        return lengths_[code - FIRST_PAIR];
+    }
+
+    /// Expands a code into the output buffer.
+    /// @param code is the code to expand.
+    /// @param skip how many bytes of the expansion to skip.
+    /// @param dst where to write the expansion.
+    /// @param len maximum number of bytes to write.
+    /// @return number of bytes written.
+    unsigned expand(uint8_t code, unsigned skip, uint8_t *dst, unsigned len);
+
+    /// Moves the cursor to the token containing the uncompressed offset.
+    /// @param offset is the target offset, must be < size().
+    void seek(size_t offset);
+
+    /// Pair table, two bytes per pair code.
+    const uint8_t *pairs_{nullptr};
+    /// Expanded lengths, one byte per pair code.
+    const uint8_t *lengths_{nullptr};
+    /// Seek index.
+    const uint8_t *index_{nullptr};
+    /// Compressed body.
+    const uint8_t *body_{nullptr};
+    /// Number of bytes in the compressed body.
+    size_t bodySize_{0};
+    /// Number of entries in the seek index.
+    size_t indexSize_{0};
+    /// Number of bytes in the uncompressed data.
+    size_t uncompressedSize_{0};
+    /// Cursor: offset in the compressed body of a token start.
+    size_t cOfs_{0};
+    /// Cursor: uncompressed offset corresponding to cOfs_.
+    size_t uOfs_{0};
+};
+
+#endif // _UTILS_PAIRCOMPRESS_HXX_
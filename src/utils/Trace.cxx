@@ -0,0 +1,565 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Trace.cxx
+ *
+ * Binary trace facility. TRACE() stores a format id and the raw arguments in a
+ * per-thread lock-free ring buffer; the formatting happens later, in a drainer
+ * thread or in the offline decoder tool.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#include "utils/Trace.hxx"
+
+#ifdef TRACE_SUPPORTED
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+bool g_trace_enabled = false;
+
+__thread TraceRing *TraceRing::currentRing_ = nullptr;
+
+/// Protects the registration of formats and rings.
+static os_mutex_t g_trace_mutex = OS_MUTEX_INITIALIZER;
+/// Registered format strings, indexed by format id.
+static const char *g_trace_formats[TRACE_MAX_FORMATS];
+/// Number of valid entries in g_trace_formats.
+static std::atomic<unsigned> g_trace_num_formats{0};
+/// Registered rings, indexed by thread id.
+static TraceRing *g_trace_rings[TRACE_MAX_THREADS];
+/// Number of valid entries in g_trace_rings.
+static std::atomic<unsigned> g_trace_num_rings{0};
+
+uint16_t trace_register_format(const char *fmt)
+{
+    os_mutex_lock(&g_trace_mutex);
+    unsigned id = g_trace_num_formats.load(std::memory_order_relaxed);
+    if (id < TRACE_MAX_FORMATS)
+    {
+        g_trace_formats[id] = fmt;
+        g_trace_num_formats.store(id + 1, std::memory_order_release);
+    }
+    else
+    {
+        id = TRACE_MAX_FORMATS - 1;
+    }
+    os_mutex_unlock(&g_trace_mutex);
+    return id;
+}
+
+const char *trace_format_string(uint16_t id)
+{
+    if (id < g_trace_num_formats.load(std::memory_order_acquire))
+    {
+        return g_trace_formats[id];
+    }
+    return nullptr;
+}
+
+TraceRing *TraceRing::create()
+{
+    TraceRing *ring = nullptr;
+    os_mutex_lock(&g_trace_mutex);
+    unsigned n = g_trace_num_rings.load(std::memory_order_relaxed);
+    if (n < TRACE_MAX_THREADS)
+    {
+        ring = new TraceRing(n);
+        g_trace_rings[n] = ring;
+        g_trace_num_rings.store(n + 1, std::memory_order_release);
+    }
+    os_mutex_unlock(&g_trace_mutex);
+    currentRing_ = ring;
+    return ring;
+}
+
+/// Raw timestamp of the calibration base point.
+static uint64_t g_trace_base_ts = 0;
+/// os_get_time_monotonic() at the calibration base point.
+static long long g_trace_base_nsec = 0;
+/// Nanoseconds per raw timestamp tick.
+static double g_trace_nsec_per_tick = 1.0;
+
+/// Updates the raw timestamp to nanosecond conversion. The first call takes
+/// a short busy measurement, later calls refine the factor over the time
+/// elapsed since the first call.
+static void trace_calibrate()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (!g_trace_base_nsec)
+    {
+        g_trace_base_ts = trace_timestamp();
+        g_trace_base_nsec = os_get_time_monotonic();
+        usleep(2000);
+    }
+    uint64_t ts = trace_timestamp();
+    long long nsec = os_get_time_monotonic();
+    if (ts > g_trace_base_ts)
+    {
+        g_trace_nsec_per_tick =
+            (double)(nsec - g_trace_base_nsec) / (ts - g_trace_base_ts);
+    }
+#endif
+}
+
+long long trace_timestamp_to_nsec(uint64_t ts)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (!g_trace_base_nsec)
+    {
+        trace_calibrate();
+    }
+    return g_trace_base_nsec +
+        (long long)(((int64_t)(ts - g_trace_base_ts)) * g_trace_nsec_per_tick);
+#else
+    return ts;
+#endif
+}
+
+/// Length modifiers of printf conversions.
+enum TraceLengthModifier
+{
+    LEN_NONE,
+    LEN_CHAR,
+    LEN_SHORT,
+    LEN_LONG,
+    LEN_LONG_LONG,
+    LEN_INTMAX,
+    LEN_SIZE,
+    LEN_PTRDIFF,
+    LEN_LONG_DOUBLE,
+};
+
+size_t trace_render(char *buf, size_t len, const char *fmt,
+    const uint64_t *args, unsigned num_args)
+{
+    if (!len)
+    {
+        return 0;
+    }
+    size_t out = 0;
+    unsigned next_arg = 0;
+    const char *p = fmt;
+    while (*p && out + 1 < len)
+    {
+        if (*p != '%')
+        {
+            buf[out++] = *p++;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            buf[out++] = '%';
+            p += 2;
+            continue;
+        }
+        const char *start = p++;
+        while (*p && strchr("-+ #0123456789.", *p))
+        {
+            ++p;
+        }
+        TraceLengthModifier lm = LEN_NONE;
+        switch (*p)
+        {
+            case 'h':
+                lm = p[1] == 'h' ? LEN_CHAR : LEN_SHORT;
+                p += p[1] == 'h' ? 2 : 1;
+                break;
+            case 'l':
+                lm = p[1] == 'l' ? LEN_LONG_LONG : LEN_LONG;
+                p += p[1] == 'l' ? 2 : 1;
+                break;
+            case 'j':
+                lm = LEN_INTMAX;
+                ++p;
+                break;
+            case 'z':
+                lm = LEN_SIZE;
+                ++p;
+                break;
+            case 't':
+                lm = LEN_PTRDIFF;
+                ++p;
+                break;
+            case 'L':
+                lm = LEN_LONG_DOUBLE;
+                ++p;
+                break;
+        }
+        char conv = *p;
+        if (!conv)
+        {
+            break;
+        }
+        ++p;
+        char spec[32];
+        size_t spec_len = std::min((size_t)(p - start), sizeof(spec) - 1);
+        memcpy(spec, start, spec_len);
+        spec[spec_len] = 0;
+        uint64_t v = next_arg < num_args ? args[next_arg++] : 0;
+        char *o = buf + out;
+        size_t rem = len - out;
+        int n = 0;
+        switch (conv)
+        {
+            case 'd':
+            case 'i':
+                switch (lm)
+                {
+                    case LEN_LONG:
+                        n = snprintf(o, rem, spec, (long)v);
+                        break;
+                    case LEN_LONG_LONG:
+                        n = snprintf(o, rem, spec, (long long)v);
+                        break;
+                    case LEN_INTMAX:
+                        n = snprintf(o, rem, spec, (intmax_t)v);
+                        break;
+                    case LEN_SIZE:
+                        n = snprintf(o, rem, spec, (ssize_t)v);
+                        break;
+                    case LEN_PTRDIFF:
+                        n = snprintf(o, rem, spec, (ptrdiff_t)v);
+                        break;
+                    default:
+                        n = snprintf(o, rem, spec, (int)v);
+                        break;
+                }
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                switch (lm)
+                {
+                    case LEN_LONG:
+                        n = snprintf(o, rem, spec, (unsigned long)v);
+                        break;
+                    case LEN_LONG_LONG:
+                        n = snprintf(o, rem, spec, (unsigned long long)v);
+                        break;
+                    case LEN_INTMAX:
+                        n = snprintf(o, rem, spec, (uintmax_t)v);
+                        break;
+                    case LEN_SIZE:
+                        n = snprintf(o, rem, spec, (size_t)v);
+                        break;
+                    case LEN_PTRDIFF:
+                        n = snprintf(o, rem, spec, (ptrdiff_t)v);
+                        break;
+                    default:
+                        n = snprintf(o, rem, spec, (unsigned)v);
+                        break;
+                }
+                break;
+            case 'c':
+                n = snprintf(o, rem, spec, (int)v);
+                break;
+            case 's':
+            case 'p':
+                spec[spec_len - 1] = 'p';
+                n = snprintf(o, rem, spec, (void *)(uintptr_t)v);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+            {
+                double d;
+                memcpy(&d, &v, sizeof(d));
+                if (lm == LEN_LONG_DOUBLE)
+                {
+                    n = snprintf(o, rem, spec, (long double)d);
+                }
+                else
+                {
+                    n = snprintf(o, rem, spec, d);
+                }
+                break;
+            }
+            default:
+                // Unknown conversion: print it as is.
+                n = snprintf(o, rem, "%s", spec);
+                break;
+        }
+        if (n > 0)
+        {
+            out += std::min((size_t)n, rem - 1);
+        }
+    }
+    buf[out] = 0;
+    return out;
+}
+
+size_t trace_render_line(char *buf, size_t len, long long nsec,
+    unsigned thread, const char *fmt, const uint64_t *args,
+    unsigned num_args)
+{
+    HASSERT(len > 32);
+    int n = snprintf(buf, len, "%lld.%06lld t%u: ", nsec / 1000000000LL,
+        (nsec / 1000) % 1000000LL, thread);
+    n += trace_render(buf + n, len - n - 1, fmt, args, num_args);
+    buf[n++] = '\n';
+    buf[n] = 0;
+    return n;
+}
+
+bool trace_decode(const std::string &input, std::string *output)
+{
+    if (input.size() < 8 || input.compare(0, 8, "OMTRACE1") != 0)
+    {
+        return false;
+    }
+    std::vector<std::string> formats;
+    size_t ofs = 8;
+    const char *d = input.data();
+    while (ofs < input.size())
+    {
+        char type = d[ofs];
+        if (type == 'F' && ofs + 5 <= input.size())
+        {
+            uint16_t id, flen;
+            memcpy(&id, d + ofs + 1, 2);
+            memcpy(&flen, d + ofs + 3, 2);
+            ofs += 5;
+            if (ofs + flen > input.size())
+            {
+                return false;
+            }
+            if (formats.size() <= id)
+            {
+                formats.resize(id + 1);
+            }
+            formats[id].assign(d + ofs, flen);
+            ofs += flen;
+        }
+        else if (type == 'R' && ofs + 13 <= input.size())
+        {
+            uint8_t thread = d[ofs + 1];
+            uint8_t num_args = d[ofs + 2];
+            uint16_t id;
+            long long nsec;
+            memcpy(&id, d + ofs + 3, 2);
+            memcpy(&nsec, d + ofs + 5, 8);
+            ofs += 13;
+            if (num_args > TRACE_MAX_ARGS ||
+                ofs + 8 * num_args > input.size())
+            {
+                return false;
+            }
+            uint64_t args[TRACE_MAX_ARGS];
+            memcpy(args, d + ofs, 8 * num_args);
+            ofs += 8 * num_args;
+            const char *fmt = id < formats.size() && !formats[id].empty()
+                ? formats[id].c_str()
+                : "(unknown trace format)";
+            char line[300];
+            size_t n = trace_render_line(
+                line, sizeof(line), nsec, thread, fmt, args, num_args);
+            output->append(line, n);
+        }
+        else if (type == 'D' && ofs + 6 <= input.size())
+        {
+            uint8_t thread = d[ofs + 1];
+            uint32_t count;
+            memcpy(&count, d + ofs + 2, 4);
+            ofs += 6;
+            char line[80];
+            int n = snprintf(line, sizeof(line),
+                "trace: thread %u dropped %u records\n", thread,
+                (unsigned)count);
+            output->append(line, n);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TraceDrainer::TraceDrainer(int fd, bool binary)
+    : fd_(fd)
+    , binary_(binary)
+    , exited_(0)
+{
+    // Only drops that happen from now on are reported.
+    unsigned num_rings = g_trace_num_rings.load(std::memory_order_acquire);
+    for (unsigned i = 0; i < TRACE_MAX_THREADS; ++i)
+    {
+        reportedDrops_[i] = i < num_rings ? g_trace_rings[i]->dropped() : 0;
+    }
+    memset(formatSent_, 0, sizeof(formatSent_));
+    trace_calibrate();
+    if (binary_)
+    {
+        write_all("OMTRACE1", 8);
+    }
+}
+
+TraceDrainer::~TraceDrainer()
+{
+    if (threadStarted_)
+    {
+        exit_ = true;
+        exited_.wait();
+    }
+    drain();
+}
+
+void TraceDrainer::start_thread(unsigned period_msec)
+{
+    HASSERT(!threadStarted_);
+    periodMsec_ = period_msec;
+    threadStarted_ = true;
+    start("trace_drain", 0, 2048);
+}
+
+void *TraceDrainer::entry()
+{
+    while (!exit_)
+    {
+        drain();
+        usleep(periodMsec_ * 1000);
+    }
+    exited_.post();
+    return nullptr;
+}
+
+unsigned TraceDrainer::drain()
+{
+    trace_calibrate();
+    unsigned num_rings = g_trace_num_rings.load(std::memory_order_acquire);
+    // Records of all threads, merged by timestamp.
+    std::vector<std::pair<uint8_t, TraceRecord>> records;
+    for (unsigned i = 0; i < num_rings; ++i)
+    {
+        TraceRing *ring = g_trace_rings[i];
+        TraceRecord r;
+        while (ring->read(&r))
+        {
+            records.emplace_back(i, r);
+        }
+    }
+    std::stable_sort(records.begin(), records.end(),
+        [](const std::pair<uint8_t, TraceRecord> &a,
+            const std::pair<uint8_t, TraceRecord> &b)
+        { return a.second.timestamp < b.second.timestamp; });
+    for (const auto &r : records)
+    {
+        output(r.first, r.second);
+    }
+    for (unsigned i = 0; i < num_rings; ++i)
+    {
+        uint32_t d = g_trace_rings[i]->dropped();
+        if (d == reportedDrops_[i])
+        {
+            continue;
+        }
+        uint32_t count = d - reportedDrops_[i];
+        reportedDrops_[i] = d;
+        if (binary_)
+        {
+            uint8_t hdr[2] = {'D', (uint8_t)i};
+            write_all(hdr, 2);
+            write_all(&count, 4);
+        }
+        else
+        {
+            char line[80];
+            int n = snprintf(line, sizeof(line),
+                "trace: thread %u dropped %u records\n", i, (unsigned)count);
+            write_all(line, n);
+        }
+    }
+    return records.size();
+}
+
+void TraceDrainer::output(unsigned thread, const TraceRecord &r)
+{
+    long long nsec = trace_timestamp_to_nsec(r.timestamp);
+    const char *fmt = trace_format_string(r.formatId);
+    if (!fmt)
+    {
+        fmt = "(unknown trace format)";
+    }
+    if (binary_)
+    {
+        if (!(formatSent_[r.formatId >> 5] & (1u << (r.formatId & 31))))
+        {
+            formatSent_[r.formatId >> 5] |= 1u << (r.formatId & 31);
+            uint16_t flen = strlen(fmt);
+            uint8_t hdr[5];
+            hdr[0] = 'F';
+            memcpy(hdr + 1, &r.formatId, 2);
+            memcpy(hdr + 3, &flen, 2);
+            write_all(hdr, 5);
+            write_all(fmt, flen);
+        }
+        uint8_t rec[13 + 8 * TRACE_MAX_ARGS];
+        rec[0] = 'R';
+        rec[1] = thread;
+        rec[2] = r.numArgs;
+        memcpy(rec + 3, &r.formatId, 2);
+        memcpy(rec + 5, &nsec, 8);
+        memcpy(rec + 13, r.args, 8 * r.numArgs);
+        write_all(rec, 13 + 8 * r.numArgs);
+    }
+    else
+    {
+        char line[300];
+        size_t n = trace_render_line(
+            line, sizeof(line), nsec, thread, fmt, r.args, r.numArgs);
+        write_all(line, n);
+    }
+}
+
+void TraceDrainer::write_all(const void *data, size_t len)
+{
+    const uint8_t *d = static_cast<const uint8_t *>(data);
+    while (len)
+    {
+        ssize_t ret = ::write(fd_, d, len);
+        if (ret <= 0)
+        {
+            return;
+        }
+        d += ret;
+        len -= ret;
+    }
+}
+
+#endif // TRACE_SUPPORTED
@@ -0,0 +1,363 @@
+/** \copyright
+ * Copyright (c) 2026, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file Trace.hxx
+ *
+ * Binary trace facility. TRACE() stores a format id and the raw arguments in a
+ * per-thread lock-free ring buffer; the formatting happens later, in a drainer
+ * thread or in the offline decoder tool.
+ *
+ * @author agent
+ * @date 19 Oct 2026
+ */
+
+#ifndef _UTILS_TRACE_HXX_
+#define _UTILS_TRACE_HXX_
+
+#if defined(__linux__) || defined(__MACH__)
+/// Defined when the binary trace facility is available. It needs thread-local
+/// storage, so it is only compiled on hosted platforms; elsewhere TRACE()
+/// compiles to nothing.
+#define TRACE_SUPPORTED
+#endif
+
+#ifdef TRACE_SUPPORTED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+#include "os/OS.hxx"
+#include "utils/macros.h"
+
+/// Maximum number of arguments of a TRACE() call.
+static const unsigned TRACE_MAX_ARGS = 4;
+/// Maximum number of distinct TRACE() format strings.
+static const unsigned TRACE_MAX_FORMATS = 1024;
+/// Maximum number of threads that can write traces.
+static const unsigned TRACE_MAX_THREADS = 64;
+/// Number of records in each per-thread ring. Must be a power of two.
+static const unsigned TRACE_RING_SIZE = 1024;
+
+/// One entry in a trace ring.
+struct TraceRecord
+{
+    /// Raw timestamp (CPU cycles on x86, nanoseconds elsewhere).
+    uint64_t timestamp;
+    /// Identifies the format string, see trace_register_format().
+    uint16_t formatId;
+    /// How many entries of args are valid.
+    uint8_t numArgs;
+    /// Arguments, integers sign- or zero-extended, floating point values as
+    /// the bits of a double, pointers as integers.
+    uint64_t args[TRACE_MAX_ARGS];
+};
+
+/// Single-producer single-consumer ring of trace records. The producer is the
+/// thread owning the ring, the consumer is the drainer.
+class TraceRing
+{
+public:
+    /// @param thread_id is the index of this ring in the global registry.
+    TraceRing(unsigned thread_id)
+        : threadId_(thread_id)
+    {
+    }
+
+    /// Appends a record. Drops the record if the ring is full. Called only
+    /// by the owning thread.
+    /// @param ts is the raw timestamp.
+    /// @param id is the format id.
+    /// @param args are the arguments.
+    /// @param num_args is the number of arguments.
+    void write(uint64_t ts, uint16_t id, const uint64_t *args,
+        unsigned num_args)
+    {
+        uint32_t h = head_.load(std::memory_order_relaxed);
+        if (h - tail_.load(std::memory_order_acquire) >= TRACE_RING_SIZE)
+        {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+            return;
+        }
+        TraceRecord *r = &records_[h & (TRACE_RING_SIZE - 1)];
+        r->timestamp = ts;
+        r->formatId = id;
+        r->numArgs = num_args;
+        memcpy(r->args, args, num_args * sizeof(uint64_t));
+        head_.store(h + 1, std::memory_order_release);
+    }
+
+    /// Takes the oldest record out of the ring. Called only by the drainer.
+    /// @param out will be filled with the record.
+    /// @return false if the ring was empty.
+    bool read(TraceRecord *out)
+    {
+        uint32_t t = tail_.load(std::memory_order_relaxed);
+        if (t == head_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        *out = records_[t & (TRACE_RING_SIZE - 1)];
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @return the total number of records dropped because the ring was full.
+    uint32_t dropped()
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    /// @return the index of this ring in the registry.
+    unsigned thread_id()
+    {
+        return threadId_;
+    }
+
+    /// @return the ring of the calling thread, creating it on first use.
+    /// Returns nullptr if there are too many threads.
+    static TraceRing *current()
+    {
+        return currentRing_ ? currentRing_ : create();
+    }
+
+private:
+    /// Allocates and registers the ring of the calling thread.
+    static TraceRing *create();
+
+    /// The calling thread's ring.
+    static __thread TraceRing *currentRing_;
+
+    /// Next record to write. Written only by the owning thread.
+    std::atomic<uint32_t> head_{0};
+    /// Next record to read. Written only by the drainer.
+    std::atomic<uint32_t> tail_{0};
+    /// Number of records dropped. Written only by the owning thread.
+    std::atomic<uint32_t> dropped_{0};
+    /// Index of this ring in the registry.
+    unsigned threadId_;
+    /// Record storage.
+    TraceRecord records_[TRACE_RING_SIZE];
+};
+
+/// Set to true to start recording traces. Meant to be set at startup.
+extern bool g_trace_enabled;
+
+/// Registers a format string. Called once per TRACE() call site.
+/// @param fmt is the printf-style format string; must stay alive forever
+/// (normally it is a string literal).
+/// @return the format id. When the format table is full, all further formats
+/// share the last id.
+uint16_t trace_register_format(const char *fmt);
+
+/// @param id is a format id. @return the format string, or nullptr if the id
+/// is not registered.
+const char *trace_format_string(uint16_t id);
+
+/// @return a raw timestamp for a trace record.
+inline uint64_t trace_timestamp()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return os_get_time_monotonic();
+#endif
+}
+
+/// Converts a raw timestamp to nanoseconds on the os_get_time_monotonic()
+/// time base. The conversion factor is re-calibrated on every call.
+/// @param ts is the raw timestamp.
+/// @return nanoseconds.
+long long trace_timestamp_to_nsec(uint64_t ts);
+
+/// Renders a trace record into text. Supports the integer, character,
+/// pointer and floating point conversions of printf. %s prints the pointer
+/// value, since the string might not be around anymore when the record is
+/// rendered.
+/// @param buf is the output buffer.
+/// @param len is the size of buf; the output is always null-terminated.
+/// @param fmt is the format string.
+/// @param args are the arguments of the record.
+/// @param num_args is the number of arguments.
+/// @return the number of characters written, without the terminating null.
+size_t trace_render(char *buf, size_t len, const char *fmt,
+    const uint64_t *args, unsigned num_args);
+
+/// Renders a trace record as a text line: seconds.microseconds, thread id
+/// and the message, terminated by a newline.
+/// @param buf is the output buffer (at least 33 bytes).
+/// @param len is the size of buf.
+/// @param nsec is the timestamp.
+/// @param thread is the ring index the record came from.
+/// @param fmt is the format string.
+/// @param args are the arguments of the record.
+/// @param num_args is the number of arguments.
+/// @return the number of characters written, without the terminating null.
+size_t trace_render_line(char *buf, size_t len, long long nsec,
+    unsigned thread, const char *fmt, const uint64_t *args,
+    unsigned num_args);
+
+/// Decodes the binary output of a TraceDrainer into text lines.
+/// @param input is the content of the binary trace.
+/// @param output will get the text appended.
+/// @return false if the input is not a valid binary trace. The lines decoded
+/// before the error are still appended.
+bool trace_decode(const std::string &input, std::string *output);
+
+/// Captures an integer or enum argument.
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value ||
+        std::is_enum<T>::value,
+    uint64_t>::type
+trace_arg(T v)
+{
+    return (uint64_t)(int64_t)v;
+}
+
+/// Captures a floating point argument.
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value,
+    uint64_t>::type
+trace_arg(T v)
+{
+    double d = v;
+    uint64_t ret;
+    memcpy(&ret, &d, sizeof(ret));
+    return ret;
+}
+
+/// Captures a pointer argument.
+inline uint64_t trace_arg(const void *v)
+{
+    return (uintptr_t)v;
+}
+
+/// Appends a record to the calling thread's ring.
+/// @param id is the format id.
+/// @param args are the arguments.
+template <typename... Args> inline void trace_write(uint16_t id, Args... args)
+{
+    static_assert(sizeof...(Args) <= TRACE_MAX_ARGS, "Too many TRACE args.");
+    uint64_t a[sizeof...(Args) + 1] = {trace_arg(args)..., 0};
+    TraceRing *ring = TraceRing::current();
+    if (ring)
+    {
+        ring->write(trace_timestamp(), id, a, sizeof...(Args));
+    }
+}
+
+/// Moves the records out of the trace rings and writes them to a file
+/// descriptor, either as text lines or in the binary format read by the
+/// trace_decoder application.
+///
+/// Binary format (host byte order): the 8-byte magic "OMTRACE1", followed
+/// by entries, each starting with a type byte:
+///  - 'F' u16 id, u16 length, the format string (sent before the first
+///    record using it);
+///  - 'R' u8 thread, u8 number of args, u16 format id, s64 nsec timestamp,
+///    the args as u64 each;
+///  - 'D' u8 thread, u32 number of records dropped since the last 'D'.
+class TraceDrainer : private OSThread
+{
+public:
+    /// @param fd is where to write the output.
+    /// @param binary selects the binary format instead of text.
+    TraceDrainer(int fd, bool binary);
+
+    /// Stops the background thread (if any) and drains the remaining
+    /// records.
+    ~TraceDrainer();
+
+    /// Starts a background thread draining the rings.
+    /// @param period_msec is how often to drain.
+    void start_thread(unsigned period_msec);
+
+    /// Drains all records that are in the rings now. Must not be called
+    /// concurrently with the background thread.
+    /// @return the number of records written.
+    unsigned drain();
+
+private:
+    void *entry() override;
+
+    /// Writes out a record.
+    /// @param thread is the ring index.
+    /// @param r is the record.
+    void output(unsigned thread, const TraceRecord &r);
+
+    /// Writes data to the output, retrying partial writes.
+    /// @param data is what to write. @param len is how many bytes.
+    void write_all(const void *data, size_t len);
+
+    /// Output file descriptor.
+    int fd_;
+    /// True for binary output.
+    bool binary_;
+    /// Set to true to stop the background thread.
+    std::atomic<bool> exit_{false};
+    /// True if the background thread was started.
+    bool threadStarted_{false};
+    /// Drain period of the background thread.
+    unsigned periodMsec_{10};
+    /// Posted by the background thread when it exits.
+    OSSem exited_;
+    /// Dropped count already reported per ring.
+    uint32_t reportedDrops_[TRACE_MAX_THREADS];
+    /// One bit per format id that was already sent (binary mode).
+    uint32_t formatSent_[TRACE_MAX_FORMATS / 32];
+};
+
+/// Records a trace entry when tracing is enabled. Costs a few nanoseconds: the
+/// arguments are stored raw and formatted later by a TraceDrainer or by the
+/// trace_decoder tool.
+/// @param fmt is a printf format string literal.
+/// @param args are at most TRACE_MAX_ARGS integer, floating point or pointer
+/// arguments.
+#define TRACE(fmt, args...)                                                    \
+    do                                                                         \
+    {                                                                          \
+        if (g_trace_enabled)                                                   \
+        {                                                                      \
+            static const uint16_t _trace_id = trace_register_format(fmt);      \
+            trace_write(_trace_id, ##args);                                    \
+        }                                                                      \
+    } while (0)
+
+#else // TRACE_SUPPORTED
+
+#define TRACE(fmt, args...)                                                    \
+    do                                                                         \
+    {                                                                          \
+    } while (0)
+
+#endif // TRACE_SUPPORTED
+
+#endif // _UTILS_TRACE_HXX_
@@ -150,3 +150,4 @@ DEFAULT_CONST(gridconnect_port_max_incoming_packets, 6);
 DEFAULT_CONST(gridconnect_bridge_max_incoming_packets, 1);
 
 DEFAULT_CONST_FALSE(gridconnect_tcp_use_select);
+DEFAULT_CONST_FALSE(gridconnect_tcp_accept_binary);